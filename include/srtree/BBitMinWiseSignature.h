@@ -0,0 +1,156 @@
+#pragma once
+
+#include <srtree/MinWiseSignature.h>
+
+namespace srtree {
+
+///b-bit minwise signature (Li, König 2010)
+///Only the lowest T_BITS bits of each entry of a MinWiseSignature are stored together with
+///the number of elements of the set or an upper bound of it, see cardinalityBound(). The entries are packed into 64 bit words.
+///Entries of different sets collide with probability of about 2^-T_BITS, see collisionProbability().
+///In contrast to MinWiseSignature there is no combination since the minimum of two entries can not be recovered.
+template<std::size_t T_SIZE, std::size_t T_BITS>
+class BBitMinWiseSignature {
+public:
+	static constexpr std::size_t size = T_SIZE;
+	static constexpr std::size_t bits = T_BITS;
+	static_assert(bits == 1 || bits == 2 || bits == 4 || bits == 8, "BBitMinWiseSignature supports 1, 2, 4 and 8 bits");
+	///Number of bytes of the serialized entries
+	static constexpr std::size_t storage_size = (size*bits+7)/8;
+	///Number of standard errors added to an estimated cardinality by cardinalityBound()
+	static constexpr double cardinality_errors = 6;
+public:
+	using size_type = std::size_t;
+	using entry_type = uint8_t;
+	using cardinality_type = uint32_t;
+	using self = BBitMinWiseSignature<size, bits>;
+private:
+	static constexpr std::size_t entries_per_word = 64/bits;
+	static constexpr std::size_t word_count = (size+entries_per_word-1)/entries_per_word;
+	static constexpr uint64_t entry_mask = (uint64_t(1) << bits)-1;
+public:
+	BBitMinWiseSignature() {
+		m_w.fill(0);
+	}
+	BBitMinWiseSignature(sserialize::UByteArrayAdapter d) {
+		m_w.fill(0);
+		for(std::size_t i(0); i < storage_size; ++i) {
+			uint8_t byte;
+			d >> byte;
+			m_w[i/8] |= uint64_t(byte) << (8*(i%8));
+		}
+		d >> m_card;
+	}
+	///@param cardinality the number of elements of the set of @param sig or an upper bound of it
+	template<std::size_t V>
+	BBitMinWiseSignature(MinWiseSignature<size, V> const & sig, double cardinality) :
+	m_card(cardinality < std::numeric_limits<cardinality_type>::max() ? cardinality_type(std::round(cardinality)) : std::numeric_limits<cardinality_type>::max())
+	{
+		m_w.fill(0);
+		for(std::size_t i(0); i < size; ++i) {
+			m_w[i/entries_per_word] |= (uint64_t(sig.at(i)) & entry_mask) << (bits*(i%entries_per_word));
+		}
+	}
+	~BBitMinWiseSignature() {}
+public:
+	///Probability that the entries of two different minima are equal
+	static constexpr double collisionProbability() { return 1.0/(uint64_t(1) << bits); }
+	///Upper bound of the number of elements of a set given the @param estimate of its MinWiseSignature
+	///The relative standard error of the estimate is about 1/sqrt(size-2), the bound adds cardinality_errors of them.
+	///With 56 entries the number of elements exceeds the bound with a probability below 10^-6.
+	static double cardinalityBound(double estimate) {
+		if (size < 3) {
+			return std::numeric_limits<double>::max();
+		}
+		return estimate * (1.0 + cardinality_errors/std::sqrt(double(size-2)));
+	}
+public:
+	entry_type at(size_type i) const {
+		if (i >= size) {
+			throw std::out_of_range("BBitMinWiseSignature::at");
+		}
+		return entry_type( (m_w[i/entries_per_word] >> (bits*(i%entries_per_word))) & entry_mask );
+	}
+	///Number of elements of the set or an upper bound of it
+	cardinality_type cardinality() const { return m_card; }
+	///Number of equal entries including accidental collisions
+	size_type operator/(self const & other) const {
+		//Fold each entry of the difference into its lowest bit, unused bits of the last word are equal
+		uint64_t lsb = 0;
+		for(std::size_t i(0); i < entries_per_word; ++i) {
+			lsb |= uint64_t(1) << (bits*i);
+		}
+		size_type unequal = 0;
+		for(std::size_t i(0); i < word_count; ++i) {
+			uint64_t x = m_w[i] ^ other.m_w[i];
+			for(std::size_t shift(1); shift < bits; shift *= 2) {
+				x |= x >> shift;
+			}
+			unequal += __builtin_popcountll(x & lsb);
+		}
+		return size - unequal;
+	}
+	bool operator==(self const & other) const {
+		return m_w == other.m_w && m_card == other.m_card;
+	}
+	bool operator!=(self const & other) const {
+		return !(*this == other);
+	}
+private:
+	template<std::size_t U, std::size_t V>
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, BBitMinWiseSignature<U, V> const & sig);
+private:
+	std::array<uint64_t, word_count> m_w;
+	cardinality_type m_card{0};
+};
+
+///True if the entries of @param first truncated to T_BITS bits are the entries of @param second, the cardinality is ignored
+template<std::size_t T_SIZE, std::size_t T_ENTRY_BITS, std::size_t T_BITS>
+bool operator==(MinWiseSignature<T_SIZE, T_ENTRY_BITS> const & first, BBitMinWiseSignature<T_SIZE, T_BITS> const & second) {
+	for(std::size_t i(0); i < T_SIZE; ++i) {
+		if (uint8_t(first.at(i) & ((uint64_t(1) << T_BITS)-1)) != second.at(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template<std::size_t T_SIZE, std::size_t T_ENTRY_BITS, std::size_t T_BITS>
+bool operator!=(MinWiseSignature<T_SIZE, T_ENTRY_BITS> const & first, BBitMinWiseSignature<T_SIZE, T_BITS> const & second) {
+	return !(first == second);
+}
+
+template<std::size_t T_SIZE, std::size_t T_BITS>
+std::ostream & operator<<(std::ostream & out, BBitMinWiseSignature<T_SIZE, T_BITS> const & sig) {
+	out << "BBitMinWiseSignature<" << T_SIZE << ", " << T_BITS << ">(" << sig.cardinality() << "; ";
+	for(std::size_t i(0); i < T_SIZE; ++i) {
+		out << (i ? ", " : "") << uint32_t(sig.at(i));
+	}
+	return out << ')';
+}
+
+template<std::size_t U, std::size_t V>
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, BBitMinWiseSignature<U, V> const & sig) {
+	for(std::size_t i(0); i < BBitMinWiseSignature<U, V>::storage_size; ++i) {
+		dest << uint8_t(sig.m_w[i/8] >> (8*(i%8)));
+	}
+	return dest << sig.m_card;
+}
+
+}//end namespace srtree
+
+namespace sserialize {
+
+template<std::size_t T_SIZE, std::size_t T_BITS>
+struct SerializationInfo< srtree::BBitMinWiseSignature<T_SIZE, T_BITS> > {
+	using value_type = srtree::BBitMinWiseSignature<T_SIZE, T_BITS>;
+	static constexpr bool is_fixed_length = true;
+	static constexpr OffsetType length = value_type::storage_size + SerializationInfo<typename value_type::cardinality_type>::length;
+	static constexpr OffsetType max_length = length;
+	static constexpr OffsetType min_length = length;
+	static constexpr OffsetType sizeInBytes(const value_type &) {
+		return length;
+	}
+};
+
+} //end namespace sserialize
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <srtree/BBitMinWiseSignature.h>
+#include <srtree/Static/BBitDeserializationTraitsAdapter.h>
+
+namespace srtree::detail {
+
+///Stores only the lowest T_BITS bits of each signature entry of a MinWiseSignatureTraits
+///The tree is built with the full signatures, only the serialized signatures are BBitMinWiseSignature.
+///Together with an upper bound of the set size they need (SignatureSize*T_BITS+7)/8+4 bytes.
+template<typename T_BASE_TRAIT, std::size_t T_BITS>
+class BBitSerializationTraitsAdapter: public T_BASE_TRAIT {
+public:
+	using Parent = T_BASE_TRAIT;
+	static constexpr std::size_t Bits = T_BITS;
+	using Signature = typename Parent::Signature;
+	using StaticTraits = srtree::detail::BBitDeserializationTraitsAdapter<typename T_BASE_TRAIT::StaticTraits, T_BITS>;
+public:
+	class Serializer {
+	public:
+		using Type = typename StaticTraits::Signature;
+	public:
+		Serializer(BBitSerializationTraitsAdapter const * that) : m_that(that) {}
+		Serializer(Serializer const & ) = default;
+	public:
+		inline sserialize::UByteArrayAdapter & operator()(sserialize::UByteArrayAdapter & dest, Signature const & v) const {
+			return dest << Type(v, Type::cardinalityBound(m_that->sg().cardinality(v)));
+		}
+	private:
+		BBitSerializationTraitsAdapter const * m_that;
+	};
+public:
+	template<typename... T_ARGS>
+	BBitSerializationTraitsAdapter(T_ARGS... args) :
+	Parent(std::forward<T_ARGS>(args)...)
+	{}
+	BBitSerializationTraitsAdapter(BBitSerializationTraitsAdapter && other) = default;
+	~BBitSerializationTraitsAdapter() override {}
+	BBitSerializationTraitsAdapter & operator=(BBitSerializationTraitsAdapter &&) = default;
+public:
+	inline Serializer serializer() const { return Serializer(this); }
+};
+
+template<typename U, std::size_t V>
+inline
+sserialize::UByteArrayAdapter &
+operator<<(sserialize::UByteArrayAdapter & dest, BBitSerializationTraitsAdapter<U, V> const & v) {
+	return dest << uint8_t(1) << static_cast<typename BBitSerializationTraitsAdapter<U, V>::Parent const &>(v) << uint8_t(V);
+}
+
+}//end namespace srtree::detail
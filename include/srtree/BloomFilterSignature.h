@@ -0,0 +1,149 @@
+#pragma once
+
+#include <sserialize/storage/UByteArrayAdapter.h>
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace srtree {
+
+///Blocked Bloom filter (Putze, Sanders, Singler 2007) of T_BITS bits
+///Every element sets its bits in a single block of 256 bits, hence testing an element touches one block.
+///With AVX2 (i.e. -mavx2 or -march=native) the test of a block is a single vptest of the block and the mask.
+///The filter of a union is the bitwise or of the filters, an element of one of the sets is never reported missing.
+template<std::size_t T_BITS>
+class BloomFilterSignature {
+public:
+	static constexpr std::size_t bits = T_BITS;
+	static constexpr std::size_t block_bits = 256;
+	static constexpr std::size_t block_words = block_bits/64;
+	static constexpr std::size_t block_count = bits/block_bits;
+	static constexpr std::size_t word_count = bits/64;
+	static_assert(bits > 0 && bits % block_bits == 0, "BloomFilterSignature needs a multiple of 256 bits");
+public:
+	using size_type = std::size_t;
+	using self = BloomFilterSignature<bits>;
+	///The bits of an element within its block
+	struct alignas(32) BlockMask {
+		uint64_t w[block_words];
+	};
+public:
+	BloomFilterSignature() {
+		m_w.fill(0);
+	}
+	BloomFilterSignature(sserialize::UByteArrayAdapter d) {
+		for(uint64_t & x : m_w) {
+			d >> x;
+		}
+	}
+	~BloomFilterSignature() {}
+public:
+	uint64_t const * data() const { return m_w.data(); }
+	uint64_t at(size_type i) const { return m_w.at(i); }
+	///Number of set bits
+	size_type popcount() const {
+		size_type result = 0;
+		for(uint64_t x : m_w) {
+			result += __builtin_popcountll(x);
+		}
+		return result;
+	}
+	void insert(size_type block, BlockMask const & mask) {
+		for(size_type i(0); i < block_words; ++i) {
+			m_w[block*block_words+i] |= mask.w[i];
+		}
+	}
+	///True if all bits of @param mask are set in @param block
+	inline bool contains(size_type block, BlockMask const & mask) const {
+	#if defined(__AVX2__)
+		uint64_t const * b = m_w.data() + block*block_words;
+		__m256i vb = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b));
+		__m256i vm = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(mask.w));
+		return _mm256_testc_si256(vb, vm);
+	#else
+		return containsScalar(block, mask);
+	#endif
+	}
+	///Same as contains() without SIMD instructions
+	inline bool containsScalar(size_type block, BlockMask const & mask) const {
+		uint64_t const * b = m_w.data() + block*block_words;
+		uint64_t missing = 0;
+		for(size_type i(0); i < block_words; ++i) {
+			missing |= mask.w[i] & ~b[i];
+		}
+		return !missing;
+	}
+	self operator+(self const & other) const {
+		self result(*this);
+		result += other;
+		return result;
+	}
+	self & operator+=(self const & other) {
+		for(size_type i(0); i < word_count; ++i) {
+			m_w[i] |= other.m_w[i];
+		}
+		return *this;
+	}
+	///Number of bits set in both filters
+	size_type operator/(self const & other) const {
+		size_type result = 0;
+		for(size_type i(0); i < word_count; ++i) {
+			result += __builtin_popcountll(m_w[i] & other.m_w[i]);
+		}
+		return result;
+	}
+	///Combination of all signatures in [begin, end) in a single pass
+	///@param begin has to dereference to a BloomFilterSignature
+	template<typename T_ITERATOR>
+	static self combine(T_ITERATOR begin, T_ITERATOR end) {
+		self result;
+		for(; begin != end; ++begin) {
+			result += *begin;
+		}
+		return result;
+	}
+	bool operator==(self const & other) const {
+		return m_w == other.m_w;
+	}
+	bool operator!=(self const & other) const {
+		return m_w != other.m_w;
+	}
+private:
+	alignas(32) std::array<uint64_t, word_count> m_w;
+};
+
+template<std::size_t T_BITS>
+std::ostream & operator<<(std::ostream & out, BloomFilterSignature<T_BITS> const & sig) {
+	return out << "BloomFilterSignature<" << T_BITS << ">(" << sig.popcount() << " bits set)";
+}
+
+template<std::size_t T_BITS>
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, BloomFilterSignature<T_BITS> const & sig) {
+	for(std::size_t i(0); i < BloomFilterSignature<T_BITS>::word_count; ++i) {
+		dest << sig.at(i);
+	}
+	return dest;
+}
+
+}//end namespace srtree
+
+namespace sserialize {
+
+template<std::size_t T_BITS>
+struct SerializationInfo< srtree::BloomFilterSignature<T_BITS> > {
+	using value_type = srtree::BloomFilterSignature<T_BITS>;
+	static constexpr bool is_fixed_length = true;
+	static constexpr OffsetType length = value_type::word_count*SerializationInfo<uint64_t>::length;
+	static constexpr OffsetType max_length = length;
+	static constexpr OffsetType min_length = length;
+	static constexpr OffsetType sizeInBytes(const value_type & value) {
+		return length;
+	}
+};
+
+} //end namespace sserialize
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <srtree/BloomFilterSignature.h>
+#include <srtree/MinWiseSignature.h>
+#include <srtree/QGram.h>
+#include <srtree/PredicateProgram.h>
+
+#include <sserialize/storage/UByteArrayAdapter.h>
+
+#include <vector>
+#include <algorithm>
+
+
+namespace srtree::detail {
+
+///Signature traits based on Bloom filters of the q-grams of the strings
+///The QGramFingerprints of a string are hashed by a single hash function that selects the block and the hashCount() bits of a q-gram.
+///Signatures are combined by bitwise or. MayHaveMatch counts the q-grams of the query that are in a filter and compares it
+///with the bound of the q-gram lemma that ROPQGramDB::nomatch uses. Since a filter contains all q-grams of its strings
+///the count is never smaller than the number of shared q-grams, hence pruning never drops a true match.
+///The size of the filters is fixed per tree by T_BITS, the Static::SRTree needs signatures of a fixed size.
+template<std::size_t T_BITS, typename T_PARAMETRISED_HASH_FUNCTION = MinWisePermutation::XXHash64>
+class BloomFilterSignatureTraits {
+public:
+	using StaticTraits = BloomFilterSignatureTraits<T_BITS, T_PARAMETRISED_HASH_FUNCTION>;
+public:
+	static constexpr std::size_t Bits = T_BITS;
+	static constexpr uint8_t DefaultHashCount = 4;
+	static constexpr uint8_t MaxHashCount = 8;
+	using HashFunction = T_PARAMETRISED_HASH_FUNCTION;
+	using Signature = BloomFilterSignature<Bits>;
+	using BlockMask = typename Signature::BlockMask;
+	using QType = uint8_t;
+
+	class Serializer {
+	public:
+		using Type = Signature;
+	public:
+		inline sserialize::UByteArrayAdapter & operator()(sserialize::UByteArrayAdapter & dest, Signature const & sig) const {
+			return dest << sig;
+		}
+	};
+
+	class Deserializer {
+	public:
+		using Type = Signature;
+	public:
+		Signature operator()(Type v) const {
+			return v;
+		}
+	};
+
+	struct Combine {
+		Signature operator()(Signature const & first, Signature const & second) const {
+			return first + second;
+		}
+
+		template<typename Iterator>
+		Signature operator()(Iterator begin, Iterator end) const {
+			return Signature::combine(begin, end);
+		}
+	};
+
+	///Fraction of the bits of the union of @param base and @param toAdd that are not set in @param base
+	struct Enlargement {
+		double operator()(Signature const & base, Signature const & toAdd) const {
+			std::size_t u = (base + toAdd).popcount();
+			return u ? double(u - base.popcount())/u : 0.0;
+		}
+	};
+
+	class MayHaveMatch final {
+	public:
+		MayHaveMatch(MayHaveMatch const &) = default;
+		MayHaveMatch(MayHaveMatch &&) = default;
+		MayHaveMatch & operator=(MayHaveMatch const&) = default;
+		MayHaveMatch & operator=(MayHaveMatch &&) = default;
+		~MayHaveMatch() {}
+	public:
+		bool operator()(Signature const & ns) const;
+		MayHaveMatch operator/(MayHaveMatch const & other) const;
+		MayHaveMatch operator+(MayHaveMatch const & other) const;
+	private:
+		class LeafNode {
+		public:
+			LeafNode(BloomFilterSignatureTraits const & traits, QGram const & qg, std::size_t editDistance);
+		public:
+			bool matches(Signature const & v) const;
+		private:
+			///A distinct q-gram of the reference and its number of occurrences
+			struct Probe {
+				BlockMask mask;
+				uint32_t block;
+				uint32_t count;
+			};
+		private:
+			//sorted by decreasing count
+			std::vector<Probe> m_probes;
+			int32_t m_th;
+			//number of q-grams of the reference
+			int64_t m_n;
+		};
+		using Program = PredicateProgram<LeafNode>;
+	private:
+		friend class BloomFilterSignatureTraits;
+	private:
+		MayHaveMatch(BloomFilterSignatureTraits const & traits, QGram const & qg, std::size_t editDistance);
+		MayHaveMatch(Program && p);
+	private:
+		Program m_p;
+	};
+
+public:
+	BloomFilterSignatureTraits() : BloomFilterSignatureTraits(3) {}
+	BloomFilterSignatureTraits(sserialize::UByteArrayAdapter d) {
+		d >> *this;
+	}
+	BloomFilterSignatureTraits(std::size_t q) : BloomFilterSignatureTraits(q, 2) {}
+	///@param hashCount the number of bits of a q-gram in [1, MaxHashCount]
+	BloomFilterSignatureTraits(std::size_t q, std::size_t hashSize, std::size_t hashCount = DefaultHashCount) :
+	m_q(q),
+	m_k(hashCount)
+	{
+		if (q < 1 || q > QGramFingerprints::MaxQ) {
+			throw sserialize::PreconditionViolationException("BloomFilterSignatureTraits: q has to be in [1, 255]");
+		}
+		if (hashCount < 1 || hashCount > MaxHashCount) {
+			throw sserialize::PreconditionViolationException("BloomFilterSignatureTraits: the hash count has to be in [1, 8]");
+		}
+		CryptoPP::AutoSeededRandomPool rng;
+		m_hash.emplace_back(rng, hashSize);
+	}
+	BloomFilterSignatureTraits(BloomFilterSignatureTraits && other) = default;
+	virtual ~BloomFilterSignatureTraits() {}
+	BloomFilterSignatureTraits & operator=(BloomFilterSignatureTraits && other) = default;
+	QType q() const { return m_q; }
+	///Number of bits set per q-gram
+	uint8_t hashCount() const { return m_k; }
+	HashFunction const & hash() const { return m_hash.front(); }
+	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const {
+		sserialize::UByteArrayAdapter tmp(sserialize::MM_PROGRAM_MEMORY);
+		tmp << *this;
+		return tmp.size();
+	}
+	///Block and bits of the q-gram with fingerprint @param fp
+	inline std::pair<uint32_t, BlockMask> position(QGramFingerprints::value_type fp) const {
+		uint64_t h = hash()(typename HashFunction::size_type(fp));
+		uint32_t block = uint32_t( (uint64_t(uint32_t(h >> 32)) * Signature::block_count) >> 32 );
+		//splitmix64 finalizer, each of its bytes selects a bit of the block
+		uint64_t g = h;
+		g = (g ^ (g >> 30)) * 0xBF58476D1CE4E5B9ull;
+		g = (g ^ (g >> 27)) * 0x94D049BB133111EBull;
+		g ^= g >> 31;
+		BlockMask mask{};
+		for(uint8_t i(0); i < m_k; ++i, g >>= 8) {
+			mask.w[(g & 0xFF)/64] |= uint64_t(1) << (g & 0x3F);
+		}
+		return std::make_pair(block, mask);
+	}
+public:
+	Combine combine() const { return Combine(); }
+	Enlargement enlargement() const { return Enlargement(); }
+	MayHaveMatch mayHaveMatch(std::string const & str, std::size_t editDistance) const {
+		QGram qg(str, m_q);
+		return MayHaveMatch(*this, qg, editDistance);
+	}
+	Serializer serializer() const { return Serializer(); }
+	Deserializer deserializer() const { return Deserializer(); }
+public:
+	Signature signature(std::string const & str) const {
+		if (!str.size()) {
+			throw sserialize::PreconditionViolationException("Empty string is not allowed!");
+		}
+		Signature sig;
+		QGramFingerprints qf(str, m_q);
+		for(auto fp : qf) {
+			auto p = position(fp);
+			sig.insert(p.first, p.second);
+		}
+		return sig;
+	}
+	template<typename T_STRING_ITERATOR>
+	Signature signature(T_STRING_ITERATOR begin, T_STRING_ITERATOR end) const {
+		if (begin == end) {
+			throw sserialize::PreconditionViolationException("Empty string sets are not allowed!");
+		}
+		Signature sig = signature(*begin);
+		for(++begin; begin != end; ++begin) {
+			sig += signature(*begin);
+		}
+		return sig;
+	}
+private:
+	template<std::size_t U, typename V>
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, srtree::detail::BloomFilterSignatureTraits<U, V> const & v);
+
+	template<std::size_t U, typename V>
+	friend sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, srtree::detail::BloomFilterSignatureTraits<U, V> & v);
+private:
+	QType m_q; //the q in q-grams
+	uint8_t m_k;
+	std::vector<HashFunction> m_hash;
+};
+
+template<std::size_t T_BITS, typename T_PARAMETRISED_HASH_FUNCTION>
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, srtree::detail::BloomFilterSignatureTraits<T_BITS, T_PARAMETRISED_HASH_FUNCTION> const & v) {
+	return dest << v.m_q << v.m_k << uint32_t(T_BITS) << v.m_hash;
+}
+
+template<std::size_t T_BITS, typename T_PARAMETRISED_HASH_FUNCTION>
+sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, srtree::detail::BloomFilterSignatureTraits<T_BITS, T_PARAMETRISED_HASH_FUNCTION> & v) {
+	uint32_t bits;
+	dest >> v.m_q >> v.m_k >> bits;
+	if (bits != T_BITS) {
+		throw sserialize::TypeMissMatchException("BloomFilterSignatureTraits: filters have " + std::to_string(bits) + " bits instead of " + std::to_string(T_BITS));
+	}
+	return dest >> v.m_hash;
+}
+
+}//end namespace srtree::detail
+
+
+//implementation
+namespace srtree::detail {
+
+#define BFSIGTRAITS_TML_HDR template<std::size_t T_BITS, typename T_PARAMETRISED_HASH_FUNCTION>
+#define BFSIGTRAITS_CLS BloomFilterSignatureTraits<T_BITS, T_PARAMETRISED_HASH_FUNCTION>
+
+BFSIGTRAITS_TML_HDR
+BFSIGTRAITS_CLS::MayHaveMatch::MayHaveMatch(BloomFilterSignatureTraits const & traits, QGram const & qg, std::size_t editDistance) :
+m_p( LeafNode(traits, qg, editDistance) )
+{}
+
+BFSIGTRAITS_TML_HDR
+BFSIGTRAITS_CLS::MayHaveMatch::MayHaveMatch(Program && p) :
+m_p(std::move(p))
+{}
+
+BFSIGTRAITS_TML_HDR
+bool
+BFSIGTRAITS_CLS::MayHaveMatch::operator()(Signature const & ns) const {
+	return m_p([&ns](LeafNode const & leaf) { return leaf.matches(ns); });
+}
+
+BFSIGTRAITS_TML_HDR
+typename BFSIGTRAITS_CLS::MayHaveMatch
+BFSIGTRAITS_CLS::MayHaveMatch::operator/(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p / other.m_p);
+}
+
+BFSIGTRAITS_TML_HDR
+typename BFSIGTRAITS_CLS::MayHaveMatch
+BFSIGTRAITS_CLS::MayHaveMatch::operator+(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p + other.m_p);
+}
+
+BFSIGTRAITS_TML_HDR
+BFSIGTRAITS_CLS::MayHaveMatch::LeafNode::LeafNode(BloomFilterSignatureTraits const & traits, QGram const & qg, std::size_t editDistance) :
+m_th(int32_t(qg.base().size() + qg.q() - 1) - int32_t(editDistance * qg.q())),
+m_n(qg.size())
+{
+	std::vector<QGramFingerprints::value_type> fps;
+	fps.reserve(qg.size());
+	QGramFingerprints qf(qg.base(), qg.q());
+	for(auto fp : qf) {
+		fps.push_back(fp);
+	}
+	std::sort(fps.begin(), fps.end());
+	for(std::size_t i(0); i < fps.size();) {
+		std::size_t j = i+1;
+		for(; j < fps.size() && fps[j] == fps[i]; ++j) {}
+		auto p = traits.position(fps[i]);
+		m_probes.push_back(Probe{p.second, p.first, uint32_t(j-i)});
+		i = j;
+	}
+	std::stable_sort(m_probes.begin(), m_probes.end(), [](Probe const & a, Probe const & b) {
+		return a.count > b.count;
+	});
+}
+
+BFSIGTRAITS_TML_HDR
+bool
+BFSIGTRAITS_CLS::MayHaveMatch::LeafNode::matches(Signature const & ns) const {
+	//Same bound as ROPQGramDB::nomatch: a match shares at least m_th q-grams with the reference.
+	//The filter may contain q-grams of the reference that are not in its strings but never misses one.
+	//Stop as soon as the bound is reached or can not be reached anymore.
+	if (m_th <= 0) {
+		return true;
+	}
+	int64_t found = 0;
+	int64_t remaining = m_n;
+	for(Probe const & p : m_probes) {
+		remaining -= p.count;
+		if (ns.contains(p.block, p.mask)) {
+			found += p.count;
+			if (found >= m_th) {
+				return true;
+			}
+		}
+		else if (found + remaining < m_th) {
+			return false;
+		}
+	}
+	return false;
+}
+
+#undef BFSIGTRAITS_CLS
+#undef BFSIGTRAITS_TML_HDR
+
+}//end namespace srtree::detail
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <srtree/MinWiseSignature.h>
+
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <cmath>
+
+namespace srtree {
+
+///Bottom-k sketch (k minimum values, Bar-Yossef et al. 2002, Cohen, Kaplan 2007)
+///All elements of a set are hashed by a single hash function and the T_SIZE smallest distinct hash values are kept in ascending order.
+///Sets with less than T_SIZE elements are represented exactly, the remaining entries are empty, i.e. the maximum value.
+///In contrast to MinWiseSignature the combination is exact: the sketch of a union is the bottom-k of the union of the sketches.
+///Every value of the sketch of a union that belongs to one of the sets is in the sketch of that set,
+///hence the values of a sketch below the threshold() of another one are a uniform sample to test containment with.
+template<std::size_t T_SIZE, std::size_t T_ENTRY_BITS = 64>
+class BottomKSignature {
+public:
+	static constexpr std::size_t size = T_SIZE;
+	static constexpr std::size_t entry_bits = T_ENTRY_BITS;
+	static_assert(size > 0, "BottomKSignature needs at least one entry");
+public:
+	using size_type = std::size_t;
+	using entry_type = typename detail::MinWisePermutation::EntryType<entry_bits>::type;
+	using self = BottomKSignature<size, entry_bits>;
+	using container_type = std::array<entry_type, size>;
+	using const_iterator = typename container_type::const_iterator;
+	///Value of unused entries, a hash value equal to it is ignored
+	static constexpr entry_type Empty = std::numeric_limits<entry_type>::max();
+public:
+	BottomKSignature() {
+		m_e.fill(Empty);
+	}
+	BottomKSignature(sserialize::UByteArrayAdapter d) {
+		for(entry_type & x : m_e) {
+			d >> x;
+		}
+	}
+	~BottomKSignature() {}
+public:
+	const_iterator begin() const { return m_e.begin(); }
+	const_iterator cbegin() const { return m_e.cbegin(); }
+	///End of the used entries
+	const_iterator end() const { return m_e.begin() + count(); }
+	const_iterator cend() const { return end(); }
+public:
+	entry_type const & at(size_type i) const {
+		return m_e.at(i);
+	}
+	entry_type const * data() const { return m_e.data(); }
+	///Number of used entries
+	size_type count() const {
+		return size_type(std::lower_bound(m_e.begin(), m_e.end(), Empty) - m_e.begin());
+	}
+	///True if the set has at least size elements, the sketch is a sample then
+	bool full() const { return m_e.back() != Empty; }
+	///Hash values up to the threshold are in the sketch iff they are in the set. This is Empty if the sketch is exact.
+	entry_type threshold() const { return m_e.back(); }
+	///Estimated number of distinct elements of the set, exact if the sketch is not full
+	///@param range of the hash values, i.e. all hash values are in [0, range)
+	double cardinality(double range) const {
+		if (!full()) {
+			return double(count());
+		}
+		return double(size-1)*range/(double(threshold())+1);
+	}
+	///Add the hash value @param h of an element
+	void insert(entry_type h) {
+		if (h >= m_e.back()) {
+			return;
+		}
+		auto pos = std::lower_bound(m_e.begin(), m_e.end(), h);
+		if (*pos == h) {
+			return;
+		}
+		std::move_backward(pos, m_e.end()-1, m_e.end());
+		*pos = h;
+	}
+	self operator+(self const & other) const {
+		self result(*this);
+		result += other;
+		return result;
+	}
+	///Merge of both sketches keeping the size smallest distinct values
+	self & operator+=(self const & other) {
+		container_type result;
+		size_type i = 0;
+		size_type j = 0;
+		size_type n = 0;
+		for(; n < size; ++n) {
+			entry_type a = i < size ? m_e[i] : Empty;
+			entry_type b = j < size ? other.m_e[j] : Empty;
+			entry_type v = std::min(a, b);
+			if (v == Empty) {
+				break;
+			}
+			result[n] = v;
+			i += a == v;
+			j += b == v;
+		}
+		std::fill(result.begin()+n, result.end(), Empty);
+		m_e = result;
+		return *this;
+	}
+	///Number of values in both sketches
+	size_type operator/(self const & other) const {
+		size_type result = 0;
+		for(size_type i(0), j(0); i < size && j < size && m_e[i] != Empty && other.m_e[j] != Empty;) {
+			if (m_e[i] < other.m_e[j]) {
+				++i;
+			}
+			else if (other.m_e[j] < m_e[i]) {
+				++j;
+			}
+			else {
+				++result;
+				++i;
+				++j;
+			}
+		}
+		return result;
+	}
+	///Number of values of this sketch that are in @param other and number of values that are not larger than the threshold of @param other.
+	///Membership of the latter in the set of @param other is known, their ratio estimates the fraction of this set contained in the other one.
+	std::pair<size_type, size_type> containment(self const & other) const {
+		entry_type t = other.threshold();
+		size_type found = 0;
+		size_type considered = 0;
+		for(size_type i(0), j(0); i < size && m_e[i] != Empty && m_e[i] <= t; ++i) {
+			++considered;
+			while (other.m_e[j] < m_e[i]) {
+				++j;
+			}
+			found += other.m_e[j] == m_e[i];
+		}
+		return std::make_pair(found, considered);
+	}
+	///Combination of all signatures in [begin, end)
+	///@param begin has to dereference to a BottomKSignature
+	template<typename T_ITERATOR>
+	static self combine(T_ITERATOR begin, T_ITERATOR end) {
+		self result;
+		for(; begin != end; ++begin) {
+			result += *begin;
+		}
+		return result;
+	}
+	bool operator==(self const & other) const {
+		return m_e == other.m_e;
+	}
+	bool operator!=(self const & other) const {
+		return m_e != other.m_e;
+	}
+private:
+	container_type m_e;
+};
+
+template<std::size_t T_SIZE, std::size_t V>
+std::ostream & operator<<(std::ostream & out, BottomKSignature<T_SIZE, V> const & sig) {
+	out << "BottomKSignature<" << T_SIZE << ", " << V << ">(";
+	for(auto it = sig.begin(); it != sig.end(); ++it) {
+		if (it != sig.begin()) {
+			out << ", ";
+		}
+		out << *it;
+	}
+	return out << ')';
+}
+
+template<std::size_t U, std::size_t V>
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, BottomKSignature<U, V> const & sig) {
+	for(std::size_t i(0); i < U; ++i) {
+		dest << sig.at(i);
+	}
+	return dest;
+}
+
+}//end namespace srtree
+
+namespace sserialize {
+
+template<std::size_t T_SIGNATURE_SIZE, std::size_t T_ENTRY_BITS>
+struct SerializationInfo< srtree::BottomKSignature<T_SIGNATURE_SIZE, T_ENTRY_BITS> > {
+	using value_type = srtree::BottomKSignature<T_SIGNATURE_SIZE, T_ENTRY_BITS>;
+	static constexpr bool is_fixed_length = true;
+	static constexpr OffsetType length = T_SIGNATURE_SIZE*SerializationInfo<typename value_type::entry_type>::length;
+	static constexpr OffsetType max_length = length;
+	static constexpr OffsetType min_length = length;
+	static constexpr OffsetType sizeInBytes(const value_type & value) {
+		return length;
+	}
+};
+
+} //end namespace sserialize
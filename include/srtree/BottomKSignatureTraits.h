@@ -0,0 +1,270 @@
+#pragma once
+
+#include <srtree/BottomKSignature.h>
+#include <srtree/QGram.h>
+#include <srtree/PredicateProgram.h>
+
+#include <sserialize/storage/UByteArrayAdapter.h>
+
+#include <vector>
+#include <algorithm>
+
+
+namespace srtree::detail {
+
+///Signature traits based on bottom-k sketches of the q-grams of the strings
+///The QGramFingerprints of a string are hashed by a single hash function, the signature keeps the T_SIZE smallest values.
+///Signatures are combined exactly and have a fixed size, hence they can be used with the Static::SRTree and the dedup adapters.
+template<std::size_t T_SIZE, typename T_PARAMETRISED_HASH_FUNCTION = MinWisePermutation::XXHash64>
+class BottomKSignatureTraits {
+public:
+	using StaticTraits = BottomKSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION>;
+public:
+	static constexpr std::size_t SignatureSize = T_SIZE;
+	using HashFunction = T_PARAMETRISED_HASH_FUNCTION;
+	using Signature = BottomKSignature<SignatureSize, HashFunction::entry_bits>;
+	using QType = uint8_t;
+
+	class Serializer {
+	public:
+		using Type = Signature;
+	public:
+		inline sserialize::UByteArrayAdapter & operator()(sserialize::UByteArrayAdapter & dest, Signature const & sig) const {
+			return dest << sig;
+		}
+	};
+
+	class Deserializer {
+	public:
+		using Type = Signature;
+	public:
+		Signature operator()(Type v) const {
+			return v;
+		}
+	};
+
+	struct Combine {
+		Signature operator()(Signature const & first, Signature const & second) const {
+			return first + second;
+		}
+
+		template<typename Iterator>
+		Signature operator()(Iterator begin, Iterator end) const {
+			return Signature::combine(begin, end);
+		}
+	};
+
+	///Estimate of the fraction of q-grams in the union of @param base and @param toAdd that are not in @param base
+	///A value of the sketch of the union is in the set of @param base iff it is in the sketch of @param base
+	struct Enlargement {
+		double operator()(Signature const & base, Signature const & toAdd) const {
+			Signature u = base + toAdd;
+			std::size_t n = u.count();
+			return n ? 1.0 - double(u / base)/n : 0.0;
+		}
+	};
+
+	class MayHaveMatch final {
+	public:
+		MayHaveMatch(MayHaveMatch const &) = default;
+		MayHaveMatch(MayHaveMatch &&) = default;
+		MayHaveMatch & operator=(MayHaveMatch const&) = default;
+		MayHaveMatch & operator=(MayHaveMatch &&) = default;
+		~MayHaveMatch() {}
+	public:
+		bool operator()(Signature const & ns) const;
+		MayHaveMatch operator/(MayHaveMatch const & other) const;
+		MayHaveMatch operator+(MayHaveMatch const & other) const;
+	private:
+		class LeafNode {
+		public:
+			LeafNode(Signature const & ref, QGram const & qg, std::size_t distinct, std::size_t editDistance);
+		public:
+			bool matches(Signature const & v) const;
+		private:
+			Signature m_ref;
+			//number of distinct hash values of the reference a match shares at least
+			int64_t m_th;
+			//number of distinct hash values of the reference
+			int64_t m_n;
+		};
+		using Program = PredicateProgram<LeafNode>;
+	private:
+		friend class BottomKSignatureTraits;
+	private:
+		MayHaveMatch(Signature const & ref, QGram const & qg, std::size_t distinct, std::size_t editDistance);
+		MayHaveMatch(Program && p);
+	private:
+		Program m_p;
+	};
+
+public:
+	BottomKSignatureTraits() : BottomKSignatureTraits(3) {}
+	BottomKSignatureTraits(sserialize::UByteArrayAdapter d) {
+		d >> *this;
+	}
+	BottomKSignatureTraits(std::size_t q) : BottomKSignatureTraits(q, 2) {}
+	BottomKSignatureTraits(std::size_t q, std::size_t hashSize) : m_q(q) {
+		if (q < 1 || q > QGramFingerprints::MaxQ) {
+			throw sserialize::PreconditionViolationException("BottomKSignatureTraits: q has to be in [1, 255]");
+		}
+		CryptoPP::AutoSeededRandomPool rng;
+		m_hash.emplace_back(rng, hashSize);
+	}
+	BottomKSignatureTraits(BottomKSignatureTraits && other) = default;
+	virtual ~BottomKSignatureTraits() {}
+	BottomKSignatureTraits & operator=(BottomKSignatureTraits && other) = default;
+	QType q() const { return m_q; }
+	HashFunction const & hash() const { return m_hash.front(); }
+	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const {
+		sserialize::UByteArrayAdapter tmp(sserialize::MM_PROGRAM_MEMORY);
+		tmp << *this;
+		return tmp.size();
+	}
+	///Estimated number of distinct q-grams of the strings with signature @param sig
+	double cardinality(Signature const & sig) const {
+		return sig.cardinality(hash().range());
+	}
+public:
+	Combine combine() const { return Combine(); }
+	Enlargement enlargement() const { return Enlargement(); }
+	MayHaveMatch mayHaveMatch(std::string const & str, std::size_t editDistance) const {
+		QGram qg(str, m_q);
+		return MayHaveMatch(signature(qg), qg, distinct(qg), editDistance);
+	}
+	Serializer serializer() const { return Serializer(); }
+	Deserializer deserializer() const { return Deserializer(); }
+public:
+	Signature signature(std::string const & str) const {
+		if (!str.size()) {
+			throw sserialize::PreconditionViolationException("Empty string is not allowed!");
+		}
+		QGramFingerprints qf(str, m_q);
+		return signature(qf);
+	}
+	///Signature of the q-grams @param qg, q has to be the one of the traits
+	Signature signature(QGram const & qg) const {
+		QGramFingerprints qf(qg.base(), qg.q());
+		return signature(qf);
+	}
+	template<typename T_STRING_ITERATOR>
+	Signature signature(T_STRING_ITERATOR begin, T_STRING_ITERATOR end) const {
+		if (begin == end) {
+			throw sserialize::PreconditionViolationException("Empty string sets are not allowed!");
+		}
+		Signature sig = signature(*begin);
+		for(++begin; begin != end; ++begin) {
+			sig += signature(*begin);
+		}
+		return sig;
+	}
+private:
+	///Number of distinct hash values of the q-grams @param qg, i.e. the size of its sketch if it were unbounded
+	std::size_t distinct(QGram const & qg) const {
+		std::vector<typename Signature::entry_type> values;
+		HashFunction const & h = hash();
+		for(auto fp : QGramFingerprints(qg.base(), qg.q())) {
+			typename Signature::entry_type v = h(typename HashFunction::size_type(fp));
+			if (v != Signature::Empty) {
+				values.push_back(v);
+			}
+		}
+		std::sort(values.begin(), values.end());
+		return std::unique(values.begin(), values.end()) - values.begin();
+	}
+	Signature signature(QGramFingerprints const & qf) const {
+		Signature sig;
+		HashFunction const & h = hash();
+		for(auto fp : qf) {
+			sig.insert(h(typename HashFunction::size_type(fp)));
+		}
+		return sig;
+	}
+private:
+	template<std::size_t U, typename V>
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, srtree::detail::BottomKSignatureTraits<U, V> const & v);
+
+	template<std::size_t U, typename V>
+	friend sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, srtree::detail::BottomKSignatureTraits<U, V> & v);
+private:
+	QType m_q; //the q in q-grams
+	//a single hash function, stored like the permutations of MinWiseSignatureGenerator
+	std::vector<HashFunction> m_hash;
+};
+
+template<std::size_t T_SIZE, typename T_PARAMETRISED_HASH_FUNCTION>
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, srtree::detail::BottomKSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION> const & v) {
+	return dest << v.m_q << v.m_hash;
+}
+
+template<std::size_t T_SIZE, typename T_PARAMETRISED_HASH_FUNCTION>
+sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, srtree::detail::BottomKSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION> & v) {
+	return dest >> v.m_q >> v.m_hash;
+}
+
+}//end namespace srtree::detail
+
+
+//implementation
+namespace srtree::detail {
+
+#define BKSIGTRAITS_TML_HDR template<std::size_t T_SIZE, typename T_PARAMETRISED_HASH_FUNCTION>
+#define BKSIGTRAITS_CLS BottomKSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION>
+
+BKSIGTRAITS_TML_HDR
+BKSIGTRAITS_CLS::MayHaveMatch::MayHaveMatch(Signature const & ref, QGram const & qg, std::size_t distinct, std::size_t editDistance) :
+m_p( LeafNode(ref, qg, distinct, editDistance) )
+{}
+
+BKSIGTRAITS_TML_HDR
+BKSIGTRAITS_CLS::MayHaveMatch::MayHaveMatch(Program && p) :
+m_p(std::move(p))
+{}
+
+BKSIGTRAITS_TML_HDR
+bool
+BKSIGTRAITS_CLS::MayHaveMatch::operator()(Signature const & ns) const {
+	return m_p([&ns](LeafNode const & leaf) { return leaf.matches(ns); });
+}
+
+BKSIGTRAITS_TML_HDR
+typename BKSIGTRAITS_CLS::MayHaveMatch
+BKSIGTRAITS_CLS::MayHaveMatch::operator/(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p / other.m_p);
+}
+
+BKSIGTRAITS_TML_HDR
+typename BKSIGTRAITS_CLS::MayHaveMatch
+BKSIGTRAITS_CLS::MayHaveMatch::operator+(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p + other.m_p);
+}
+
+BKSIGTRAITS_TML_HDR
+BKSIGTRAITS_CLS::MayHaveMatch::LeafNode::LeafNode(Signature const & ref, QGram const & qg, std::size_t distinct, std::size_t editDistance) :
+m_ref(ref),
+//A match shares at least |ref|+q-1-editDistance*q q-grams with the reference counted with multiplicity (q-gram lemma).
+//Each of the qg.size()-distinct repeated q-grams adds at most one to that count, the rest are distinct hash values.
+m_th(int64_t(qg.base().size() + qg.q() - 1) - int64_t(editDistance * qg.q()) - (int64_t(qg.size()) - int64_t(distinct))),
+m_n(distinct)
+{}
+
+BKSIGTRAITS_TML_HDR
+bool
+BKSIGTRAITS_CLS::MayHaveMatch::LeafNode::matches(Signature const & ns) const {
+	//A match shares at least m_th of the m_n distinct hash values of the reference.
+	//The values of the reference up to the threshold of ns are a uniform sample of them whose membership in ns is known,
+	//the fraction found in ns estimates the contained fraction of the reference. The test is exact if neither sketch is full.
+	if (m_th <= 0) {
+		return true;
+	}
+	auto counts = m_ref.containment(ns);
+	if (counts.second == 0) {
+		return true;
+	}
+	return int64_t(counts.first) * m_n >= m_th * int64_t(counts.second);
+}
+
+#undef BKSIGTRAITS_CLS
+#undef BKSIGTRAITS_TML_HDR
+
+}//end namespace srtree::detail
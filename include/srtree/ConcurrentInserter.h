@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <exception>
+
+#include <sserialize/utility/assert.h>
+
+namespace srtree {
+
+///Concurrent front-end for SRTree::insert
+///Every thread stages its items in its own Buffer which is drained into the tree in batches.
+///Draining a full buffer only tries to acquire the tree lock.
+///If the tree is busy the thread keeps on staging items until the buffer reached twice its batch size and only then waits.
+///Hence producers (i.e. signature computation) run in parallel and rarely block on each other,
+///whereas the tree itself is only ever modified by a single thread at a time.
+///
+///Usage:
+///ConcurrentInserter<Tree> inserter(tree, [](Tree::ItemNode const * in) {...});
+///In each thread:
+///auto buffer = inserter.buffer();
+///buffer.insert(b, sig, item);
+///buffer.flush(); //required, buffers do not insert their remaining items on destruction
+template<typename T_TREE>
+class ConcurrentInserter final {
+public:
+	using Tree = T_TREE;
+	using Boundary = typename Tree::Boundary;
+	using Signature = typename Tree::Signature;
+	using ItemType = typename Tree::ItemType;
+	using ItemNode = typename Tree::ItemNode;
+	using ItemDescription = typename Tree::ItemDescription;
+	///Called for every inserted item while holding the tree lock
+	using Callback = std::function<void(ItemNode const *)>;
+	static constexpr std::size_t DefaultBatchSize = 256;
+public:
+	class Buffer final {
+	public:
+		Buffer(Buffer const &) = delete;
+		Buffer(Buffer &&) = default;
+		///All items have to be flushed before, unless the buffer is destroyed during stack unwinding.
+		///Flushing here could throw from the destructor if the insert callback throws.
+		~Buffer() {
+			SSERIALIZE_CHEAP_ASSERT(!m_d.size() || std::uncaught_exceptions());
+		}
+		Buffer & operator=(Buffer const &) = delete;
+		///Would drop the staged items of the target
+		Buffer & operator=(Buffer &&) = delete;
+	public:
+		void insert(Boundary const & b, Signature const & sig, ItemType const & item) {
+			insert(ItemDescription{b, sig, item});
+		}
+		void insert(ItemDescription && d) {
+			m_d.push_back(std::move(d));
+			if (m_d.size() >= m_p->batchSize()) {
+				m_p->drain(m_d, m_d.size() >= 2*m_p->batchSize());
+			}
+		}
+		///Insert all staged items, blocks until the tree is available
+		void flush() {
+			if (m_d.size()) {
+				m_p->drain(m_d, true);
+			}
+		}
+		std::size_t size() const { return m_d.size(); }
+	private:
+		friend class ConcurrentInserter;
+	private:
+		Buffer(ConcurrentInserter * p) : m_p(p) {
+			m_d.reserve(2*m_p->batchSize());
+		}
+	private:
+		ConcurrentInserter * m_p;
+		std::vector<ItemDescription> m_d;
+	};
+public:
+	ConcurrentInserter(Tree & tree, std::size_t batchSize = DefaultBatchSize) :
+	ConcurrentInserter(tree, Callback(), batchSize)
+	{}
+	ConcurrentInserter(Tree & tree, Callback cb, std::size_t batchSize = DefaultBatchSize) :
+	m_tree(tree),
+	m_cb(std::move(cb)),
+	m_bs(std::max<std::size_t>(1, batchSize))
+	{}
+	ConcurrentInserter(ConcurrentInserter const &) = delete;
+	~ConcurrentInserter() {}
+public:
+	///One buffer per thread, buffers must not outlive their inserter
+	Buffer buffer() { return Buffer(this); }
+	std::size_t batchSize() const { return m_bs; }
+	///Execute @param f with exclusive access to the tree
+	template<typename T_FUNC>
+	auto exclusive(T_FUNC f) {
+		std::lock_guard<std::mutex> lck(m_lock);
+		return f(m_tree);
+	}
+private:
+	///@param wait if false then the items are only inserted if the tree is not locked by another thread
+	void drain(std::vector<ItemDescription> & d, bool wait) {
+		std::unique_lock<std::mutex> lck(m_lock, std::defer_lock);
+		if (wait) {
+			lck.lock();
+		}
+		else if (!lck.try_lock()) {
+			return;
+		}
+		for(ItemDescription & x : d) {
+			ItemNode const * in = m_tree.insert(std::move(x));
+			if (m_cb) {
+				m_cb(in);
+			}
+		}
+		lck.unlock();
+		d.clear();
+	}
+private:
+	Tree & m_tree;
+	Callback m_cb;
+	std::size_t m_bs;
+	std::mutex m_lock;
+};
+
+}//end namespace srtree
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include <sserialize/containers/VariantStore.h>
 #include <sserialize/utility/checks.h>
 #include <srtree/Static/DedupDeserializationTraitsAdapter.h>
@@ -18,22 +20,42 @@ public:
 		using Type = uint32_t;
 		using BaseSerializer = typename Parent::Serializer;
 	public:
-		Serializer(std::shared_ptr<sserialize::VariantStore> const & vs, BaseSerializer && base) :
+		Serializer(std::shared_ptr<sserialize::VariantStore> const & vs, std::shared_ptr<std::mutex> const & vsLock, BaseSerializer && base) :
 		m_base(std::forward<BaseSerializer>(base)),
-		m_vs(vs)
+		m_vs(vs),
+		m_vsLock(vsLock)
 		{}
 		Serializer(Serializer const & ) = default;
 	public:
+		///Different instances may be used concurrently, only the insertion into the store is serialized.
+		///The ids then depend on the order in which the instances reach the store,
+		///use encode() concurrently and store() in the final order to get deterministic ids.
 		inline sserialize::UByteArrayAdapter & operator()(sserialize::UByteArrayAdapter & dest, Signature const & v) {
 			m_cache.resize(0);
-			m_base(m_cache, v);
-			dest.put<uint32_t>( sserialize::narrow_check<uint32_t>( m_vs->insert(m_cache) ) );
+			encode(m_cache, v);
+			return store(dest, m_cache);
+		}
+		///Append @param v encoded by the base serializer to @param dest, the store is not touched
+		inline sserialize::UByteArrayAdapter & encode(sserialize::UByteArrayAdapter & dest, Signature const & v) {
+			m_base(dest, v);
+			return dest;
+		}
+		///Insert the signature @param encoded by encode() into the store and put its id
+		///Ids of new signatures are assigned in the order of the calls
+		inline sserialize::UByteArrayAdapter & store(sserialize::UByteArrayAdapter & dest, sserialize::UByteArrayAdapter const & encoded) {
+			uint32_t id;
+			{
+				std::lock_guard<std::mutex> lck(*m_vsLock);
+				id = sserialize::narrow_check<uint32_t>( m_vs->insert(encoded) );
+			}
+			dest.put<uint32_t>(id);
 			return dest;
 		}
 	private:
 		sserialize::UByteArrayAdapter m_cache{sserialize::MM_PROGRAM_MEMORY};
 		typename Parent::Serializer m_base;
 		std::shared_ptr<sserialize::VariantStore> m_vs;
+		std::shared_ptr<std::mutex> m_vsLock;
 	};
 	class Deserializer {
 	public:
@@ -51,11 +73,13 @@ public:
 	template<typename... T_ARGS>
 	DedupSerializationTraitsAdapter(T_ARGS... args) :
 	Parent(std::forward<T_ARGS>(args)...),
-	m_vs(std::make_shared<sserialize::VariantStore>(sserialize::MM_FAST_FILEBASED))
+	m_vs(std::make_shared<sserialize::VariantStore>(sserialize::MM_FAST_FILEBASED)),
+	m_vsLock(std::make_shared<std::mutex>())
 	{}
 	DedupSerializationTraitsAdapter(Parent const & p) :
 	Parent(p),
-	m_vs(std::make_shared<sserialize::VariantStore>(sserialize::MM_FAST_FILEBASED))
+	m_vs(std::make_shared<sserialize::VariantStore>(sserialize::MM_FAST_FILEBASED)),
+	m_vsLock(std::make_shared<std::mutex>())
 	{}
 	DedupSerializationTraitsAdapter(DedupSerializationTraitsAdapter const &) = default;
 	DedupSerializationTraitsAdapter(DedupSerializationTraitsAdapter && other) = default;
@@ -63,12 +87,14 @@ public:
 	DedupSerializationTraitsAdapter & operator=(DedupSerializationTraitsAdapter const &) = default;
 	DedupSerializationTraitsAdapter & operator=(DedupSerializationTraitsAdapter &&) = default;
 public:
-	inline Serializer serializer() const { return Serializer(m_vs, Parent::serializer()); }
+	///Each call returns a serializer with its own buffer
+	inline Serializer serializer() const { return Serializer(m_vs, m_vsLock, Parent::serializer()); }
 private:
 	template<typename U>
 	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, DedupSerializationTraitsAdapter<U> & v);
 private:
 	std::shared_ptr<sserialize::VariantStore> m_vs;
+	std::shared_ptr<std::mutex> m_vsLock;
 };
 
 template<typename U>
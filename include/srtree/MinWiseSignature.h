@@ -1,8 +1,10 @@
 #pragma once
 #include <limits>
+#include <cmath>
 #include <sserialize/utility/exceptions.h>
 #include <sserialize/storage/UByteArrayAdapter.h>
 #include <sserialize/Static/Array.h>
+#include <srtree/MinWiseSignatureKernels.h>
 #include <random>
 #include <crypto++/osrng.h>
 #include <crypto++/nbtheory.h>
@@ -66,11 +68,82 @@ private:
 	entry_type m_p;
 };
 
+///Montgomery arithmetic modulo an odd p < R/2 with R = 2^word_bits
+///Numbers in Montgomery form are x*R mod p. Products need a single reduction without any division.
+template<typename T_WORD>
+class MontgomeryReduction final {
+public:
+	using word_type = T_WORD;
+	static_assert(std::is_same<word_type, uint32_t>::value || std::is_same<word_type, uint64_t>::value);
+	static constexpr std::size_t word_bits = 8*sizeof(word_type);
+	using double_type = typename EntryType<2*word_bits>::type;
+public:
+	MontgomeryReduction() {}
+	MontgomeryReduction(word_type p) : m_p(p) {
+		//Newton iteration for p^-1 mod R, p*p = 1 mod 8 hence p is correct in the lowest 3 bits
+		word_type inv = p;
+		for(std::size_t i(0); i < 5; ++i) {
+			inv *= word_type(2) - p*inv;
+		}
+		m_pinv = word_type(0) - inv;
+		word_type rmodp = (word_type(0) - p) % p;
+		m_r2 = word_type( double_type(rmodp)*rmodp % p );
+	}
+	~MontgomeryReduction() {}
+public:
+	inline word_type modulus() const { return m_p; }
+	inline word_type pinv() const { return m_pinv; }
+	inline word_type r2() const { return m_r2; }
+	///@return t*R^-1 mod p for t < p*R
+	inline word_type reduce(double_type t) const { return reduce(t, m_p, m_pinv); }
+	///a*b*R^-1 mod p for a, b < p, this is the Montgomery form of the product of two numbers in Montgomery form
+	inline word_type mul(word_type a, word_type b) const { return reduce(double_type(a)*b); }
+	///a+b mod p for a, b < p
+	inline word_type add(word_type a, word_type b) const { return add(a, b, m_p); }
+	///Montgomery form of x mod p for any x
+	inline word_type to(word_type x) const { return reduce(double_type(x)*m_r2); }
+	inline word_type from(word_type x) const { return reduce(x); }
+public:
+	///@param pinv -p^-1 mod R
+	static inline word_type reduce(double_type t, word_type p, word_type pinv) {
+		word_type m = word_type(t)*pinv;
+		//t + m*p < 2*p*R <= R^2
+		word_type u = word_type( (t + double_type(m)*p) >> word_bits );
+		return u >= p ? u - p : u;
+	}
+	static inline word_type add(word_type a, word_type b, word_type p) {
+		word_type r = a + b;
+		return r >= p ? r - p : r;
+	}
+	///Montgomery form of the little endian number stored in [@param begin, @param end) modulo p
+	inline word_type fromBytes(char const * begin, char const * end) const {
+		constexpr std::size_t wb = sizeof(word_type);
+		std::size_t s = end-begin;
+		word_type result = 0;
+		//Horner scheme with base R starting at the most significant, possibly partial, word
+		for(std::size_t k((s+wb-1)/wb); k > 0; --k) {
+			std::size_t pos = (k-1)*wb;
+			word_type w = 0;
+			::memcpy(&w, begin+pos, std::min(wb, s-pos));
+			//multiplication by R in Montgomery form is a multiplication with R^2
+			result = add(mul(result, m_r2), to(w));
+		}
+		return result;
+	}
+private:
+	word_type m_p{1};
+	word_type m_pinv{0};
+	word_type m_r2{0};
+};
+
 template<std::size_t T_ENTRY_BITS>
 class LinearCongruentialHash {
 public:
 	static constexpr std::size_t entry_bits = T_ENTRY_BITS;
 	using size_type = typename EntryType<entry_bits>::type;
+	///Evaluation with Montgomery arithmetic, otherwise with modulo operations on a wider type
+	static constexpr bool montgomery = std::is_same<size_type, uint32_t>::value || std::is_same<size_type, uint64_t>::value;
+	using Montgomery = MontgomeryReduction<typename std::conditional<montgomery, size_type, uint32_t>::type>;
 public:
 	LinearCongruentialHash(CryptoPP::RandomNumberGenerator & rng, size_type size) {
 		m_c.reserve(size);
@@ -82,9 +155,11 @@ public:
 			m_c.push_back(tmp2);
 		}
 		m_p = CryptoPP::MaurerProvablePrime(rng, entry_bits-1).ConvertToLong();
+		init();
 	}
 	LinearCongruentialHash(sserialize::UByteArrayAdapter d) {
 		d >> m_c >> m_p;
+		init();
 	}
 	~LinearCongruentialHash() {}
 public:
@@ -92,7 +167,20 @@ public:
 	size_type operator()(T const & x) const {
 		return (*this)( detail::MinWisePermutation::Converter<entry_bits, T>(m_p)(x) );
 	}
+	size_type operator()(std::string const & x) const {
+		if constexpr (montgomery) {
+			if (m_c.size() > 1) {
+				return evaluate(m_mr.fromBytes(x.data(), x.data()+x.size()));
+			}
+		}
+		return (*this)( detail::MinWisePermutation::Converter<entry_bits, std::string>(m_p)(x) );
+	}
 	size_type operator()(size_type x) const {
+		if constexpr (montgomery) {
+			if (m_c.size() > 1) {
+				return evaluate(m_mr.to(x));
+			}
+		}
 		using computation_type = typename EntryType<entry_bits+2>::type;
 		computation_type result = m_c.front();
 		for(auto it(m_c.begin()+1), end(m_c.end()); it != end; ++it) {
@@ -103,12 +191,42 @@ public:
 		}
 		return result;
 	}
+public:
+	///Coefficients of the polynomial, highest degree first
+	std::vector<size_type> const & coefficients() const { return m_c; }
+	size_type prime() const { return m_p; }
+	///All hash values are in [0, range())
+	double range() const { return double(m_p); }
+	Montgomery const & montgomeryReduction() const { return m_mr; }
+	///Coefficients in Montgomery form
+	std::vector<size_type> const & montgomeryCoefficients() const { return m_cm; }
 private:
 	template<std::size_t U>
 	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter &, LinearCongruentialHash<U> const &);
+private:
+	void init() {
+		if constexpr (montgomery) {
+			m_mr = Montgomery(m_p);
+			m_cm.clear();
+			for(size_type c : m_c) {
+				m_cm.push_back(m_mr.to(c));
+			}
+		}
+	}
+	///Horner scheme in Montgomery form, the result is the same as the one of the plain evaluation for more than one coefficient
+	///@param x in Montgomery form
+	size_type evaluate(size_type x) const {
+		size_type result = m_cm.front();
+		for(auto it(m_cm.begin()+1), end(m_cm.end()); it != end; ++it) {
+			result = m_mr.add(m_mr.mul(result, x), *it);
+		}
+		return m_mr.from(result);
+	}
 private:
 	std::vector<size_type> m_c;
 	size_type m_p;
+	Montgomery m_mr;
+	std::vector<size_type> m_cm;
 };
 
 template<std::size_t U>
@@ -116,6 +234,167 @@ sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest,
 	return dest << h.m_c << h.m_p;
 }
 
+///Evaluates all permutations of a MinWiseSignatureGenerator on a single value
+///By default every hash function is evaluated on its own.
+template<typename T_HASH_FUNCTION, std::size_t T_SIZE>
+class HashEvaluator {
+public:
+	using HashFunction = T_HASH_FUNCTION;
+	static constexpr std::size_t size = T_SIZE;
+public:
+	HashEvaluator() {}
+	HashEvaluator(std::vector<HashFunction> const &) {}
+	~HashEvaluator() {}
+public:
+	///@param dest i-th entry is the value of perms[i]
+	template<typename T, typename T_ENTRY>
+	void operator()(std::vector<HashFunction> const & perms, T const & x, T_ENTRY * dest) const {
+		for(std::size_t i(0); i < size; ++i) {
+			dest[i] = perms[i](x);
+		}
+	}
+};
+
+///All LinearCongruentialHash of a generator in structure-of-arrays form
+///Strings are split into words only once for all permutations,
+///the modulus, the Montgomery constants and each coefficient of all permutations are stored contiguously.
+template<std::size_t T_ENTRY_BITS, std::size_t T_SIZE>
+class HashEvaluator<LinearCongruentialHash<T_ENTRY_BITS>, T_SIZE> {
+public:
+	using HashFunction = LinearCongruentialHash<T_ENTRY_BITS>;
+	using size_type = typename HashFunction::size_type;
+	using Montgomery = typename HashFunction::Montgomery;
+	using word_type = typename Montgomery::word_type;
+	static constexpr std::size_t size = T_SIZE;
+public:
+	HashEvaluator() {}
+	HashEvaluator(std::vector<HashFunction> const & perms) {
+		if constexpr (HashFunction::montgomery) {
+			if (perms.size() != size || !perms.size()) {
+				return;
+			}
+			std::size_t degree = perms.front().coefficients().size();
+			if (degree < 2) {
+				return;
+			}
+			for(HashFunction const & perm : perms) {
+				if (perm.coefficients().size() != degree) {
+					return;
+				}
+			}
+			m_c.resize(degree);
+			for(std::size_t i(0); i < size; ++i) {
+				HashFunction const & perm = perms[i];
+				m_p[i] = perm.montgomeryReduction().modulus();
+				m_pinv[i] = perm.montgomeryReduction().pinv();
+				m_r2[i] = perm.montgomeryReduction().r2();
+				for(std::size_t j(0); j < degree; ++j) {
+					m_c[j][i] = perm.montgomeryCoefficients()[j];
+				}
+			}
+		}
+	}
+	~HashEvaluator() {}
+public:
+	///Unsigned integers, e.g. q-gram fingerprints, are split into words like strings if the 32 bit kernel is vectorized.
+	///Otherwise the single modulo operation of each permutation is faster than the conversion of the words.
+	template<typename T, typename T_ENTRY>
+	void operator()(std::vector<HashFunction> const & perms, T const & x, T_ENTRY * dest) const {
+		if constexpr (std::is_same<word_type, uint32_t>::value && MinWiseSignatureKernels::vectorized<uint64_t, size>() > 0 && std::is_unsigned<T>::value && sizeof(T) <= sizeof(uint64_t)) {
+			if (m_c.size()) {
+				constexpr std::size_t nw = (sizeof(T)+sizeof(word_type)-1)/sizeof(word_type);
+				std::array<word_type, nw> words;
+				for(std::size_t k(0); k < nw; ++k) {
+					words[nw-1-k] = word_type( uint64_t(x) >> (8*sizeof(word_type)*k) );
+				}
+				evaluate(words.data(), nw, dest);
+				return;
+			}
+		}
+		for(std::size_t i(0); i < size; ++i) {
+			dest[i] = perms[i](x);
+		}
+	}
+	template<typename T_ENTRY>
+	void operator()(std::vector<HashFunction> const & perms, std::string const & x, T_ENTRY * dest) const {
+		if constexpr (HashFunction::montgomery) {
+			if (m_c.size()) {
+				evaluate(x, dest);
+				return;
+			}
+		}
+		for(std::size_t i(0); i < size; ++i) {
+			dest[i] = perms[i](x);
+		}
+	}
+private:
+	template<typename T_ENTRY>
+	void evaluate(std::string const & x, T_ENTRY * dest) const {
+		constexpr std::size_t wb = sizeof(word_type);
+		//little endian words of x, the most significant first
+		std::size_t nw = (x.size()+wb-1)/wb;
+		std::array<word_type, 16> sbuf;
+		std::vector<word_type> dbuf;
+		word_type * words = sbuf.data();
+		if (nw > sbuf.size()) {
+			dbuf.resize(nw);
+			words = dbuf.data();
+		}
+		for(std::size_t k(0); k < nw; ++k) {
+			std::size_t begin = k*wb;
+			word_type w = 0;
+			::memcpy(&w, x.data()+begin, std::min(wb, x.size()-begin));
+			words[nw-1-k] = w;
+		}
+		evaluate(words, nw, dest);
+	}
+	///@param words the number modulo p, most significant word first
+	template<typename T_ENTRY>
+	void evaluate(word_type const * words, std::size_t nw, T_ENTRY * dest) const {
+		if constexpr (std::is_same<word_type, uint32_t>::value) {
+			std::array<uint32_t, size> r;
+			MinWiseSignatureKernels::montgomeryPolynomial<size>(r.data(), words, nw, m_c.front().data(), m_c.size(), m_p.data(), m_pinv.data(), m_r2.data());
+			std::copy(r.begin(), r.end(), dest);
+		}
+		else {
+			evaluateScalar(words, nw, dest);
+		}
+	}
+	template<typename T_ENTRY>
+	void evaluateScalar(word_type const * words, std::size_t nw, T_ENTRY * dest) const {
+		std::array<word_type, size> xm;
+		for(std::size_t i(0); i < size; ++i) {
+			word_type p = m_p[i];
+			word_type pinv = m_pinv[i];
+			word_type r2 = m_r2[i];
+			word_type v = 0;
+			for(std::size_t k(0); k < nw; ++k) {
+				v = Montgomery::add(
+					Montgomery::reduce(typename Montgomery::double_type(v)*r2, p, pinv),
+					Montgomery::reduce(typename Montgomery::double_type(words[k])*r2, p, pinv),
+					p
+				);
+			}
+			xm[i] = v;
+		}
+		std::array<word_type, size> r = m_c.front();
+		for(auto it(m_c.begin()+1), end(m_c.end()); it != end; ++it) {
+			for(std::size_t i(0); i < size; ++i) {
+				r[i] = Montgomery::add(Montgomery::reduce(typename Montgomery::double_type(r[i])*xm[i], m_p[i], m_pinv[i]), (*it)[i], m_p[i]);
+			}
+		}
+		for(std::size_t i(0); i < size; ++i) {
+			dest[i] = Montgomery::reduce(r[i], m_p[i], m_pinv[i]);
+		}
+	}
+private:
+	std::array<word_type, size> m_p;
+	std::array<word_type, size> m_pinv;
+	std::array<word_type, size> m_r2;
+	//m_c[j][i] is the j-th coefficient of permutation i in Montgomery form, empty if the permutations are evaluated one by one
+	std::vector< std::array<word_type, size> > m_c;
+};
+
 template<typename T_CRYPTOPP_HASH_FUNCTION>
 class CryptoPPHash final {
 public:
@@ -156,6 +435,8 @@ public:
 		::memmove(&tmp2, tmp.data(), sizeof(tmp2));
 		return tmp2;
 	}
+	///All hash values are in [0, range())
+	double range() const { return std::ldexp(1.0, entry_bits); }
 private:
 	template<typename U>
 	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter &, CryptoPPHash<U> const &);
@@ -168,6 +449,298 @@ sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest,
 	return dest << h.m_c;
 }
 
+///Seeded XXH64 (https://github.com/Cyan4973/xxHash), a fast non-cryptographic alternative to CryptoPPHash
+///The random 64 bit value is used as seed instead of being prepended to the input, the serialization is the same.
+class XXHash64 final {
+public:
+	static constexpr std::size_t entry_bits = 64;
+	using size_type = typename EntryType<entry_bits>::type;
+public:
+	XXHash64(CryptoPP::RandomNumberGenerator & rng, size_type /*size*/) {
+		rng.GenerateBlock(reinterpret_cast<unsigned char*>(&m_c), sizeof(m_c));
+	}
+	XXHash64(sserialize::UByteArrayAdapter const & d) :
+	m_c(d.get<size_type>(0))
+	{}
+	///Only for tests
+	explicit XXHash64(size_type seed) : m_c(seed) {}
+	~XXHash64() {}
+public:
+	size_type operator()(std::string const & str) const {
+		return hash(reinterpret_cast<uint8_t const *>(str.data()), str.size());
+	}
+	size_type operator()(size_type x) const {
+		//the same as the hash of the 8 bytes of x
+		uint64_t h = m_c + P5 + 8;
+		h ^= round(0, x);
+		return avalanche(rotl(h, 27) * P1 + P4);
+	}
+	///All hash values are in [0, range())
+	double range() const { return std::ldexp(1.0, entry_bits); }
+	size_type seed() const { return m_c; }
+private:
+	static constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+	static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+	static constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+	static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+	static constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+private:
+	static inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64-r)); }
+	static inline uint64_t read64(uint8_t const * p) { uint64_t v; ::memcpy(&v, p, 8); return v; }
+	static inline uint32_t read32(uint8_t const * p) { uint32_t v; ::memcpy(&v, p, 4); return v; }
+	static inline uint64_t round(uint64_t acc, uint64_t input) {
+		return rotl(acc + input * P2, 31) * P1;
+	}
+	static inline uint64_t merge(uint64_t acc, uint64_t val) {
+		return (acc ^ round(0, val)) * P1 + P4;
+	}
+	static inline uint64_t avalanche(uint64_t h) {
+		h ^= h >> 33;
+		h *= P2;
+		h ^= h >> 29;
+		h *= P3;
+		return h ^ (h >> 32);
+	}
+	uint64_t hash(uint8_t const * p, std::size_t len) const {
+		uint8_t const * end = p + len;
+		uint64_t h;
+		if (len >= 32) {
+			uint64_t v1 = m_c + P1 + P2;
+			uint64_t v2 = m_c + P2;
+			uint64_t v3 = m_c;
+			uint64_t v4 = m_c - P1;
+			for(; end - p >= 32; p += 32) {
+				v1 = round(v1, read64(p));
+				v2 = round(v2, read64(p+8));
+				v3 = round(v3, read64(p+16));
+				v4 = round(v4, read64(p+24));
+			}
+			h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+			h = merge(h, v1);
+			h = merge(h, v2);
+			h = merge(h, v3);
+			h = merge(h, v4);
+		}
+		else {
+			h = m_c + P5;
+		}
+		h += len;
+		for(; end - p >= 8; p += 8) {
+			h ^= round(0, read64(p));
+			h = rotl(h, 27) * P1 + P4;
+		}
+		if (end - p >= 4) {
+			h ^= uint64_t(read32(p)) * P1;
+			h = rotl(h, 23) * P2 + P3;
+			p += 4;
+		}
+		for(; p != end; ++p) {
+			h ^= (*p) * P5;
+			h = rotl(h, 11) * P1;
+		}
+		return avalanche(h);
+	}
+private:
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter &, XXHash64 const &);
+private:
+	size_type m_c;
+};
+
+inline sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, XXHash64 const & h) {
+	return dest << h.m_c;
+}
+
+///Vector multiply-shift hashing (Dietzfelbinger 1996)
+///The input is split into 32 bit words x_i, each 32 bit part of the result is
+///h(x) = (b + sum_i a_i*x_i mod 2^64) >> 32
+///with independent random 64 bit coefficients a_i and b. This is strongly universal for inputs of up to MaxWords words.
+///Longer inputs reuse the coefficients.
+///In contrast to LinearCongruentialHash there is no modulo operation and no prime, hence the hash size is ignored.
+template<std::size_t T_ENTRY_BITS>
+class MultiplyShiftHash final {
+public:
+	static constexpr std::size_t entry_bits = T_ENTRY_BITS;
+	static_assert(entry_bits == 32 || entry_bits == 64, "MultiplyShiftHash supports 32 and 64 bit entries");
+	using size_type = typename EntryType<entry_bits>::type;
+	static constexpr std::size_t MaxWords = 16;
+	static constexpr std::size_t Parts = entry_bits/32;
+	static constexpr std::size_t CoefficientsPerPart = MaxWords+1;
+public:
+	MultiplyShiftHash(CryptoPP::RandomNumberGenerator & rng, size_type /*size*/) {
+		m_c.resize(Parts*CoefficientsPerPart);
+		rng.GenerateBlock(reinterpret_cast<unsigned char*>(m_c.data()), m_c.size()*sizeof(uint64_t));
+	}
+	MultiplyShiftHash(sserialize::UByteArrayAdapter d) {
+		d >> m_c;
+		if (m_c.size() != Parts*CoefficientsPerPart) {
+			throw sserialize::TypeMissMatchException("MultiplyShiftHash: invalid number of coefficients");
+		}
+	}
+	~MultiplyShiftHash() {}
+public:
+	size_type operator()(std::string const & str) const {
+		//the length is the first word, otherwise strings that only differ by trailing zeros collide
+		std::array<uint64_t, Parts> acc = init(str.size());
+		std::size_t i = 1;
+		char const * it = str.data();
+		char const * end = str.data()+str.size();
+		for(; end-it >= 4; it += 4, ++i) {
+			uint32_t w;
+			::memcpy(&w, it, 4);
+			add(acc, i, w);
+		}
+		if (it != end) {
+			uint32_t w = 0;
+			::memcpy(&w, it, end-it);
+			add(acc, i, w);
+		}
+		return finalize(acc);
+	}
+	template<typename T, typename = typename std::enable_if<std::is_unsigned<T>::value>::type>
+	size_type operator()(T x) const {
+		std::array<uint64_t, Parts> acc = init(sizeof(T));
+		for(std::size_t i(1); i <= (sizeof(T)+3)/4; ++i, x = T(uint64_t(x) >> 32)) {
+			add(acc, i, uint32_t(x));
+		}
+		return finalize(acc);
+	}
+	///All hash values are in [0, range())
+	double range() const { return std::ldexp(1.0, entry_bits); }
+	///Parts blocks of (b, a_1, ..., a_MaxWords)
+	std::vector<uint64_t> const & coefficients() const { return m_c; }
+	///Index of the coefficient of the @param i-th word in a block, the length is word 0
+	static constexpr std::size_t coefficientIndex(std::size_t i) { return 1 + i%MaxWords; }
+private:
+	inline std::array<uint64_t, Parts> init(uint32_t x0) const {
+		std::array<uint64_t, Parts> acc;
+		for(std::size_t p(0); p < Parts; ++p) {
+			acc[p] = m_c[p*CoefficientsPerPart];
+		}
+		add(acc, 0, x0);
+		return acc;
+	}
+	inline void add(std::array<uint64_t, Parts> & acc, std::size_t i, uint32_t w) const {
+		i = coefficientIndex(i);
+		for(std::size_t p(0); p < Parts; ++p) {
+			acc[p] += m_c[p*CoefficientsPerPart+i] * w;
+		}
+	}
+	inline size_type finalize(std::array<uint64_t, Parts> const & acc) const {
+		size_type result = 0;
+		for(std::size_t p(0); p < Parts; ++p) {
+			result = size_type(uint64_t(result) << 32) | size_type(acc[p] >> 32);
+		}
+		return result;
+	}
+private:
+	template<std::size_t U>
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter &, MultiplyShiftHash<U> const &);
+private:
+	//Parts blocks of (b, a_1, ..., a_MaxWords)
+	std::vector<uint64_t> m_c;
+};
+
+template<std::size_t U>
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, MultiplyShiftHash<U> const & h) {
+	return dest << h.m_c;
+}
+
+///All MultiplyShiftHash of a generator in structure-of-arrays form
+///Each coefficient of all permutations is stored contiguously,
+///the products of all words of the input with the coefficients of all permutations are added by MinWiseSignatureKernels::multiplyAdd.
+template<std::size_t T_ENTRY_BITS, std::size_t T_SIZE>
+class HashEvaluator<MultiplyShiftHash<T_ENTRY_BITS>, T_SIZE> {
+public:
+	using HashFunction = MultiplyShiftHash<T_ENTRY_BITS>;
+	static constexpr std::size_t size = T_SIZE;
+	static constexpr std::size_t Parts = HashFunction::Parts;
+	static constexpr std::size_t CoefficientsPerPart = HashFunction::CoefficientsPerPart;
+public:
+	HashEvaluator() {}
+	HashEvaluator(std::vector<HashFunction> const & perms) {
+		if (perms.size() != size || !perms.size()) {
+			return;
+		}
+		m_c.resize(Parts*CoefficientsPerPart);
+		for(std::size_t i(0); i < size; ++i) {
+			for(std::size_t j(0); j < m_c.size(); ++j) {
+				m_c[j][i] = perms[i].coefficients()[j];
+			}
+		}
+	}
+	~HashEvaluator() {}
+public:
+	///Unsigned integers are only evaluated at once if the kernel is vectorized, otherwise one by one is faster for their few words
+	template<typename T, typename T_ENTRY>
+	void operator()(std::vector<HashFunction> const & perms, T const & x, T_ENTRY * dest) const {
+		if constexpr (MinWiseSignatureKernels::vectorized<uint64_t, size>() > 0 && std::is_unsigned<T>::value && sizeof(T) <= sizeof(uint64_t)) {
+			if (m_c.size()) {
+				//the length is the first word
+				constexpr std::size_t nw = 1+(sizeof(T)+3)/4;
+				std::array<uint32_t, nw> words;
+				words[0] = sizeof(T);
+				for(std::size_t k(1); k < nw; ++k) {
+					words[k] = uint32_t( uint64_t(x) >> (32*(k-1)) );
+				}
+				evaluate<nw>(words.data(), nw, dest);
+				return;
+			}
+		}
+		for(std::size_t i(0); i < size; ++i) {
+			dest[i] = perms[i](x);
+		}
+	}
+	template<typename T_ENTRY>
+	void operator()(std::vector<HashFunction> const & perms, std::string const & x, T_ENTRY * dest) const {
+		std::size_t nw = 1+(x.size()+3)/4;
+		if (!m_c.size() || nw > MaxStringWords) {
+			for(std::size_t i(0); i < size; ++i) {
+				dest[i] = perms[i](x);
+			}
+			return;
+		}
+		std::array<uint32_t, MaxStringWords> words;
+		words[0] = x.size();
+		for(std::size_t k(1); k < nw; ++k) {
+			uint32_t w = 0;
+			::memcpy(&w, x.data()+4*(k-1), std::min<std::size_t>(4, x.size()-4*(k-1)));
+			words[k] = w;
+		}
+		evaluate(words.data(), nw, dest);
+	}
+private:
+	///Longer strings are hashed one permutation after the other
+	static constexpr std::size_t MaxStringWords = 64;
+	///@param words the length followed by the little endian words of the input
+	///A positive T_NW fixes the number of words at compile time
+	template<std::size_t T_NW = 0, typename T_ENTRY>
+	void evaluate(uint32_t const * words, std::size_t nw, T_ENTRY * dest) const {
+		std::array<uint64_t, size> acc;
+		std::array<uint64_t const *, MaxStringWords> c;
+		for(std::size_t p(0); p < Parts; ++p) {
+			std::array<uint64_t, size> const * block = m_c.data() + p*CoefficientsPerPart;
+			for(std::size_t k(0); k < nw; ++k) {
+				c[k] = block[HashFunction::coefficientIndex(k)].data();
+			}
+			MinWiseSignatureKernels::multiplyAdd<size, T_NW>(acc.data(), block[0].data(), c.data(), words, nw);
+			for(std::size_t i(0); i < size; ++i) {
+				dest[i] = T_ENTRY( (p ? uint64_t(dest[i]) << 32 : 0) | (acc[i] >> 32) );
+			}
+		}
+	}
+private:
+	//m_c[j][i] is the j-th coefficient of permutation i, empty if the permutations are evaluated one by one
+	std::vector< std::array<uint64_t, size> > m_c;
+};
+
+///One permutation hashing (Li, Owen, Zhang 2012) with a single T_HASH_FUNCTION instead of one per signature entry
+///This only selects the MinWiseSignatureGenerator specialization, e.g. MinWiseSignatureTraits<56, OnePermutation<MultiplyShiftHash<64>>>
+template<typename T_HASH_FUNCTION>
+struct OnePermutation {
+	using HashFunction = T_HASH_FUNCTION;
+	static constexpr std::size_t entry_bits = HashFunction::entry_bits;
+};
+
 } //end namespace detail::MinWisePermutation
 
 template<std::size_t T_SIZE, std::size_t T_ENTRY_BITS>
@@ -221,26 +794,28 @@ public:
 	entry_type & at(size_type i) {
 		return m_e.at(i);
 	}
+	entry_type const * data() const { return m_e.data(); }
+	entry_type * data() { return m_e.data(); }
 	self operator+(self const & other) const {
 		MinWiseSignature result(*this);
 		result += other;
 		return result;
 	}
 	self & operator+=(self const & other) {
-		for(size_type i(0); i < size; ++i) {
-			using std::min;
-			at(i) = min(at(i), other.at(i));
-		}
+		detail::MinWiseSignatureKernels::minInto<entry_type, size>(data(), other.data());
 		return *this;
 		
 	}
+	///Number of equal entries
 	size_type operator/(self const & other) const {
-		size_type result = 0;
-		for(size_type i(0); i < size; ++i) {
-			if (this->at(i) == other.at(i)) {
-				result += 1;
-			}
-		}
+		return detail::MinWiseSignatureKernels::equalCount<entry_type, size>(data(), other.data());
+	}
+	///Combination of all signatures in [begin, end) in a single pass without intermediate signatures
+	///@param begin has to dereference to a MinWiseSignature
+	template<typename T_ITERATOR>
+	static self combine(T_ITERATOR begin, T_ITERATOR end) {
+		self result;
+		detail::MinWiseSignatureKernels::minInto<entry_type, size>(result.data(), begin, end);
 		return result;
 	}
 	bool operator==(self const & other) const {
@@ -284,10 +859,12 @@ public:
 	using HashFunction = T_PARAMETRISED_HASH_FUNCTION;
 	using Signature = MinWiseSignature<SignatureSize, SignatureEntryBits>;
 	using size_type = std::size_t;
+	using Evaluator = detail::MinWisePermutation::HashEvaluator<HashFunction, SignatureSize>;
 public:
 	MinWiseSignatureGenerator() : MinWiseSignatureGenerator(2) {}
 	MinWiseSignatureGenerator(sserialize::UByteArrayAdapter d) {
 		d >> m_perms;
+		m_eval = Evaluator(m_perms);
 	}
 	MinWiseSignatureGenerator(size_type hashSize) {
 		CryptoPP::AutoSeededRandomPool rng;
@@ -301,24 +878,31 @@ public:
 		tmp << *this;
 		return tmp.size();
 	}
+	std::vector<HashFunction> const & permutations() const { return m_perms; }
+	///Estimated number of distinct elements of the set with signature @param sig, of the union for combined signatures
+	///Each entry is the minimum of n uniform values, hence (SignatureSize-1)/sum_i(sig_i/range_i) is an unbiased estimate of n
+	double cardinality(Signature const & sig) const {
+		double sum = 0;
+		for(size_type i(0); i < SignatureSize; ++i) {
+			sum += double(sig.at(i))/m_perms[i].range();
+		}
+		return sum > 0 ? (SignatureSize-1)/sum : std::numeric_limits<double>::max();
+	}
 public:
 	template<typename T>
 	Signature operator()(T const & x) const {
 		Signature sig;
-		for(size_type i(0); i < SignatureSize; ++i) {
-			sig.at(i) = m_perms.at(i)(x);
-		}
+		m_eval(m_perms, x, sig.data());
 		return sig;
 	}
 	
 	template<typename T_ITERATOR>
 	Signature operator()(T_ITERATOR begin, T_ITERATOR end) const {
-		using std::min;
-		Signature sig = (*this)(*begin);
-		for (++begin; begin != end; ++begin) {
-			for(size_type i(0); i < SignatureSize; ++i) {
-				sig.at(i) = min(sig.at(i), m_perms.at(i)(*begin));
-			}
+		Signature sig;
+		Signature tmp;
+		for (; begin != end; ++begin) {
+			m_eval(m_perms, *begin, tmp.data());
+			sig += tmp;
 		}
 		return sig;
 	}
@@ -328,6 +912,7 @@ private:
 		for(size_type i(0); i < SignatureSize; ++i) {
 			m_perms.emplace_back(rng, hashSize);
 		}
+		m_eval = Evaluator(m_perms);
 	}
 private:
 	template<std::size_t U, std::size_t V, typename W>
@@ -336,6 +921,7 @@ private:
 	friend sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, MinWiseSignatureGenerator<U, V, W>  & v);
 private:
 	std::vector<HashFunction> m_perms;
+	Evaluator m_eval;
 };
 
 template<std::size_t U, std::size_t V, typename W>
@@ -345,12 +931,161 @@ sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest,
 
 template<std::size_t U, std::size_t V, typename W>
 sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, MinWiseSignatureGenerator<U, V, W> & v) {
-	return dest >> v.m_perms;
+	dest >> v.m_perms;
+	v.m_eval = typename MinWiseSignatureGenerator<U, V, W>::Evaluator(v.m_perms);
+	return dest;
+}
+
+///One permutation hashing with optimal densification (Shrivastava 2017)
+///Every element is hashed once, the hash selects one of the SignatureSize bins by its most significant bits and each bin keeps the minimum.
+///Bins without any element borrow the value of the first non-empty bin of a fixed pseudo-random probe sequence of the bin.
+///Note that the combination of densified signatures only approximates the signature of the union:
+///an entry may be smaller than the one of the union if it was borrowed in one of the signatures.
+template<std::size_t T_SIGNATURE_SIZE, std::size_t T_SIGNATURE_ENTRY_BITS, typename T_HASH_FUNCTION>
+class MinWiseSignatureGenerator<T_SIGNATURE_SIZE, T_SIGNATURE_ENTRY_BITS, detail::MinWisePermutation::OnePermutation<T_HASH_FUNCTION>> {
+public:
+	static constexpr std::size_t SignatureSize = T_SIGNATURE_SIZE;
+	static constexpr std::size_t SignatureEntryBits = T_SIGNATURE_ENTRY_BITS;
+public:
+	using HashFunction = T_HASH_FUNCTION;
+	using Signature = MinWiseSignature<SignatureSize, SignatureEntryBits>;
+	using size_type = std::size_t;
+	using entry_type = typename Signature::entry_type;
+	static_assert(HashFunction::entry_bits == SignatureEntryBits);
+public:
+	MinWiseSignatureGenerator() : MinWiseSignatureGenerator(2) {}
+	MinWiseSignatureGenerator(sserialize::UByteArrayAdapter d) {
+		d >> m_perms >> m_seed;
+	}
+	MinWiseSignatureGenerator(size_type hashSize) {
+		CryptoPP::AutoSeededRandomPool rng;
+		init(rng, hashSize);
+	}
+	MinWiseSignatureGenerator(CryptoPP::RandomNumberGenerator & rng, size_type hashSize) {
+		init(rng, hashSize);
+	}
+	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const {
+		sserialize::UByteArrayAdapter tmp(sserialize::MM_PROGRAM_MEMORY);
+		tmp << *this;
+		return tmp.size();
+	}
+	HashFunction const & hash() const { return m_perms.front(); }
+	///Estimated number of distinct elements of the set with signature @param sig, see MinWiseSignatureGenerator::cardinality()
+	///Only bins holding their own minimum are used. With empty bins this is linear counting,
+	///otherwise each bin is the minimum of about n/SignatureSize uniform values.
+	double cardinality(Signature const & sig) const {
+		double width = hash().range()/SignatureSize;
+		double sum = 0;
+		size_type count = 0;
+		for(size_type i(0); i < SignatureSize; ++i) {
+			if (sig.at(i) != std::numeric_limits<entry_type>::max() && bin(sig.at(i)) == i) {
+				sum += (double(sig.at(i)) - i*width)/width;
+				++count;
+			}
+		}
+		if (count < SignatureSize) {
+			return -double(SignatureSize)*std::log(1.0 - double(count)/SignatureSize);
+		}
+		return sum > 0 ? SignatureSize*(count-1)/sum : std::numeric_limits<double>::max();
+	}
+public:
+	template<typename T>
+	Signature operator()(T const & x) const {
+		Signature sig;
+		add(sig, x);
+		densify(sig);
+		return sig;
+	}
+
+	template<typename T_ITERATOR>
+	Signature operator()(T_ITERATOR begin, T_ITERATOR end) const {
+		Signature sig;
+		for (; begin != end; ++begin) {
+			add(sig, *begin);
+		}
+		densify(sig);
+		return sig;
+	}
+	///Bin of the hash value @param h
+	static inline size_type bin(entry_type h) {
+		using double_type = typename detail::MinWisePermutation::EntryType<2*SignatureEntryBits>::type;
+		return size_type( (double_type(h)*SignatureSize) >> SignatureEntryBits );
+	}
+	///Fill the empty bins, i.e. those with the maximum value, of @param sig
+	void densify(Signature & sig) const {
+		std::array<bool, SignatureSize> empty;
+		size_type nonEmpty = 0;
+		for(size_type i(0); i < SignatureSize; ++i) {
+			empty[i] = sig.at(i) == std::numeric_limits<entry_type>::max();
+			nonEmpty += !empty[i];
+		}
+		if (!nonEmpty || nonEmpty == SignatureSize) {
+			return;
+		}
+		for(size_type i(0); i < SignatureSize; ++i) {
+			if (!empty[i]) {
+				continue;
+			}
+			size_type src = SignatureSize;
+			//the expected number of probes is SignatureSize/nonEmpty, rotate to the next non-empty bin in the unlikely case that they fail
+			for(uint32_t attempt(0); attempt < 4*SignatureSize && src == SignatureSize; ++attempt) {
+				size_type j = (uint64_t( mix(i, attempt) >> 32 )*SignatureSize) >> 32;
+				if (!empty[j]) {
+					src = j;
+				}
+			}
+			for(size_type j(i+1); src == SignatureSize; ++j) {
+				if (!empty[j%SignatureSize]) {
+					src = j%SignatureSize;
+				}
+			}
+			sig.at(i) = sig.at(src);
+		}
+	}
+private:
+	template<typename T>
+	inline void add(Signature & sig, T const & x) const {
+		entry_type h = m_perms.front()(x);
+		entry_type & e = sig.data()[bin(h)];
+		e = std::min(e, h);
+	}
+	///splitmix64 finalizer of the seeded probe position
+	inline uint64_t mix(size_type i, uint32_t attempt) const {
+		uint64_t z = m_seed + ((uint64_t(i) << 32) | attempt) * 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+	void init(CryptoPP::RandomNumberGenerator & rng, size_type hashSize) {
+		m_perms.emplace_back(rng, hashSize);
+		rng.GenerateBlock(reinterpret_cast<unsigned char*>(&m_seed), sizeof(m_seed));
+	}
+private:
+	template<std::size_t U, std::size_t V, typename W>
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, MinWiseSignatureGenerator<U, V, detail::MinWisePermutation::OnePermutation<W>>  const & v);
+	template<std::size_t U, std::size_t V, typename W>
+	friend sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, MinWiseSignatureGenerator<U, V, detail::MinWisePermutation::OnePermutation<W>>  & v);
+private:
+	//a single hash function, stored like the permutations of the general generator
+	std::vector<HashFunction> m_perms;
+	//seed of the probe sequences used for densification
+	uint64_t m_seed{0};
+};
+
+template<std::size_t U, std::size_t V, typename W>
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, MinWiseSignatureGenerator<U, V, detail::MinWisePermutation::OnePermutation<W>> const & v) {
+	return dest << v.m_perms << v.m_seed;
+}
+
+template<std::size_t U, std::size_t V, typename W>
+sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, MinWiseSignatureGenerator<U, V, detail::MinWisePermutation::OnePermutation<W>> & v) {
+	return dest >> v.m_perms >> v.m_seed;
 }
 
 namespace detail::MinWisePermutation {
 	
-//by default we assume that x is iterable
+///Interprets the string as little endian number modulo the prime
+///Bytes are folded a word at a time with a single modulo operation per word
 template<std::size_t T_ENTRY_BITS>
 class Converter<T_ENTRY_BITS, std::string, void> {
 public:
@@ -358,17 +1093,36 @@ public:
 	using value_type = std::string;
 	using entry_type = typename EntryType<entry_bits>::type;
 	using computation_type = typename EntryType<entry_bits+8+2>::type;
+	///Number of bytes that can be shifted into the result without overflow
+	static constexpr std::size_t chunk_size = std::min<std::size_t>(8, (8*sizeof(computation_type)-entry_bits)/8);
 public:
 	Converter(std::size_t prime) : m_p(prime) {}
 	std::size_t operator()(value_type const & v) {
 		computation_type result = 0;
-		for(auto it(v.rbegin()), end(v.rend()); it != end; ++it) {
-			result <<= 8;
-			result += uint8_t(*it);
+		std::size_t s = v.size();
+		//most significant, possibly partial, chunk first
+		std::size_t first = s%chunk_size;
+		std::size_t pos = s;
+		if (first) {
+			pos -= first;
+			result = chunk(v, pos, first) % m_p;
+		}
+		while (pos) {
+			pos -= chunk_size;
+			result <<= 8*chunk_size;
+			result += chunk(v, pos, chunk_size);
 			result %= m_p;
 		}
 		return result;
 	}
+private:
+	static inline computation_type chunk(value_type const & v, std::size_t pos, std::size_t len) {
+		uint64_t c = 0;
+		for(std::size_t i(len); i > 0; --i) {
+			c = (c << 8) | uint8_t(v[pos+i-1]);
+		}
+		return c;
+	}
 private:
 	std::size_t m_p;
 };
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+///Elementwise kernels of MinWiseSignature.
+///With AVX2 (i.e. -mavx2 or -march=native) 8, 16, 32 and 64 bit entries are processed 32 bytes at a time,
+///everything else and the tail of a signature that does not fill a whole register are processed by the scalar loop.
+namespace srtree::detail::MinWiseSignatureKernels {
+
+#if defined(__AVX2__)
+
+template<typename T>
+struct Avx2 {
+	static constexpr bool enabled = false;
+};
+
+template<>
+struct Avx2<uint8_t> {
+	static constexpr bool enabled = true;
+	static inline __m256i min(__m256i a, __m256i b) { return _mm256_min_epu8(a, b); }
+	static inline __m256i cmpeq(__m256i a, __m256i b) { return _mm256_cmpeq_epi8(a, b); }
+};
+
+template<>
+struct Avx2<uint16_t> {
+	static constexpr bool enabled = true;
+	static inline __m256i min(__m256i a, __m256i b) { return _mm256_min_epu16(a, b); }
+	static inline __m256i cmpeq(__m256i a, __m256i b) { return _mm256_cmpeq_epi16(a, b); }
+};
+
+template<>
+struct Avx2<uint32_t> {
+	static constexpr bool enabled = true;
+	static inline __m256i min(__m256i a, __m256i b) { return _mm256_min_epu32(a, b); }
+	static inline __m256i cmpeq(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(a, b); }
+};
+
+template<>
+struct Avx2<uint64_t> {
+	static constexpr bool enabled = true;
+	///There is no unsigned 64 bit min in AVX2: flip the sign bits and use the signed compare
+	static inline __m256i min(__m256i a, __m256i b) {
+		__m256i const sign = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+		__m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+		return _mm256_blendv_epi8(a, b, gt);
+	}
+	static inline __m256i cmpeq(__m256i a, __m256i b) { return _mm256_cmpeq_epi64(a, b); }
+};
+
+template<typename T>
+inline __m256i load(T const * src) {
+	return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src));
+}
+
+template<typename T>
+inline void store(T * dest, __m256i v) {
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), v);
+}
+
+///Number of entries that are processed by the vector loop
+template<typename T, std::size_t N>
+constexpr std::size_t vectorized() {
+	if constexpr (Avx2<T>::enabled) {
+		return N - N%(32/sizeof(T));
+	}
+	else {
+		return 0;
+	}
+}
+
+#else
+
+template<typename T, std::size_t N>
+constexpr std::size_t vectorized() {
+	return 0;
+}
+
+#endif
+
+///dest[i] = min(dest[i], src[i]) for i in [0, N)
+template<typename T, std::size_t N>
+inline void minInto(T * dest, T const * src) {
+	constexpr std::size_t V = vectorized<T, N>();
+#if defined(__AVX2__)
+	if constexpr (V > 0) {
+		for(std::size_t i(0); i < V; i += 32/sizeof(T)) {
+			store(dest+i, Avx2<T>::min(load(dest+i), load(src+i)));
+		}
+	}
+#endif
+	for(std::size_t i(V); i < N; ++i) {
+		dest[i] = std::min(dest[i], src[i]);
+	}
+}
+
+///dest[i] = min(dest[i], s.data()[i]) for all signatures s in [begin, end) and i in [0, N)
+///Each block of dest stays in a register while it is reduced over all signatures.
+template<typename T, std::size_t N, typename T_ITERATOR>
+inline void minInto(T * dest, T_ITERATOR begin, T_ITERATOR end) {
+	constexpr std::size_t V = vectorized<T, N>();
+#if defined(__AVX2__)
+	if constexpr (V > 0) {
+		for(std::size_t i(0); i < V; i += 32/sizeof(T)) {
+			__m256i acc = load(dest+i);
+			for(T_ITERATOR it(begin); it != end; ++it) {
+				acc = Avx2<T>::min(acc, load((*it).data()+i));
+			}
+			store(dest+i, acc);
+		}
+	}
+#endif
+	if constexpr (V < N) {
+		for(T_ITERATOR it(begin); it != end; ++it) {
+			T const * src = (*it).data();
+			for(std::size_t i(V); i < N; ++i) {
+				dest[i] = std::min(dest[i], src[i]);
+			}
+		}
+	}
+}
+
+///Number of i in [0, N) with a[i] == b[i]
+template<typename T, std::size_t N>
+inline std::size_t equalCount(T const * a, T const * b) {
+	constexpr std::size_t V = vectorized<T, N>();
+	std::size_t result = 0;
+#if defined(__AVX2__)
+	if constexpr (V > 0) {
+		for(std::size_t i(0); i < V; i += 32/sizeof(T)) {
+			uint32_t mask = _mm256_movemask_epi8(Avx2<T>::cmpeq(load(a+i), load(b+i)));
+			result += __builtin_popcount(mask);
+		}
+		//movemask has one bit per byte
+		result /= sizeof(T);
+	}
+#endif
+	for(std::size_t i(V); i < N; ++i) {
+		result += a[i] == b[i];
+	}
+	return result;
+}
+
+///Number of i in [0, N) with a[i] == b[i] and number of i with b[i] <= a[i] in a single pass
+///The latter is the number of equal entries of b and the elementwise minimum of a and b.
+template<typename T, std::size_t N>
+inline std::pair<std::size_t, std::size_t> equalAndNotLessCount(T const * a, T const * b) {
+	constexpr std::size_t V = vectorized<T, N>();
+	std::size_t eq = 0;
+	std::size_t le = 0;
+#if defined(__AVX2__)
+	if constexpr (V > 0) {
+		for(std::size_t i(0); i < V; i += 32/sizeof(T)) {
+			__m256i va = load(a+i);
+			__m256i vb = load(b+i);
+			eq += __builtin_popcount(uint32_t(_mm256_movemask_epi8(Avx2<T>::cmpeq(va, vb))));
+			le += __builtin_popcount(uint32_t(_mm256_movemask_epi8(Avx2<T>::cmpeq(Avx2<T>::min(va, vb), vb))));
+		}
+		//movemask has one bit per byte
+		eq /= sizeof(T);
+		le /= sizeof(T);
+	}
+#endif
+	for(std::size_t i(V); i < N; ++i) {
+		eq += a[i] == b[i];
+		le += b[i] <= a[i];
+	}
+	return std::make_pair(eq, le);
+}
+
+///dest[i] = b[i] + sum_k a[k][i]*w[k] modulo 2^64 for i in [0, N) and k in [0, n)
+///Each block of dest stays in a register while all products are added.
+///AVX2 has no 64 bit multiplication, the product is composed of the 32x32 bit products of both halves of a[k][i].
+///A positive T_N fixes the number of products at compile time, n has to be T_N then.
+template<std::size_t N, std::size_t T_N = 0>
+inline void multiplyAdd(uint64_t * __restrict dest, uint64_t const * b, uint64_t const * const * a, uint32_t const * w, std::size_t n) {
+	if constexpr (T_N > 0) {
+		n = T_N;
+	}
+	constexpr std::size_t V = vectorized<uint64_t, N>();
+#if defined(__AVX2__)
+	if constexpr (V > 0) {
+		for(std::size_t i(0); i < V; i += 4) {
+			__m256i acc = load(b+i);
+			for(std::size_t k(0); k < n; ++k) {
+				__m256i va = load(a[k]+i);
+				__m256i vw = _mm256_set1_epi64x(w[k]);
+				__m256i lo = _mm256_mul_epu32(va, vw);
+				__m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(va, 32), vw);
+				acc = _mm256_add_epi64(acc, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+			}
+			store(dest+i, acc);
+		}
+	}
+#endif
+	for(std::size_t i(V); i < N; ++i) {
+		uint64_t acc = b[i];
+		for(std::size_t k(0); k < n; ++k) {
+			acc += a[k][i]*w[k];
+		}
+		dest[i] = acc;
+	}
+}
+
+///Polynomials modulo 32 bit primes in Montgomery form with R = 2^32 for all i in [0, N):
+///dest[i] is the value of the polynomial with the coefficients c[j*N+i], j in [0, degree), highest degree first,
+///at the number with the 32 bit words w[0], ..., w[nw-1], most significant first, modulo p[i].
+///pinv[i] is -p[i]^-1 mod R and r2[i] is R^2 mod p[i], the coefficients are in Montgomery form, dest is not.
+///With AVX2 four permutations are evaluated at once with the 32x32 bit products of _mm256_mul_epu32.
+template<std::size_t N>
+inline void montgomeryPolynomial(uint32_t * dest, uint32_t const * w, std::size_t nw, uint32_t const * c, std::size_t degree, uint32_t const * p, uint32_t const * pinv, uint32_t const * r2) {
+	constexpr std::size_t V = vectorized<uint64_t, N>();
+#if defined(__AVX2__)
+	if constexpr (V > 0) {
+		auto load32 = [](uint32_t const * src) {
+			return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const *>(src)));
+		};
+		//u - p if u >= p
+		auto fix = [](__m256i u, __m256i vp) {
+			return _mm256_blendv_epi8(_mm256_sub_epi64(u, vp), u, _mm256_cmpgt_epi64(vp, u));
+		};
+		//t*R^-1 mod p for t < p*R
+		auto reduce = [&fix](__m256i t, __m256i vp, __m256i vpinv) {
+			__m256i m = _mm256_mul_epu32(t, vpinv);
+			return fix(_mm256_srli_epi64(_mm256_add_epi64(t, _mm256_mul_epu32(m, vp)), 32), vp);
+		};
+		__m256i const pack = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+		for(std::size_t i(0); i < V; i += 4) {
+			__m256i vp = load32(p+i);
+			__m256i vpinv = load32(pinv+i);
+			__m256i vr2 = load32(r2+i);
+			__m256i x = _mm256_setzero_si256();
+			for(std::size_t k(0); k < nw; ++k) {
+				__m256i wk = reduce(_mm256_mul_epu32(_mm256_set1_epi64x(w[k]), vr2), vp, vpinv);
+				x = fix(_mm256_add_epi64(reduce(_mm256_mul_epu32(x, vr2), vp, vpinv), wk), vp);
+			}
+			__m256i r = load32(c+i);
+			for(std::size_t j(1); j < degree; ++j) {
+				r = fix(_mm256_add_epi64(reduce(_mm256_mul_epu32(r, x), vp, vpinv), load32(c+j*N+i)), vp);
+			}
+			r = _mm256_permutevar8x32_epi32(reduce(r, vp, vpinv), pack);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dest+i), _mm256_castsi256_si128(r));
+		}
+	}
+#endif
+	for(std::size_t i(V); i < N; ++i) {
+		auto fix = [p, i](uint64_t u) { return uint32_t(u >= p[i] ? u - p[i] : u); };
+		auto reduce = [&](uint64_t t) {
+			uint32_t m = uint32_t(t)*pinv[i];
+			return fix( (t + uint64_t(m)*p[i]) >> 32 );
+		};
+		uint32_t x = 0;
+		for(std::size_t k(0); k < nw; ++k) {
+			x = fix(uint64_t(reduce(uint64_t(x)*r2[i])) + reduce(uint64_t(w[k])*r2[i]));
+		}
+		uint32_t r = c[i];
+		for(std::size_t j(1); j < degree; ++j) {
+			r = fix(uint64_t(reduce(uint64_t(r)*x)) + c[j*N+i]);
+		}
+		dest[i] = reduce(r);
+	}
+}
+
+}//end namespace srtree::detail::MinWiseSignatureKernels
@@ -2,6 +2,7 @@
 
 #include <srtree/MinWiseSignature.h>
 #include <srtree/QGram.h>
+#include <srtree/PredicateProgram.h>
 
 #include <boost/rational.hpp>
 
@@ -21,6 +22,9 @@ public:
 	using Signature = MinWiseSignature<SignatureSize, HashFunction::entry_bits>;
 	using SignatureGenerator = MinWiseSignatureGenerator<SignatureSize, HashFunction::entry_bits, HashFunction>;
 	using QType = uint8_t;
+	///Set in the serialized q if the q-grams are hashed by their QGramFingerprints instead of as strings.
+	///Trees serialized without it keep hashing strings.
+	static constexpr QType FingerprintFlag = 0x80;
 	
 	class Serializer {
 	public:
@@ -47,7 +51,7 @@ public:
 		
 		template<typename Iterator>
 		Signature operator()(Iterator begin, Iterator end) const {
-			return sserialize::treeReduce<Iterator, Signature>(begin, end,*this);
+			return Signature::combine(begin, end);
 		}
 	};
 	
@@ -57,68 +61,45 @@ public:
 		}
 	};
 	
+	///Estimate of the fraction of q-grams in the union of @param base and @param toAdd that are not in @param base
+	///These are exactly the entries of @param base that change when combined with @param toAdd
+	struct Enlargement {
+		double operator()(Signature const & base, Signature const & toAdd) const {
+			return 1.0 - boost::rational_cast<double>(Resemblence()(base, base + toAdd));
+		}
+	};
+	
 	class MayHaveMatch final {
 	public:
-		MayHaveMatch(MayHaveMatch const &);
-		MayHaveMatch(MayHaveMatch &&);
+		MayHaveMatch(MayHaveMatch const &) = default;
+		MayHaveMatch(MayHaveMatch &&) = default;
 		MayHaveMatch & operator=(MayHaveMatch const&) = default;
 		MayHaveMatch & operator=(MayHaveMatch &&) = default;
-		~MayHaveMatch();
+		~MayHaveMatch() {}
 	public:
 		bool operator()(Signature const & ns) const;
 		MayHaveMatch operator/(MayHaveMatch const & other) const;
 		MayHaveMatch operator+(MayHaveMatch const & other) const;
 	private:
-		struct Node {
-			enum Type {LEAF, INTERSECT, UNITE};
-			virtual ~Node() {}
-			virtual bool matches(MayHaveMatch const & parent, Signature const & v) = 0;
-			virtual std::unique_ptr<Node> copy() const = 0;
-		};
-		class IntersectNode: public Node {
-		public:
-			IntersectNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			~IntersectNode() override;
-		public:
-			bool matches(MayHaveMatch const & parent, Signature const & v) override;
-			std::unique_ptr<Node> copy() const override;
-		private:
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-		};
-		class UniteNode: public Node {
-		public:
-			UniteNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			~UniteNode() override;
-		public:
-			bool matches(MayHaveMatch const & parent, Signature const & v) override;
-			std::unique_ptr<Node> copy() const override;
-		private:
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-		};
-		class LeafNode: public Node {
+		class LeafNode {
 		public:
 			LeafNode(Signature const & ref, QGram const & qg, std::size_t editDistance);
-			~LeafNode() override;
 		public:
-			bool matches(MayHaveMatch const & parent, Signature const & v) override;
-			std::unique_ptr<Node> copy() const override;
+			bool matches(Signature const & v) const;
 		private:
 			Signature m_ref;
-			QGram m_qg;
-			uint32_t m_ed;
 			int32_t m_th;
+			//number of q-grams of the reference
+			int64_t m_n;
 		};
+		using Program = PredicateProgram<LeafNode>;
 	private:
 		friend class MinWiseSignatureTraits;
 	private:
 		MayHaveMatch(Signature const & ref, QGram const & qg, std::size_t editDistance);
-		MayHaveMatch(std::unique_ptr<Node> && t);
+		MayHaveMatch(Program && p);
 	private:
-		Combine m_c;
-		Resemblence m_r;
-		std::unique_ptr<Node> m_t;
+		Program m_p;
 	};
 	
 	class EditDistance {
@@ -142,14 +123,20 @@ public:
 public:
 	MinWiseSignatureTraits() : MinWiseSignatureTraits(3) {}
 	MinWiseSignatureTraits(sserialize::UByteArrayAdapter d) {
-		d >> m_q >> m_sg;
+		d >> *this;
 	}
 	MinWiseSignatureTraits(std::size_t q) : MinWiseSignatureTraits(q, 2) {}
-	MinWiseSignatureTraits(std::size_t q, std::size_t hashSize) : m_q(q), m_sg(hashSize) {}
+	MinWiseSignatureTraits(std::size_t q, std::size_t hashSize) : m_q(q), m_sg(hashSize) {
+		if (q < 1 || q >= FingerprintFlag) {
+			throw sserialize::PreconditionViolationException("MinWiseSignatureTraits: q has to be in [1, 127]");
+		}
+	}
 	MinWiseSignatureTraits(MinWiseSignatureTraits && other) = default;
 	virtual ~MinWiseSignatureTraits() {}
 	MinWiseSignatureTraits & operator=(MinWiseSignatureTraits && other) = default;
 	QType q() const { return m_q; }
+	///True if the q-grams are hashed by their QGramFingerprints
+	bool fingerprints() const { return m_fingerprints; }
 	SignatureGenerator const & sg() const { return m_sg; }
 	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const {
 		return sserialize::SerializationInfo<QType>::sizeInBytes(q())
@@ -157,10 +144,10 @@ public:
 	}
 public:
 	Combine combine() const { return Combine(); }
+	Enlargement enlargement() const { return Enlargement(); }
 	MayHaveMatch mayHaveMatch(std::string const & str, std::size_t editDistance) const {
 		QGram qg(str, m_q);
-		Signature sig = m_sg(qg.begin(), qg.end());
-		return MayHaveMatch(sig, qg, editDistance);
+		return MayHaveMatch(signature(qg), qg, editDistance);
 	}
 	Serializer serializer() const { return Serializer(); }
 	Deserializer deserializer() const { return Deserializer(); }
@@ -169,9 +156,21 @@ public:
 		if (!str.size()) {
 			throw sserialize::PreconditionViolationException("Empty string is not allowed!");
 		}
+		if (m_fingerprints) {
+			QGramFingerprints qf(str, m_q);
+			return m_sg(qf.begin(), qf.end());
+		}
 		QGram qg(str, m_q);
 		return m_sg(qg.begin(), qg.end());
 	}
+	///Signature of the q-grams @param qg, q has to be the one of the traits
+	Signature signature(QGram const & qg) const {
+		if (m_fingerprints) {
+			QGramFingerprints qf(qg.base(), qg.q());
+			return m_sg(qf.begin(), qf.end());
+		}
+		return m_sg(qg.begin(), qg.end());
+	}
 	template<typename T_STRING_ITERATOR>
 	Signature signature(T_STRING_ITERATOR begin, T_STRING_ITERATOR end) const {
 		if (begin == end) {
@@ -191,17 +190,23 @@ private:
 	friend sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, srtree::detail::MinWiseSignatureTraits<U, V> & v);
 private:
 	QType m_q; //the q in q-grams
+	bool m_fingerprints{true};
 	SignatureGenerator m_sg;
 };
 
 template<std::size_t T_SIZE, typename T_PARAMETRISED_HASH_FUNCTION>
 sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, srtree::detail::MinWiseSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION> const & v) {
-	return dest << v.q() << v.sg();
+	using Traits = srtree::detail::MinWiseSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION>;
+	return dest << typename Traits::QType(v.q() | (v.fingerprints() ? Traits::FingerprintFlag : 0)) << v.sg();
 }
 
 template<std::size_t T_SIZE, typename T_PARAMETRISED_HASH_FUNCTION>
 sserialize::UByteArrayAdapter & operator>>(sserialize::UByteArrayAdapter & dest, srtree::detail::MinWiseSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION> & v) {
-	return dest >> v.m_q >> v.m_sg;
+	using Traits = srtree::detail::MinWiseSignatureTraits<T_SIZE, T_PARAMETRISED_HASH_FUNCTION>;
+	dest >> v.m_q >> v.m_sg;
+	v.m_fingerprints = v.m_q & Traits::FingerprintFlag;
+	v.m_q &= ~Traits::FingerprintFlag;
+	return dest;
 }
 
 }//end namespace srtree::detail
@@ -215,129 +220,56 @@ namespace srtree::detail {
 
 MWSIGTRAITS_TML_HDR
 MWSIGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(Signature const & ref, QGram const & qg, std::size_t editDistance) :
-m_t( new LeafNode(ref, qg, editDistance) )
-{}
-
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(std::unique_ptr<Node> && t) :
-m_t(std::move(t))
+m_p( LeafNode(ref, qg, editDistance) )
 {}
 
 MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(MayHaveMatch const & other) :
-m_t(other.m_t->copy())
+MWSIGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(Program && p) :
+m_p(std::move(p))
 {}
 
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(MayHaveMatch && other) :
-m_t(std::move(other.m_t))
-{}
-
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::~MayHaveMatch() {}
-
 MWSIGTRAITS_TML_HDR
 bool
 MWSIGRAMTRAITS_CLS::MayHaveMatch::operator()(Signature const & ns) const {
-	return m_t->matches(*this, ns);
+	return m_p([&ns](LeafNode const & leaf) { return leaf.matches(ns); });
 }
 
 MWSIGTRAITS_TML_HDR
 typename MWSIGRAMTRAITS_CLS::MayHaveMatch
 MWSIGRAMTRAITS_CLS::MayHaveMatch::operator/(MayHaveMatch const & other) const {
-	auto nt = std::unique_ptr<Node>( new IntersectNode(m_t->copy(), other.m_t->copy()) );
-	return MayHaveMatch(std::move(nt));
+	return MayHaveMatch(m_p / other.m_p);
 }
 
 MWSIGTRAITS_TML_HDR
 typename MWSIGRAMTRAITS_CLS::MayHaveMatch
 MWSIGRAMTRAITS_CLS::MayHaveMatch::operator+(MayHaveMatch const & other) const {
-	auto nt = std::unique_ptr<Node>( new UniteNode(m_t->copy(), other.m_t->copy()) );
-	return MayHaveMatch(std::move(nt));
-}
-
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::IntersectNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second) :
-first(std::move(first)),
-second(std::move(second))
-{}
-
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::~IntersectNode()
-{}
-
-MWSIGTRAITS_TML_HDR
-bool
-MWSIGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::matches(MayHaveMatch const & parent, Signature const & v) {
-	return first->matches(parent, v) && second->matches(parent, v);
-}
-
-MWSIGTRAITS_TML_HDR
-std::unique_ptr<typename MWSIGRAMTRAITS_CLS::MayHaveMatch::Node>
-MWSIGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::copy() const {
-	return std::unique_ptr<Node>( new IntersectNode(first->copy(), second->copy()) );
-}
-
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::UniteNode::UniteNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second) :
-first(std::move(first)),
-second(std::move(second))
-{}
-
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::UniteNode::~UniteNode() {}
-
-MWSIGTRAITS_TML_HDR
-std::unique_ptr<typename MWSIGRAMTRAITS_CLS::MayHaveMatch::Node>
-MWSIGRAMTRAITS_CLS::MayHaveMatch::UniteNode::copy() const {
-	return std::unique_ptr<Node>( new UniteNode(first->copy(), second->copy()) );
-}
-
-MWSIGTRAITS_TML_HDR
-bool
-MWSIGRAMTRAITS_CLS::MayHaveMatch::UniteNode::matches(MayHaveMatch const & parent, Signature const & v) {
-	return first->matches(parent, v) || second->matches(parent, v);
+	return MayHaveMatch(m_p + other.m_p);
 }
 
 MWSIGTRAITS_TML_HDR
 MWSIGRAMTRAITS_CLS::MayHaveMatch::LeafNode::LeafNode(Signature const & ref, QGram const & qg, std::size_t editDistance) :
 m_ref(ref),
-m_qg(qg),
-m_ed(editDistance),
-m_th(int32_t(m_qg.base().size() + m_qg.q() - 1) - int32_t(m_ed * m_qg.q()))
-{}
-
-MWSIGTRAITS_TML_HDR
-MWSIGRAMTRAITS_CLS::MayHaveMatch::LeafNode::~LeafNode()
+m_th(int32_t(qg.base().size() + qg.q() - 1) - int32_t(editDistance * qg.q())),
+m_n(qg.size())
 {}
 
 MWSIGTRAITS_TML_HDR
 bool
-MWSIGRAMTRAITS_CLS::MayHaveMatch::LeafNode::matches(MayHaveMatch const & p, Signature const & ns) {
+MWSIGRAMTRAITS_CLS::MayHaveMatch::LeafNode::matches(Signature const & ns) const {
 	//This may lead to false negatives since the signature only gives us an estimation.
 	//The question is if we can bound the error made by the estimation such that we can rule out false negatives and only produce false positives
 	//g = g_u \cup g_\sigma
 	//\roh(g_u, g_\sigma) / \roh(g, g_sigma) * |g_\sigma| 
 	//
-
-	auto g = p.m_c(ns, m_ref);
-	auto roh_g_ref = p.m_r(g, m_ref);
-	
-	if (roh_g_ref == 0) {
+	//With g = ns + ref both resemblences have the signature size as denominator, hence
+	//\roh(ns, ref) * |g_\sigma| / \roh(g, ref) >= th is eq * |g_\sigma| >= th * eq_g with the numbers of equal entries eq and eq_g.
+	//Entries of g equal the ones of ref iff ref is not larger than ns, both counts are computed in a single pass.
+	using entry_type = typename Signature::entry_type;
+	auto counts = MinWiseSignatureKernels::equalAndNotLessCount<entry_type, Signature::size>(ns.data(), m_ref.data());
+	if (counts.second == 0) {
 		return true;
 	}
-	else {
-		auto roh_ns_ref = p.m_r(ns, m_ref) * int64_t(m_qg.size());
-		auto g_u_int_g_sigma_size = roh_ns_ref/roh_g_ref;
-// 		auto th = int64_t(m_qg.base().size() + m_qg.q() - 1) - int64_t(m_ed * m_qg.q());
-		return g_u_int_g_sigma_size >= m_th;
-	}
-}
-
-MWSIGTRAITS_TML_HDR
-std::unique_ptr<typename MWSIGRAMTRAITS_CLS::MayHaveMatch::Node>
-MWSIGRAMTRAITS_CLS::MayHaveMatch::LeafNode::copy() const {
-	return std::unique_ptr<Node>( new LeafNode(m_ref, m_qg, m_ed) );
+	return int64_t(counts.first) * m_n >= int64_t(m_th) * int64_t(counts.second);
 }
 
 }//end namespae srtree::detail
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <limits>
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
+
+#include <sserialize/storage/UByteArrayAdapter.h>
+#include <sserialize/containers/OOMArray.h>
+#include <sserialize/algorithm/oom_algorithm.h>
+#include <sserialize/utility/exceptions.h>
+
+#include <srtree/Static/SRTree.h>
+
+namespace srtree {
+
+///Builds the static representation of an SRTree without ever holding the tree or the items in memory.
+///
+///Items are streamed to disk by insert(), their signatures go to a file-based store.
+///serialize() then
+/// - sorts the items externally along the Hilbert curve of the centers of their boundaries,
+/// - packs consecutive items into leafs and consecutive nodes of each level into the nodes of the next level, bottom-up,
+/// - writes the levels top-down in the format of srtree::Static::SRTree.
+///
+///The nodes of a level are distributed evenly over its parents, hence all nodes but the root have at least MaxLoad/2 children.
+///Half of the memory budget is used for sorting, the other half is split evenly between the buffers of all temporary arrays
+///that can be in use at the same time, see maxRecordArrays(). The signatures of at most MaxLoad nodes are in memory at any time.
+///The budget does not cover these signatures, the pages of the file-based signature store cached by the OS
+///and the minimum buffer of one record per array, which matters only for very small budgets.
+///
+///The Boundary has to be a sserialize::spatial::GeoRect.
+///Signatures are stored with operator<< and read back with a constructor taking a sserialize::UByteArrayAdapter,
+///arithmetic signatures with operator>>.
+///Traits are not copied and have to outlive the builder.
+template<
+	typename TSignatureTraits,
+	typename TGeometryTraits,
+	uint8_t TMaxLoad = 32
+>
+class OOMSRTreeBuilder final {
+public:
+	static constexpr uint8_t MaxLoad = TMaxLoad;
+	static_assert(2 <= MaxLoad);
+	static constexpr std::size_t DefaultMemoryBudget = std::size_t(1) << 30;
+public:
+	using SignatureTraits = TSignatureTraits;
+	using Signature = typename SignatureTraits::Signature;
+	using SignatureCombine = typename SignatureTraits::Combine;
+
+	using GeometryTraits = TGeometryTraits;
+	using Boundary = typename GeometryTraits::Boundary;
+
+	using ItemType = uint32_t;
+
+	struct ItemDescription {
+		Boundary boundary;
+		Signature signature;
+		ItemType item;
+	};
+public:
+	///@param memoryBudget in bytes
+	OOMSRTreeBuilder(SignatureTraits & straits, GeometryTraits & gtraits, std::size_t memoryBudget = DefaultMemoryBudget);
+	OOMSRTreeBuilder(OOMSRTreeBuilder const &) = delete;
+	~OOMSRTreeBuilder() {}
+public:
+	inline SignatureTraits const & straits() const { return m_straits; }
+	inline SignatureTraits & straits() { return m_straits; }
+	inline GeometryTraits const & gtraits() const { return m_gtraits; }
+	inline GeometryTraits & gtraits() { return m_gtraits; }
+	inline std::size_t memoryBudget() const { return m_mb; }
+	inline std::size_t size() const { return m_items.size(); }
+public:
+	///Thread-safe
+	void insert(Boundary const & b, Signature const & sig, ItemType const & item);
+	void insert(ItemDescription const & d);
+	///Sort and pack the items and write the tree to @param dest.
+	///No items may be inserted afterwards
+	///@param numThreads used for sorting, 0 uses all hardware threads
+	sserialize::UByteArrayAdapter & serialize(sserialize::UByteArrayAdapter & dest, uint32_t numThreads = 0);
+private:
+	///Items and nodes on disk
+	struct Record {
+		uint64_t key{0}; //position on the hilbert curve, only used by items
+		double minLat{0};
+		double maxLat{0};
+		double minLon{0};
+		double maxLon{0};
+		sserialize::UByteArrayAdapter::OffsetType sig{0}; //offset into the signature store
+		ItemType item{0};
+
+		Boundary boundary() const { return Boundary(minLat, maxLat, minLon, maxLon); }
+		void setBoundary(Boundary const & b) {
+			minLat = b.minLat();
+			maxLat = b.maxLat();
+			minLon = b.minLon();
+			maxLon = b.maxLon();
+		}
+	};
+	using RecordArray = sserialize::OOMArray<Record>;
+	using RecordArrayPtr = std::unique_ptr<RecordArray>;
+	///Number of parents of a level with @param count nodes
+	static inline std::size_t numParents(std::size_t count) { return (count + MaxLoad - 1)/MaxLoad; }
+	///Number of children of parent @param i of a level with @param count nodes
+	static inline std::size_t numChildren(std::size_t count, std::size_t i) {
+		std::size_t np = numParents(count);
+		return count/np + (i < count%np);
+	}
+	///Position of the first child of parent @param i within a level of @param count nodes
+	static inline std::size_t firstChild(std::size_t count, std::size_t i) {
+		std::size_t np = numParents(count);
+		return i*(count/np) + std::min(i, count%np);
+	}
+	///Position of (@param x, @param y) on the hilbert curve of order 32
+	static uint64_t hilbertIndex(uint32_t x, uint32_t y);
+	///Number of record arrays in use at the same time.
+	///These are the items and a temporary copy of them before sorting, or the items and all levels of page nodes.
+	static std::size_t maxRecordArrays();
+	///Memory used for sorting
+	inline std::size_t sortMemoryBudget() const { return m_mb - m_mb/2; }
+	RecordArrayPtr makeRecordArray() const;
+	sserialize::UByteArrayAdapter::OffsetType putSignature(Signature const & sig);
+	Signature signature(Record const & r) const;
+	///Pack the nodes in @param children into their parents
+	RecordArrayPtr pack(RecordArray & children);
+private:
+	SignatureTraits & m_straits;
+	GeometryTraits & m_gtraits;
+	std::size_t m_mb;
+	std::mutex m_lock;
+	Boundary m_b; //bounds of all items
+	RecordArrayPtr m_items;
+	sserialize::UByteArrayAdapter m_sigs;
+};
+
+#define MHR_TMPL_PARAMS template<typename TSignatureTraits, typename TGeometryTraits, uint8_t TMaxLoad>
+#define MHR_CLS_NAME OOMSRTreeBuilder<TSignatureTraits, TGeometryTraits, TMaxLoad>
+
+MHR_TMPL_PARAMS
+MHR_CLS_NAME::OOMSRTreeBuilder(SignatureTraits & straits, GeometryTraits & gtraits, std::size_t memoryBudget) :
+m_straits(straits),
+m_gtraits(gtraits),
+m_mb(memoryBudget),
+m_sigs(sserialize::UByteArrayAdapter::createCache(0, sserialize::MM_FILEBASED))
+{
+	m_items = makeRecordArray();
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::insert(Boundary const & b, Signature const & sig, ItemType const & item) {
+	Record r;
+	r.setBoundary(b);
+	r.item = item;
+	std::lock_guard<std::mutex> lck(m_lock);
+	r.sig = putSignature(sig);
+	m_b.enlarge(b);
+	m_items->push_back(r);
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::insert(ItemDescription const & d) {
+	insert(d.boundary, d.signature, d.item);
+}
+
+MHR_TMPL_PARAMS
+sserialize::UByteArrayAdapter &
+MHR_CLS_NAME::serialize(sserialize::UByteArrayAdapter & dest, uint32_t numThreads) {
+	using SSelf = srtree::Static::SRTree<SignatureTraits, GeometryTraits>;
+
+	if (!m_items->size()) {
+		throw sserialize::PreconditionViolationException("OOMSRTreeBuilder: no items");
+	}
+	if (!numThreads) {
+		numThreads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+	}
+
+	std::cout << "OOMSRTreeBuilder: Sorting items..." << std::flush;
+	{
+		double latScale = m_b.maxLat() > m_b.minLat() ? double(std::numeric_limits<uint32_t>::max())/(m_b.maxLat()-m_b.minLat()) : 0;
+		double lonScale = m_b.maxLon() > m_b.minLon() ? double(std::numeric_limits<uint32_t>::max())/(m_b.maxLon()-m_b.minLon()) : 0;
+		//the center of an item on the upper bound rounds to 2^32, converting that to uint32_t is undefined
+		auto grid = [](double v) {
+			return uint32_t(std::min(std::max(v, 0.0), double(std::numeric_limits<uint32_t>::max())));
+		};
+		RecordArrayPtr tmp = makeRecordArray();
+		for(auto it(m_items->begin()), end(m_items->end()); it != end; ++it) {
+			Record r = *it;
+			r.key = hilbertIndex(
+				grid(((r.minLat+r.maxLat)/2 - m_b.minLat())*latScale),
+				grid(((r.minLon+r.maxLon)/2 - m_b.minLon())*lonScale)
+			);
+			tmp->push_back(r);
+		}
+		m_items = std::move(tmp);
+		sserialize::oom_sort(m_items->begin(), m_items->end(), [](Record const & a, Record const & b) {
+			return a.key < b.key;
+		}, sortMemoryBudget(), numThreads, sserialize::MM_FILEBASED);
+	}
+	std::cout << "done" << std::endl;
+
+	//levels of page nodes bottom-up, levels[0] are the leafs
+	std::vector<RecordArrayPtr> levels;
+	std::cout << "OOMSRTreeBuilder: Packing nodes..." << std::flush;
+	levels.emplace_back(pack(*m_items));
+	while (levels.back()->size() > 1) {
+		levels.emplace_back(pack(*levels.back()));
+	}
+	std::cout << levels.size() << " levels" << std::endl;
+
+	std::size_t numInternalNodes = 0;
+	for(std::size_t i(1); i < levels.size(); ++i) {
+		numInternalNodes += levels[i]->size();
+	}
+
+	dest << sserialize::Static::SimpleVersion<2>();
+	dest.put<uint32_t>(levels.size()-1);
+	dest.put<uint32_t>(numInternalNodes);
+	dest.put<uint32_t>(levels.front()->size());
+	dest.put<uint32_t>(m_items->size());
+
+	//Nodes are stored top-down, level by level. The children of a level are the next level (or the items) in the same order
+	std::cout << "OOMSRTreeBuilder: Serializing nodes..." << std::flush;
+	sserialize::Static::ArrayCreator<typename SSelf::Node> nac(dest);
+	{
+		std::size_t levelBegin = 0; //id of the first node of the current level
+		for(std::size_t lvl(levels.size()); lvl > 0; --lvl) {
+			std::size_t ls = levels[lvl-1]->size();
+			std::size_t cs = lvl > 1 ? levels[lvl-2]->size() : m_items->size();
+			for(std::size_t i(0); i < ls; ++i) {
+				nac.put( typename SSelf::Node(levelBegin + ls + firstChild(cs, i), numChildren(cs, i)) );
+			}
+			levelBegin += ls;
+		}
+	}
+	nac.flush();
+	std::cout << nac.size() << std::endl;
+
+	std::cout << "OOMSRTreeBuilder: Serializing boundaries..." << std::flush;
+	sserialize::Static::ArrayCreator<typename GeometryTraits::Serializer::Type, typename GeometryTraits::Serializer> bac(dest, gtraits().serializer());
+	for(std::size_t lvl(levels.size()); lvl > 0; --lvl) {
+		for(auto it(levels[lvl-1]->begin()), end(levels[lvl-1]->end()); it != end; ++it) {
+			bac.put( (*it).boundary() );
+		}
+	}
+	for(auto it(m_items->begin()), end(m_items->end()); it != end; ++it) {
+		bac.put( (*it).boundary() );
+	}
+	bac.flush();
+	std::cout << bac.size() << std::endl;
+
+	std::cout << "OOMSRTreeBuilder: Serializing signatures..." << std::flush;
+	sserialize::Static::ArrayCreator<typename SignatureTraits::Serializer::Type, typename SignatureTraits::Serializer> sac(dest, straits().serializer());
+	for(std::size_t lvl(levels.size()); lvl > 0; --lvl) {
+		for(auto it(levels[lvl-1]->begin()), end(levels[lvl-1]->end()); it != end; ++it) {
+			sac.put( signature(*it) );
+		}
+	}
+	for(auto it(m_items->begin()), end(m_items->end()); it != end; ++it) {
+		sac.put( signature(*it) );
+	}
+	sac.flush();
+	std::cout << sac.size() << std::endl;
+
+	std::cout << "OOMSRTreeBuilder: Serializing items..." << std::flush;
+	sserialize::Static::ArrayCreator<ItemType> iac(dest);
+	for(auto it(m_items->begin()), end(m_items->end()); it != end; ++it) {
+		iac.put( (*it).item );
+	}
+	iac.flush();
+	std::cout << iac.size() << std::endl;
+	return dest;
+}
+
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::RecordArrayPtr
+MHR_CLS_NAME::pack(RecordArray & children) {
+	RecordArrayPtr result = makeRecordArray();
+	SignatureCombine combine = straits().combine();
+	std::vector<Signature> sigs;
+	sigs.reserve(MaxLoad);
+	std::size_t cs = children.size();
+	auto it = children.begin();
+	for(std::size_t i(0), s(numParents(cs)); i < s; ++i) {
+		Boundary b;
+		sigs.clear();
+		for(std::size_t j(0), js(numChildren(cs, i)); j < js; ++j, ++it) {
+			Record const & r = *it;
+			b.enlarge(r.boundary());
+			sigs.push_back(signature(r));
+		}
+		Record p;
+		p.setBoundary(b);
+		p.sig = putSignature(combine(sigs.begin(), sigs.end()));
+		result->push_back(p);
+	}
+	return result;
+}
+
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::RecordArrayPtr
+MHR_CLS_NAME::makeRecordArray() const {
+	auto result = std::make_unique<RecordArray>(sserialize::MM_FILEBASED);
+	//the back and the read buffer of each array get the same share of the budget left by sorting
+	std::size_t bufferSize = std::max<std::size_t>(1, (m_mb/2)/(2*maxRecordArrays()*sizeof(Record)));
+	result->backBufferSize(bufferSize);
+	result->readBufferSize(bufferSize);
+	return result;
+}
+
+MHR_TMPL_PARAMS
+std::size_t
+MHR_CLS_NAME::maxRecordArrays() {
+	//there are less than 2^32 items and each level has at most 1/2^k of the nodes of the level below with 2^k <= MaxLoad
+	std::size_t k = 0;
+	for(std::size_t x(MaxLoad); x > 1; x >>= 1) {
+		++k;
+	}
+	std::size_t maxLevels = (std::numeric_limits<ItemType>::digits + k - 1)/k;
+	return 1 + std::max<std::size_t>(1, maxLevels);
+}
+
+MHR_TMPL_PARAMS
+sserialize::UByteArrayAdapter::OffsetType
+MHR_CLS_NAME::putSignature(Signature const & sig) {
+	sserialize::UByteArrayAdapter::OffsetType result = m_sigs.tellPutPtr();
+	m_sigs << sig;
+	return result;
+}
+
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::Signature
+MHR_CLS_NAME::signature(Record const & r) const {
+	sserialize::UByteArrayAdapter d(m_sigs, r.sig);
+	if constexpr (std::is_arithmetic<Signature>::value) {
+		Signature result;
+		d >> result;
+		return result;
+	}
+	else {
+		return Signature(d);
+	}
+}
+
+MHR_TMPL_PARAMS
+uint64_t
+MHR_CLS_NAME::hilbertIndex(uint32_t x, uint32_t y) {
+	uint64_t result = 0;
+	for(uint64_t s(uint64_t(1) << 31); s > 0; s >>= 1) {
+		uint64_t rx = (x & s) > 0;
+		uint64_t ry = (y & s) > 0;
+		result += s * s * ((3 * rx) ^ ry);
+		//rotate
+		if (ry == 0) {
+			if (rx == 1) {
+				x = uint32_t(s-1) - x;
+				y = uint32_t(s-1) - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return result;
+}
+
+#undef MHR_TMPL_PARAMS
+#undef MHR_CLS_NAME
+
+}//end namespace srtree
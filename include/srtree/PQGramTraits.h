@@ -2,6 +2,7 @@
 
 #include <srtree/QGram.h>
 #include <srtree/QGramDB.h>
+#include <srtree/PredicateProgram.h>
 
 #include <sserialize/algorithm/utilfunctional.h>
 #include <sserialize/storage/SerializationInfo.h>
@@ -50,10 +51,26 @@ public:
 		}
 	};
 	
+	///Fraction of the positional q-grams in the union of @param base and @param toAdd that are not in @param base
+	class Enlargement {
+	public:
+		inline double operator()(Signature const & base, Signature const & toAdd) const {
+			auto bit = base.data().begin(), bend = base.data().end();
+			std::size_t added = 0;
+			for(auto const & x : toAdd.data()) {
+				for(; bit != bend && *bit < x; ++bit) {}
+				added += (bit == bend || x != *bit);
+			}
+			std::size_t us = base.size() + added;
+			return us ? double(added)/us : 0;
+		}
+	};
+	
 public:
 	virtual ~PQGramTraitsBase() {}
 public:
 	inline Combine combine() const { return Combine(); }
+	inline Enlargement enlargement() const { return Enlargement(); }
 	inline Serializer serializer() const { return Serializer(); }
 	inline Deserializer deserializer() const { return Deserializer(); }
 };
@@ -68,8 +85,8 @@ public:
 	public:
 		using MatchReference = Signature;
 	public:
-		MayHaveMatch(MayHaveMatch const & other);
-		MayHaveMatch(MayHaveMatch && other);
+		MayHaveMatch(MayHaveMatch const & other) = default;
+		MayHaveMatch(MayHaveMatch && other) = default;
 		MayHaveMatch & operator=(MayHaveMatch const&) = default;
 		MayHaveMatch & operator=(MayHaveMatch &&) = default;
 		~MayHaveMatch();
@@ -80,45 +97,13 @@ public:
 	private:
 		friend class ROPQGramTraits;
 	private:
-		MayHaveMatch(std::shared_ptr<PQGramDB> const & db, MatchReference const & reference, uint32_t ed);
-	private:
-		struct Node {
-			enum Type {LEAF, INTERSECT, UNITE};
-			virtual ~Node() {}
-			virtual bool nomatch(PQGramDB const & db, Signature const & v, uint32_t ed) = 0;
-			virtual std::unique_ptr<Node> copy() const = 0;
-		};
-		struct IntersectNode: public Node {
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-			bool nomatch(PQGramDB const & db, Signature const & v, uint32_t ed) override;
-			IntersectNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			~IntersectNode() override;
-			std::unique_ptr<Node> copy() const override;
-		};
-		struct UniteNode: public Node {
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-			~UniteNode() override;
-			bool nomatch(PQGramDB const & db, Signature const & v, uint32_t ed) override;
-			
-			UniteNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			std::unique_ptr<Node> copy() const override;
-		};
-		struct LeafNode: public Node {
-			~LeafNode() override;
-			bool nomatch(PQGramDB const & db, Signature const & v, uint32_t ed) override;
-			LeafNode(MatchReference const & ref);
-			std::unique_ptr<Node> copy() const override;
-			MatchReference ref;
-		};
-	private:
-		MayHaveMatch(std::shared_ptr<PQGramDB> const & d, std::unique_ptr<Node> && t, uint32_t ed);
+		using Program = PredicateProgram<MatchReference>;
 	private:
-		bool nomatch(Signature const & v);
+		MayHaveMatch(std::shared_ptr<PQGramDB> const & db, MatchReference const & reference, uint32_t ed);
+		MayHaveMatch(std::shared_ptr<PQGramDB> const & d, Program && p, uint32_t ed);
 	private:
 		std::shared_ptr<PQGramDB> m_d;
-		std::unique_ptr<Node> m_t;
+		Program m_p;
 		uint32_t m_ed;
 	};
 public:
@@ -164,6 +149,8 @@ public:
 	PQGramTraits & operator=(PQGramTraits &&) = default;
 public:
 	void add(const std::string & str);
+	///Add all strings of @param strs in parallel
+	void add(std::vector<std::string> const & strs);
 };
 
 inline sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, PQGramTraits const & v) {
@@ -204,116 +191,40 @@ namespace srtree::detail {
 #define ROPQGRAMTRAITS_TML_HDR template<typename T_PQGRAMDB>
 #define ROPQGRAMTRAITS_CLS ROPQGramTraits<T_PQGRAMDB>
 
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(MayHaveMatch const & other) :
-m_d(other.m_d),
-m_t(other.m_t->copy())
-{}
-
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(MayHaveMatch && other) :
-m_d(std::move(other.m_d)),
-m_t(std::move(other.m_t))
-{}
-
 ROPQGRAMTRAITS_TML_HDR
 ROPQGRAMTRAITS_CLS::MayHaveMatch::~MayHaveMatch() {}
 
 ROPQGRAMTRAITS_TML_HDR
 bool
 ROPQGRAMTRAITS_CLS::MayHaveMatch::operator()(Signature const & ns) const {
-	return !m_t->nomatch(*m_d, ns, m_ed);
+	PQGramDB const & db = *m_d;
+	uint32_t ed = m_ed;
+	return m_p([&](MatchReference const & ref) { return !db.nomatch(ns, ref, ed); });
 }
 
 ROPQGRAMTRAITS_TML_HDR
 typename ROPQGRAMTRAITS_CLS::MayHaveMatch
 ROPQGRAMTRAITS_CLS::MayHaveMatch::operator/(MayHaveMatch const & other) const {
-	auto nt = std::unique_ptr<Node>( new IntersectNode(m_t->copy(), other.m_t->copy()) );
-	return MayHaveMatch(m_d, std::move(nt), m_ed);
+	return MayHaveMatch(m_d, m_p / other.m_p, m_ed);
 }
 
 ROPQGRAMTRAITS_TML_HDR
 typename ROPQGRAMTRAITS_CLS::MayHaveMatch
 ROPQGRAMTRAITS_CLS::MayHaveMatch::operator+(MayHaveMatch const & other) const {
-	auto nt = std::unique_ptr<Node>( new UniteNode(m_t->copy(), other.m_t->copy()) );
-	return MayHaveMatch(m_d, std::move(nt), m_ed);
+	return MayHaveMatch(m_d, m_p + other.m_p, m_ed);
 }
 
 ROPQGRAMTRAITS_TML_HDR
 ROPQGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(std::shared_ptr<PQGramDB> const & d, MatchReference const & reference, uint32_t ed) :
 m_d(d),
-m_t(std::unique_ptr<Node>( new LeafNode(reference) )),
+m_p(reference),
 m_ed(ed)
 {}
 
 ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::IntersectNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second) :
-first(std::move(first)),
-second(std::move(second))
-{}
-
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::~IntersectNode()
-{}
-
-ROPQGRAMTRAITS_TML_HDR
-bool
-ROPQGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::nomatch(PQGramDB const & db, Signature const & v, uint32_t ed) {
-	return first->nomatch(db, v, ed) || second->nomatch(db, v, ed);
-}
-
-ROPQGRAMTRAITS_TML_HDR
-std::unique_ptr<typename ROPQGRAMTRAITS_CLS::MayHaveMatch::Node>
-ROPQGRAMTRAITS_CLS::MayHaveMatch::IntersectNode::copy() const {
-	return std::unique_ptr<Node>( new IntersectNode(first->copy(), second->copy()) );
-}
-
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::UniteNode::UniteNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second) :
-first(std::move(first)),
-second(std::move(second))
-{}
-
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::UniteNode::~UniteNode() {}
-
-ROPQGRAMTRAITS_TML_HDR
-std::unique_ptr<typename ROPQGRAMTRAITS_CLS::MayHaveMatch::Node>
-ROPQGRAMTRAITS_CLS::MayHaveMatch::UniteNode::copy() const {
-	return std::unique_ptr<Node>( new UniteNode(first->copy(), second->copy()) );
-}
-
-ROPQGRAMTRAITS_TML_HDR
-bool
-ROPQGRAMTRAITS_CLS::MayHaveMatch::UniteNode::nomatch(PQGramDB const & db, Signature const & v, uint32_t ed) {
-	return first->nomatch(db, v, ed) && second->nomatch(db, v, ed);
-}
-
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::LeafNode::LeafNode(MatchReference const & ref) :
-ref(ref)
-{}
-
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::LeafNode::~LeafNode()
-{}
-
-ROPQGRAMTRAITS_TML_HDR
-bool
-ROPQGRAMTRAITS_CLS::MayHaveMatch::LeafNode::nomatch(PQGramDB const & db, Signature const & v, uint32_t ed) {
-	return db.nomatch(v, ref, ed);
-}
-
-ROPQGRAMTRAITS_TML_HDR
-std::unique_ptr<typename ROPQGRAMTRAITS_CLS::MayHaveMatch::Node>
-ROPQGRAMTRAITS_CLS::MayHaveMatch::LeafNode::copy() const {
-	return std::unique_ptr<Node>( new LeafNode(ref) );
-}
-
-ROPQGRAMTRAITS_TML_HDR
-ROPQGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(std::shared_ptr<PQGramDB> const & d, std::unique_ptr<Node> && t, uint32_t ed) :
+ROPQGRAMTRAITS_CLS::MayHaveMatch::MayHaveMatch(std::shared_ptr<PQGramDB> const & d, Program && p, uint32_t ed) :
 m_d(d),
-m_t(std::move(t)),
+m_p(std::move(p)),
 m_ed(ed)
 {}
 
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace srtree::detail {
+
+///Intersections and unions of leaf predicates, i.e. the expression of a MayHaveMatch of the signature traits.
+///The expression is a tree of immutable, reference counted nodes. Copying a program and combining two programs
+///only create a new root that shares its children, both are O(1) independent of the number of leaves.
+///
+///On the first evaluation the expression is compiled into the flat sequence of its leaves in evaluation order.
+///Each leaf knows at which leaf to continue if it is true and if it is false, i.e. the short-circuit jumps of && and ||.
+///Evaluating the compiled program is a loop over the leaves without recursion, virtual calls or allocations.
+///Pure conjunctions and pure disjunctions, the most common queries, do not need the jump table at all.
+///The compiled program is stored in the root and shared by all copies, compilation is thread-safe.
+///
+///Usage:
+///using Program = PredicateProgram<Leaf>;
+///Program p = (Program(a) / Program(b)) + Program(c); //(a && b) || c
+///bool result = p([&v](Leaf const & leaf) { return leaf.matches(v); });
+template<typename T_LEAF>
+class PredicateProgram final {
+public:
+	using Leaf = T_LEAF;
+	using Target = uint32_t;
+	///Jump targets that end the evaluation, every other target is the index of a leaf
+	static constexpr Target Accept = std::numeric_limits<Target>::max();
+	static constexpr Target Reject = Accept-1;
+	enum class Shape : uint8_t {LEAF, CONJUNCTION, DISJUNCTION, GENERIC};
+public:
+	explicit PredicateProgram(Leaf const & leaf) :
+	m_root(std::make_shared<Expression>(leaf))
+	{}
+	explicit PredicateProgram(Leaf && leaf) :
+	m_root(std::make_shared<Expression>(std::move(leaf)))
+	{}
+	PredicateProgram(PredicateProgram const &) = default;
+	PredicateProgram(PredicateProgram &&) = default;
+	~PredicateProgram() {}
+	PredicateProgram & operator=(PredicateProgram const &) = default;
+	PredicateProgram & operator=(PredicateProgram &&) = default;
+public:
+	///True iff both programs are true, @param other is only evaluated if this one is true
+	PredicateProgram operator/(PredicateProgram const & other) const {
+		return PredicateProgram(std::make_shared<Expression>(m_root, other.m_root, Shape::CONJUNCTION));
+	}
+	///True iff one of the programs is true, @param other is only evaluated if this one is false
+	PredicateProgram operator+(PredicateProgram const & other) const {
+		return PredicateProgram(std::make_shared<Expression>(m_root, other.m_root, Shape::DISJUNCTION));
+	}
+	///@param test bool(Leaf const &) is called for the leaves in evaluation order until the result is known
+	template<typename T_TEST>
+	bool operator()(T_TEST && test) const {
+		switch (m_root->shape) {
+		case Shape::LEAF:
+			return test(*m_root->leaf);
+		case Shape::CONJUNCTION:
+			for(Leaf const * leaf : program().leaves) {
+				if (!test(*leaf)) {
+					return false;
+				}
+			}
+			return true;
+		case Shape::DISJUNCTION:
+			for(Leaf const * leaf : program().leaves) {
+				if (test(*leaf)) {
+					return true;
+				}
+			}
+			return false;
+		default:
+			break;
+		}
+		Compiled const & p = program();
+		Target i = 0;
+		while (i < Reject) {
+			i = test(*p.leaves[i]) ? p.jumps[i].onTrue : p.jumps[i].onFalse;
+		}
+		return i == Accept;
+	}
+public:
+	std::size_t size() const { return m_root->size; }
+	Shape shape() const { return m_root->shape; }
+private:
+	struct Jump {
+		Target onTrue;
+		Target onFalse;
+	};
+	///The leaves point into the expression that owns the compiled program
+	struct Compiled {
+		std::vector<Leaf const *> leaves;
+		std::vector<Jump> jumps;
+	};
+	struct Expression {
+		using Ptr = std::shared_ptr<Expression const>;
+		Expression(Leaf const & leaf) : shape(Shape::LEAF), size(1), leaf(leaf) {}
+		Expression(Leaf && leaf) : shape(Shape::LEAF), size(1), leaf(std::move(leaf)) {}
+		///@param op is either CONJUNCTION or DISJUNCTION, the shape is op if both children only consist of op
+		Expression(Ptr const & first, Ptr const & second, Shape op) :
+		shape(Shape::GENERIC),
+		conjunction(op == Shape::CONJUNCTION),
+		size(first->size + second->size),
+		first(first),
+		second(second)
+		{
+			if ((first->shape == Shape::LEAF || first->shape == op) && (second->shape == Shape::LEAF || second->shape == op)) {
+				shape = op;
+			}
+		}
+		Shape shape;
+		bool conjunction{false};
+		std::size_t size;
+		std::optional<Leaf> leaf;
+		Ptr first;
+		Ptr second;
+		mutable std::once_flag compiledFlag;
+		mutable Compiled compiled;
+	};
+private:
+	PredicateProgram(std::shared_ptr<Expression const> && root) : m_root(std::move(root)) {}
+	Compiled const & program() const {
+		std::call_once(m_root->compiledFlag, [this]() {
+			Compiled & p = m_root->compiled;
+			p.leaves.reserve(m_root->size);
+			p.jumps.reserve(m_root->size);
+			compile(*m_root, Accept, Reject, p);
+		});
+		return m_root->compiled;
+	}
+	///Appends the leaves of @param e to @param p, they continue at @param onTrue or @param onFalse once the value of e is known.
+	///The leaves of the second child follow the ones of the first child.
+	///Leaving the first child with the result that does not decide the operation continues at the first leaf of the second child.
+	static void compile(Expression const & e, Target onTrue, Target onFalse, Compiled & p) {
+		if (e.shape == Shape::LEAF) {
+			p.leaves.push_back(&*e.leaf);
+			p.jumps.push_back(Jump{onTrue, onFalse});
+			return;
+		}
+		Target second = Target(p.leaves.size() + e.first->size);
+		if (e.conjunction) {
+			compile(*e.first, second, onFalse, p);
+		}
+		else {
+			compile(*e.first, onTrue, second, p);
+		}
+		compile(*e.second, onTrue, onFalse, p);
+	}
+private:
+	std::shared_ptr<Expression const> m_root;
+};
+
+}//end namespace srtree::detail
@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include <array>
+#include <cstdint>
 
 namespace srtree {
 
@@ -39,4 +41,83 @@ private:
 	std::size_t m_q;
 };
 
+///Rabin-Karp fingerprints of the q-grams of QGram(base, q) without materializing the q-grams
+///The i-th fingerprint is fingerprint(QGram(base, q).at(i)), including the short grams at both ends.
+///Each step only removes the first and appends the next character of the gram.
+///Fingerprints are polynomials modulo 2^61-1 with a leading one, hence grams of different lengths differ.
+///Distinct grams collide with a probability of about q/2^61.
+///The characters of @param base are not copied, base has to outlive the QGramFingerprints.
+class QGramFingerprints {
+public:
+	using value_type = uint64_t;
+	static constexpr value_type Prime = (value_type(1) << 61) - 1;
+	static constexpr value_type Base = 0x1A2F74C6D5B3E9ull;
+	static constexpr std::size_t MaxQ = 255;
+public:
+	class const_iterator final {
+	public:
+		const_iterator(QGramFingerprints const * d, std::size_t pos);
+		~const_iterator() {}
+	public:
+		inline const_iterator & operator++() {
+			std::size_t i = ++m_pos;
+			if (i >= m_d->q()) { //the first character of the previous gram is not part of gram i
+				m_h = sub(m_h, mul(m_d->c(i-m_d->q()), m_d->power(m_len-1)));
+				--m_len;
+			}
+			if (i < m_d->m_size) {
+				m_h = add(mul(m_h, Base), m_d->c(i));
+				++m_len;
+			}
+			return *this;
+		}
+		inline value_type operator*() const {
+			return add(m_h, m_d->power(m_len));
+		}
+	public:
+		inline bool operator==(const_iterator const & other) const { return m_pos == other.m_pos; }
+		inline bool operator!=(const_iterator const & other) const { return m_pos != other.m_pos; }
+	private:
+		QGramFingerprints const * m_d;
+		std::size_t m_pos;
+		//fingerprint of the current gram without the leading one
+		value_type m_h{0};
+		//length of the current gram
+		std::size_t m_len{0};
+	};
+public:
+	QGramFingerprints(std::string const & base, std::size_t q);
+	QGramFingerprints(char const * begin, std::size_t size, std::size_t q);
+	~QGramFingerprints();
+public:
+	inline std::size_t q() const { return m_q; }
+	///Same as QGram::size()
+	inline std::size_t size() const { return m_size + m_q-1; }
+	const_iterator begin() const;
+	const_iterator end() const;
+public:
+	///Fingerprint of the whole string @param str
+	static value_type fingerprint(std::string const & str);
+private:
+	static inline value_type mul(value_type a, value_type b) {
+		unsigned __int128 t = (unsigned __int128)(a)*b;
+		return add(value_type(t) & Prime, value_type(t >> 61));
+	}
+	static inline value_type add(value_type a, value_type b) {
+		value_type r = a + b;
+		return r >= Prime ? r - Prime : r;
+	}
+	static inline value_type sub(value_type a, value_type b) {
+		return a >= b ? a - b : a + Prime - b;
+	}
+	inline value_type c(std::size_t i) const { return value_type(uint8_t(m_base[i])) + 1; }
+	///Base^@param i for i <= q
+	inline value_type power(std::size_t i) const { return m_pow[i]; }
+private:
+	char const * m_base;
+	std::size_t m_size;
+	std::size_t m_q;
+	std::array<value_type, MaxQ+1> m_pow;
+};
+
 }//end namespace srtree
@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <vector>
+#include <array>
 #include <limits>
 
 #include <srtree/QGram.h>
@@ -70,9 +71,106 @@ private:
 	QType m_q;
 };
 
-class PQGramDB: public ROPQGramDB< std::unordered_map<std::string, uint32_t> > {
+namespace detail::PQGramDB {
+
+///Map from q-grams to their ids for the construction of a PQGramDB
+///Grams of 1 to 8 bytes without a null byte (i.e. all grams of q <= 8) are packed into an uint64_t
+///and stored in open addressing tables with linear probing, other grams are stored as strings.
+///The map is split into ShardCount shards by the hash of the key. Batches of grams are inserted into the shards in parallel.
+class QGramMap final {
+public:
+	using key_type = std::string;
+	using mapped_type = uint32_t;
+	using value_type = std::pair<std::string, uint32_t>;
+	static constexpr std::size_t ShardCount = 64;
+private:
+	class Table final {
+	public:
+		Table() {}
+		~Table() {}
+	public:
+		std::size_t size() const { return m_size; }
+		uint32_t const * find(uint64_t key, uint64_t hash) const;
+		uint32_t * find(uint64_t key, uint64_t hash);
+		///@return the value of key and true if the key was inserted with @param value
+		std::pair<uint32_t*, bool> insert(uint64_t key, uint64_t hash, uint32_t value);
+		template<typename T_FUNC>
+		void forEach(T_FUNC f) const {
+			for(std::size_t i(0), s(m_keys.size()); i < s; ++i) {
+				if (m_keys[i] != Empty) {
+					f(m_keys[i], m_values[i]);
+				}
+			}
+		}
+	private:
+		///0 is not a valid packed gram
+		static constexpr uint64_t Empty = 0;
+	private:
+		void grow();
+	private:
+		std::vector<uint64_t> m_keys;
+		std::vector<uint32_t> m_values;
+		std::size_t m_size{0};
+	};
+	struct Shard {
+		Table packed;
+		std::unordered_map<std::string, uint32_t> other;
+	};
+public:
+	///Grams of a part of the input that are not in the map yet, grouped by shard
+	///Batches of different parts may be filled concurrently as long as the map is not modified.
+	class Batch final {
+	public:
+		Batch(QGramMap const & map) : m_map(&map) {}
+		~Batch() {}
+	public:
+		void add(char const * gram, std::size_t len);
+	private:
+		friend class QGramMap;
+	private:
+		QGramMap const * m_map;
+		///packed grams of this batch
+		Table m_seen;
+		std::array<std::vector<uint64_t>, ShardCount> m_packed;
+		std::array<std::vector<std::string>, ShardCount> m_other;
+	};
+public:
+	QGramMap() {}
+	QGramMap(QGramMap const &) = default;
+	QGramMap(QGramMap &&) = default;
+	~QGramMap() {}
+	QGramMap & operator=(QGramMap const &) = default;
+	QGramMap & operator=(QGramMap &&) = default;
+public:
+	std::size_t size() const { return m_size; }
+	std::size_t count(std::string const & gram) const;
+	///throws std::out_of_range if @param gram is not in the map
+	uint32_t const & at(std::string const & gram) const;
+	///All grams and their ids in no particular order
+	std::vector<value_type> toVector() const;
+public:
+	///@return the id of @param gram, new grams get the id size()
+	uint32_t insert(char const * gram, std::size_t len);
+	///Insert the grams of all @param batches, the shards are filled in parallel
+	///New grams get the ids [size(), size()+number of new grams) in an order that only depends on the batches
+	void insert(std::vector<Batch> const & batches);
+private:
+	///@return false if @param gram can not be packed
+	static bool pack(char const * gram, std::size_t len, uint64_t & key);
+	static std::string unpack(uint64_t key);
+	static uint64_t hash(uint64_t key);
+	static uint64_t hash(char const * gram, std::size_t len);
+	static std::size_t shard(uint64_t hash);
+private:
+	std::array<Shard, ShardCount> m_s;
+	std::size_t m_size{0};
+};
+
+}//end namespace detail::PQGramDB
+
+class PQGramDB: public ROPQGramDB< detail::PQGramDB::QGramMap > {
 public:
-	using Parent = ROPQGramDB< std::unordered_map<std::string, uint32_t> >;
+	using Parent = ROPQGramDB< detail::PQGramDB::QGramMap >;
 public:
 	PQGramDB(uint32_t q);
 	PQGramDB(PQGramDB const &) = default;
@@ -82,6 +180,8 @@ public:
 	PQGramDB & operator=(PQGramDB &&) = default;
 public:
 	void insert(std::string const & str);
+	///Insert the q-grams of all strings of @param strs in parallel
+	void insert(std::vector<std::string> const & strs);
 private:
 	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, PQGramDB const & v);
 };
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace srtree::detail {
+
+///R*-tree split of Count boundaries into two groups with at least MinLoad entries each.
+///The boundaries are sorted by each of their four corners.
+///The axis is chosen by the smallest margin, the distribution of that sort order by the least overlap and then by the least area.
+///
+///Instead of recomputing the bounds of both groups for every distribution,
+///the bounds of all prefixes and suffixes of a sort order are computed in a single sweep.
+///Each distribution is then evaluated in constant time.
+template<typename T_BOUNDARY, std::size_t T_MIN_LOAD, std::size_t T_COUNT>
+class RStarSplit final {
+public:
+	using Boundary = T_BOUNDARY;
+	static constexpr std::size_t MinLoad = T_MIN_LOAD;
+	static constexpr std::size_t Count = T_COUNT;
+	static_assert(2 <= MinLoad);
+	static_assert(2*MinLoad <= Count);
+	using Order = std::array<std::size_t, Count>;
+	enum {LATS_MIN=0, LATS_MAX=1, LONS_MIN=2, LONS_MAX=3};
+	struct Result {
+		///the first splitPosition entries of order form the first group, the rest the second group
+		Order order;
+		std::size_t splitPosition;
+	};
+	struct OverlapArea {
+		double o{std::numeric_limits<double>::max()};
+		double a{std::numeric_limits<double>::max()};
+		bool operator<(OverlapArea const & other) const {
+			return o == other.o ? a < other.a : o < other.o;
+		}
+	};
+public:
+	RStarSplit() {}
+	~RStarSplit() {}
+public:
+	///@param boundary functor with boundary(std::size_t i) -> Boundary const & for i in [0, Count)
+	template<typename T_BOUNDARY_ACCESSOR>
+	Result operator()(T_BOUNDARY_ACCESSOR boundary);
+	///Same as above, but the distribution is chosen by the overlap relative to the largest overlap of the chosen sort order
+	///mixed with an additional cost in [0, 1] with weight @param weight, ties are broken by area.
+	///@param penalty functor with penalty(Order const & order) -> std::array<double, Count>
+	///returning the cost of the distribution with the first i entries of order in the first group at position i
+	template<typename T_BOUNDARY_ACCESSOR, typename T_PENALTY>
+	Result operator()(T_BOUNDARY_ACCESSOR boundary, T_PENALTY penalty, double weight);
+public:
+	///Sort orders of the boundaries by their corners, indexed by LATS_MIN, LATS_MAX, LONS_MIN, LONS_MAX
+	template<typename T_BOUNDARY_ACCESSOR>
+	static std::array<Order, 4> sortOrders(T_BOUNDARY_ACCESSOR boundary);
+	static double margin(Boundary const & fg, Boundary const & sg);
+	static OverlapArea overlapArea(Boundary const & fg, Boundary const & sg);
+private:
+	///@return the index of the sort order with the smallest margin, its prefix and suffix bounds are set afterwards
+	template<typename T_BOUNDARY_ACCESSOR>
+	std::size_t chooseSplitAxis(std::array<Order, 4> const & corners, T_BOUNDARY_ACCESSOR & boundary);
+	template<typename T_BOUNDARY_ACCESSOR>
+	void sweep(Order const & order, T_BOUNDARY_ACCESSOR & boundary);
+	///@return the minimal quantity and the split position it was found at
+	template<typename T_VALUE, typename T_QUANTITY>
+	std::pair<T_VALUE, std::size_t> minValue(T_QUANTITY quantity, T_VALUE initial) const;
+private:
+	std::array<Boundary, Count> m_prefix; //m_prefix[i] contains the first i+1 entries
+	std::array<Boundary, Count> m_suffix; //m_suffix[i] contains the entries starting at i
+};
+
+#define MHR_TMPL_PARAMS template<typename T_BOUNDARY, std::size_t T_MIN_LOAD, std::size_t T_COUNT>
+#define MHR_CLS_NAME RStarSplit<T_BOUNDARY, T_MIN_LOAD, T_COUNT>
+
+MHR_TMPL_PARAMS
+template<typename T_BOUNDARY_ACCESSOR>
+typename MHR_CLS_NAME::Result
+MHR_CLS_NAME::operator()(T_BOUNDARY_ACCESSOR boundary) {
+	std::array<Order, 4> corners = sortOrders(boundary);
+	std::size_t m = chooseSplitAxis(corners, boundary);
+
+	//BEGIN ChooseSplitIndex
+	auto splitIndex = minValue(&RStarSplit::overlapArea, OverlapArea());
+	//END ChooseSplitIndex
+
+	return Result{corners[m], splitIndex.second};
+}
+
+MHR_TMPL_PARAMS
+template<typename T_BOUNDARY_ACCESSOR, typename T_PENALTY>
+typename MHR_CLS_NAME::Result
+MHR_CLS_NAME::operator()(T_BOUNDARY_ACCESSOR boundary, T_PENALTY penalty, double weight) {
+	if (weight <= 0) {
+		return (*this)(boundary);
+	}
+	std::array<Order, 4> corners = sortOrders(boundary);
+	std::size_t m = chooseSplitAxis(corners, boundary);
+
+	//BEGIN ChooseSplitIndex
+	std::array<double, Count> p = penalty(corners[m]);
+	std::array<OverlapArea, Count> oas;
+	double maxOverlap = 0;
+	for(std::size_t i(MinLoad); Count-i >= MinLoad; ++i) {
+		oas[i] = overlapArea(m_prefix[i-1], m_suffix[i]);
+		maxOverlap = std::max(maxOverlap, oas[i].o);
+	}
+	OverlapArea best;
+	std::size_t minValuePosition = MinLoad;
+	for(std::size_t i(MinLoad); Count-i >= MinLoad; ++i) {
+		OverlapArea q = oas[i];
+		q.o = (1-weight)*(maxOverlap > 0 ? q.o/maxOverlap : 0) + weight*p[i];
+		if (q < best) {
+			best = q;
+			minValuePosition = i;
+		}
+	}
+	//END ChooseSplitIndex
+
+	return Result{corners[m], minValuePosition};
+}
+
+MHR_TMPL_PARAMS
+template<typename T_BOUNDARY_ACCESSOR>
+std::size_t
+MHR_CLS_NAME::chooseSplitAxis(std::array<Order, 4> const & corners, T_BOUNDARY_ACCESSOR & boundary) {
+	std::size_t m = 0;
+	double bestMargin = std::numeric_limits<double>::max();
+	for(std::size_t k(0); k < 4; ++k) {
+		sweep(corners[k], boundary);
+		double km = minValue(&RStarSplit::margin, std::numeric_limits<double>::max()).first;
+		if (km < bestMargin) {
+			bestMargin = km;
+			m = k;
+		}
+	}
+	if (m != 3) {
+		sweep(corners[m], boundary);
+	}
+	return m;
+}
+
+MHR_TMPL_PARAMS
+template<typename T_BOUNDARY_ACCESSOR>
+std::array<typename MHR_CLS_NAME::Order, 4>
+MHR_CLS_NAME::sortOrders(T_BOUNDARY_ACCESSOR boundary) {
+	std::array<Order, 4> corners;
+	for(std::size_t i(0); i < 4; ++i) {
+		for(std::size_t j(0); j < Count; ++j) {
+			corners[i][j] = j;
+		}
+	}
+	std::sort(corners[LATS_MIN].begin(), corners[LATS_MIN].end(), [&boundary](std::size_t a, std::size_t b) {
+		return boundary(a).minLat() < boundary(b).minLat();
+	});
+	std::sort(corners[LATS_MAX].begin(), corners[LATS_MAX].end(), [&boundary](std::size_t a, std::size_t b) {
+		return boundary(a).maxLat() < boundary(b).maxLat();
+	});
+	std::sort(corners[LONS_MIN].begin(), corners[LONS_MIN].end(), [&boundary](std::size_t a, std::size_t b) {
+		return boundary(a).minLon() < boundary(b).minLon();
+	});
+	std::sort(corners[LONS_MAX].begin(), corners[LONS_MAX].end(), [&boundary](std::size_t a, std::size_t b) {
+		return boundary(a).maxLon() < boundary(b).maxLon();
+	});
+	return corners;
+}
+
+MHR_TMPL_PARAMS
+double
+MHR_CLS_NAME::margin(Boundary const & fg, Boundary const & sg) {
+	return fg.lengthInM()+sg.lengthInM();
+}
+
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::OverlapArea
+MHR_CLS_NAME::overlapArea(Boundary const & fg, Boundary const & sg) {
+	OverlapArea oa;
+	oa.o = fg.overlap(sg) ? (fg / sg).area() : 0;
+	oa.a = fg.area()+sg.area();
+	return oa;
+}
+
+MHR_TMPL_PARAMS
+template<typename T_BOUNDARY_ACCESSOR>
+void
+MHR_CLS_NAME::sweep(Order const & order, T_BOUNDARY_ACCESSOR & boundary) {
+	m_prefix[0] = boundary(order[0]);
+	for(std::size_t i(1); i < Count; ++i) {
+		m_prefix[i] = m_prefix[i-1].enlarged(boundary(order[i]));
+	}
+	m_suffix[Count-1] = boundary(order[Count-1]);
+	for(std::size_t i(Count-1); i > 0; --i) {
+		m_suffix[i-1] = m_suffix[i].enlarged(boundary(order[i-1]));
+	}
+}
+
+MHR_TMPL_PARAMS
+template<typename T_VALUE, typename T_QUANTITY>
+std::pair<T_VALUE, std::size_t>
+MHR_CLS_NAME::minValue(T_QUANTITY quantity, T_VALUE initial) const {
+	std::size_t minValuePosition = MinLoad;
+	//the different groupings with each group having at least MinLoad elements
+	for(std::size_t i(MinLoad); Count-i >= MinLoad; ++i) {
+		T_VALUE q = quantity(m_prefix[i-1], m_suffix[i]);
+		if (q < initial) {
+			initial = q;
+			minValuePosition = i;
+		}
+	}
+	return std::make_pair(initial, minValuePosition);
+}
+
+#undef MHR_TMPL_PARAMS
+#undef MHR_CLS_NAME
+
+}//end namespace srtree::detail
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <sserialize/storage/UByteArrayAdapter.h>
+
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+namespace srtree {
+
+///Compressed bitmap of 32 bit ids (Chambi, Lemire, Kaser, Godin 2016, "Roaring bitmaps")
+///The ids are split by their upper 16 bits into chunks, the lower 16 bits of each chunk are stored in a container:
+///a sorted array of at most ArrayMaxSize values, a bitmap of 2^16 bits or a sorted list of runs of consecutive values.
+///Each container uses the representation that needs the least space.
+///intersects() stops at the first common id. With AVX2 (i.e. -mavx2 or -march=native) array containers are
+///compared eight values against eight values and bitmap containers 256 bits at a time.
+///
+///struct RoaringBitmap {
+///  uint32_t containerCount;
+///  Container containers[containerCount];
+///}
+///struct Container {
+///  uint16_t key;
+///  uint8_t type;
+///  uint32_t cardinality;
+///  ARRAY: uint16_t values[cardinality];
+///  BITMAP: uint64_t words[1024];
+///  RUN: uint32_t runCount; (uint16_t start, uint16_t lengthMinusOne)[runCount];
+///}
+class RoaringBitmap final {
+public:
+	using value_type = uint32_t;
+	using size_type = std::size_t;
+	enum class ContainerType : uint8_t {ARRAY=0, BITMAP=1, RUN=2};
+	static constexpr uint32_t ArrayMaxSize = 4096;
+	static constexpr uint32_t BitmapWords = (uint32_t(1) << 16)/64;
+public:
+	RoaringBitmap() {}
+	RoaringBitmap(sserialize::UByteArrayAdapter d);
+	///@param ids in any order, duplicates are removed
+	RoaringBitmap(std::vector<value_type> ids);
+	template<typename T_ITERATOR>
+	RoaringBitmap(T_ITERATOR begin, T_ITERATOR end) : RoaringBitmap(std::vector<value_type>(begin, end)) {}
+	RoaringBitmap(RoaringBitmap const &) = default;
+	RoaringBitmap(RoaringBitmap &&) = default;
+	~RoaringBitmap() {}
+	RoaringBitmap & operator=(RoaringBitmap const &) = default;
+	RoaringBitmap & operator=(RoaringBitmap &&) = default;
+public:
+	///Number of ids
+	size_type size() const;
+	bool empty() const { return m_c.empty(); }
+	bool contains(value_type id) const;
+	///True if both bitmaps have an id in common
+	bool intersects(RoaringBitmap const & other) const;
+	///All ids in ascending order
+	std::vector<value_type> toVector() const;
+	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const;
+public:
+	RoaringBitmap operator+(RoaringBitmap const & other) const;
+	RoaringBitmap & operator+=(RoaringBitmap const & other);
+	///Union of all bitmaps in [begin, end)
+	///@param begin has to dereference to a RoaringBitmap
+	template<typename T_ITERATOR>
+	static RoaringBitmap unite(T_ITERATOR begin, T_ITERATOR end) {
+		RoaringBitmap result;
+		for(; begin != end; ++begin) {
+			result += *begin;
+		}
+		return result;
+	}
+	bool operator==(RoaringBitmap const & other) const;
+	bool operator!=(RoaringBitmap const & other) const { return !(*this == other); }
+private:
+	struct Container {
+		uint16_t key{0};
+		ContainerType type{ContainerType::ARRAY};
+		uint32_t cardinality{0};
+		///The values of an ARRAY container or the pairs of start and length-1 of a RUN container
+		std::vector<uint16_t> values;
+		///The words of a BITMAP container
+		std::vector<uint64_t> words;
+		bool operator==(Container const & other) const;
+	};
+private:
+	static Container makeContainer(uint16_t key, std::vector<uint16_t> const & sorted);
+	static Container makeContainer(uint16_t key, std::vector<uint64_t> && words);
+	///Switch to the representation with the least space
+	static void optimize(Container & c);
+	static std::vector<uint64_t> toWords(Container const & c);
+	static std::vector<uint16_t> toValues(Container const & c);
+	static Container unite(Container const & a, Container const & b);
+	static bool intersects(Container const & a, Container const & b);
+	static bool contains(Container const & c, uint16_t v);
+private:
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, RoaringBitmap const & v);
+private:
+	///Sorted by key
+	std::vector<Container> m_c;
+};
+
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, RoaringBitmap const & v);
+std::ostream & operator<<(std::ostream & out, RoaringBitmap const & v);
+
+}//end namespace srtree
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <sserialize/containers/ItemIndex.h>
+#include <sserialize/containers/HashBasedFlatTrie.h>
+
+#include <srtree/RoaringBitmap.h>
+#include <srtree/Static/RoaringStringSetTraits.h>
+#include <srtree/PredicateProgram.h>
+
+namespace srtree::detail {
+
+///String set signatures stored as RoaringBitmap of string ids
+///In contrast to StringSetTraits the signatures are values and not ids of an ItemIndexFactory,
+///hence combining signatures needs no synchronization. The signatures have a variable size,
+///use DedupSerializationTraitsAdapter to serialize them into a Static::SRTree.
+class RoaringStringSetTraits {
+private:
+	struct StringId {
+		static constexpr uint32_t Invalid = std::numeric_limits<uint32_t>::max();
+		static constexpr uint32_t Internal = Invalid-1;
+		static constexpr uint32_t GenericLeaf = Internal-1;
+
+		bool valid() const { return value != Invalid; }
+		bool internal() const { return value == Internal; }
+		bool leaf() const { return value < Internal; }
+
+		uint32_t value{Invalid};
+	};
+	using String2IdMap = sserialize::HashBasedFlatTrie<StringId>;
+	struct Data {
+		String2IdMap str2Id;
+	};
+	using DataPtr = std::shared_ptr<Data>;
+public:
+	using StaticTraits = srtree::Static::detail::RoaringStringSetTraits;
+public:
+	using Signature = srtree::RoaringBitmap;
+
+	class Serializer {
+	public:
+		using Type = Signature;
+	public:
+		inline sserialize::UByteArrayAdapter & operator()(sserialize::UByteArrayAdapter & dest, Signature const & v) const {
+			return dest << v;
+		}
+	};
+
+	class Deserializer {
+	public:
+		using Type = Signature;
+	public:
+		Signature operator()(Type v) const {
+			return v;
+		}
+	};
+
+	struct Combine {
+		inline Signature operator()(Signature const & first, Signature const & second) const {
+			return first + second;
+		}
+		template<typename Iterator>
+		Signature operator()(Iterator begin, Iterator end) const {
+			return Signature::unite(begin, end);
+		}
+	};
+
+	///Fraction of the strings in the union of @param base and @param toAdd that are not in @param base
+	struct Enlargement {
+		inline double operator()(Signature const & base, Signature const & toAdd) const {
+			std::size_t us = (base + toAdd).size();
+			return us ? double(us - base.size())/us : 0;
+		}
+	};
+
+	class MayHaveMatch final {
+	public:
+		MayHaveMatch(MayHaveMatch const & other) = default;
+		MayHaveMatch(MayHaveMatch && other) = default;
+		MayHaveMatch & operator=(MayHaveMatch const&) = default;
+		MayHaveMatch & operator=(MayHaveMatch &&) = default;
+		~MayHaveMatch();
+	public:
+		bool operator()(Signature const & ns) const;
+		MayHaveMatch operator/(MayHaveMatch const & other) const;
+		MayHaveMatch operator+(MayHaveMatch const & other) const;
+	private:
+		friend class RoaringStringSetTraits;
+	private:
+		using Program = PredicateProgram<Signature>;
+	private:
+		MayHaveMatch(Signature const & reference);
+		MayHaveMatch(Program && p);
+	private:
+		Program m_p;
+	};
+public:
+	RoaringStringSetTraits();
+	RoaringStringSetTraits(RoaringStringSetTraits const &) = default;
+	RoaringStringSetTraits(RoaringStringSetTraits && other) = default;
+	virtual ~RoaringStringSetTraits();
+	RoaringStringSetTraits & operator=(RoaringStringSetTraits const &) = default;
+	RoaringStringSetTraits & operator=(RoaringStringSetTraits &&) = default;
+public:
+	inline Combine combine() const { return Combine(); }
+	inline Enlargement enlargement() const { return Enlargement(); }
+	inline MayHaveMatch mayHaveMatch(sserialize::ItemIndex const & validStrings) const { return MayHaveMatch(addSignature(validStrings)); }
+	inline Serializer serializer() const { return Serializer(); }
+	inline Deserializer deserializer() const { return Deserializer(); }
+public:
+	void addString(std::string const & str);
+	void finalizeStringTable();
+	uint32_t strId(std::string const & str) const;
+public:
+	Signature addSignature(uint32_t stringId) const {
+		return Signature(std::vector<uint32_t>(1, stringId));
+	}
+	Signature addSignature(sserialize::ItemIndex const & strIdSet) const;
+	template<typename T_STRING_ID_ITERATOR>
+	Signature addSignature(T_STRING_ID_ITERATOR begin, T_STRING_ID_ITERATOR end) const {
+		return Signature(begin, end);
+	}
+	///The string ids of @param sig
+	sserialize::ItemIndex strIds(Signature const & sig) const;
+public:
+	sserialize::HashBasedFlatTrie<StringId> & str2Id() { return m_d->str2Id; }
+	sserialize::HashBasedFlatTrie<StringId> const & str2Id() const { return m_d->str2Id; }
+private:
+	friend sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, RoaringStringSetTraits & traits);
+private:
+	std::shared_ptr<Data> m_d;
+};
+
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, RoaringStringSetTraits & traits);
+
+}//end namespace srtree::detail
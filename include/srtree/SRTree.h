@@ -1,17 +1,26 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <array>
 #include <memory>
+#include <thread>
+#include <type_traits>
+#include <optional>
+#include <atomic>
+#include <exception>
 
 #include <sserialize/containers/SimpleBitVector.h>
+#include <sserialize/utility/exceptions.h>
 
 #include <boost/rational.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 
+#include <srtree/RStarSplit.h>
 #include <srtree/GeoRectGeometryTraits.h>
 #include <srtree/MinWiseSignatureTraits.h>
 #include <srtree/PQGramTraits.h>
 #include <srtree/StringSetTraits.h>
+#include <srtree/TraversalStatistics.h>
 
 #include <srtree/Static/SRTree.h>
 
@@ -20,6 +29,38 @@ namespace detail {
 	
 class NodeOverflowException: public std::exception {};
 
+template<typename T_SIGNATURE_TRAITS, typename = void>
+struct HasSignatureEnlargement: std::false_type {};
+
+template<typename T_SIGNATURE_TRAITS>
+struct HasSignatureEnlargement<T_SIGNATURE_TRAITS, std::void_t<typename T_SIGNATURE_TRAITS::Enlargement>>: std::true_type {};
+
+///Serializers with encode(dest, value) and store(dest, encoded) split the serialization of a value.
+///encode() may run concurrently, store() is called in the final order of the values, see DedupSerializationTraitsAdapter
+template<typename T_SERIALIZER, typename = void>
+struct HasDeferredSerialization: std::false_type {};
+
+template<typename T_SERIALIZER>
+struct HasDeferredSerialization<T_SERIALIZER, std::void_t<decltype(
+	std::declval<T_SERIALIZER&>().store(std::declval<sserialize::UByteArrayAdapter&>(), std::declval<sserialize::UByteArrayAdapter const &>())
+)>>: std::true_type {};
+
+///Signatures as combined and compared by the insertion heuristics.
+///If the Combine of the signature traits has side effects (e.g. StringSetTraits adds every result to its ItemIndexFactory),
+///their Enlargement defines a Value type, a function value(Signature) and operator()(Value, Value).
+///The heuristics then only combine these temporary values, the Combine has to support them as well.
+template<typename T_SIGNATURE_TRAITS, typename = void>
+struct SignatureEnlargementValue {
+	static constexpr bool HasValue = false;
+	using Type = typename T_SIGNATURE_TRAITS::Signature;
+};
+
+template<typename T_SIGNATURE_TRAITS>
+struct SignatureEnlargementValue<T_SIGNATURE_TRAITS, std::void_t<typename T_SIGNATURE_TRAITS::Enlargement::Value>> {
+	static constexpr bool HasValue = true;
+	using Type = typename T_SIGNATURE_TRAITS::Enlargement::Value;
+};
+
 class Node {
 public:
 	using self = Node;
@@ -107,7 +148,7 @@ public:
 public:
 	static constexpr size_type npos = std::numeric_limits<size_type>::max();
 public:
-	NodeWithChildren() : m_s(0), m_p(0) {}
+	NodeWithChildren() : m_s(0), m_a(0), m_p(0) {}
 	~NodeWithChildren() override {}
 public:
 	size_type size() const override {
@@ -119,6 +160,10 @@ public:
 	Boundary const & boundary(size_type p) const {
 		return at(p)->boundary();
 	}
+	///cached area of boundary()
+	double area() const {
+		return m_a;
+	}
 	ConstParentPtr parent() const {
 		return m_p;
 	}
@@ -127,7 +172,12 @@ public:
 	}
 public:
 	void enlarge(Boundary const & other) override {
+		//boundaries of ancestors contain ours, so there is nothing to do for them either
+		if (m_s && m_b.contains(other)) {
+			return;
+		}
 		m_b.enlarge(other);
+		m_a = m_b.area();
 		if (parent()) {
 			parent()->template as<Self>().enlarge(other);
 		}
@@ -137,6 +187,7 @@ public:
 		for(size_type i(0), s(size()); i < s; ++i) {
 			m_b.enlarge(at(i)->boundary());
 		}
+		m_a = m_b.area();
 		if (parent()) {
 			parent()->template as<Self>().recomputeBoundary();
 		}
@@ -179,11 +230,22 @@ public:
 		return out;
 	}
 	virtual void push_back(ptr_type && child) = 0;
+	///remove the child at position @param p, the last child takes its place
+	virtual ptr_type remove(size_type p) = 0;
 protected:
 	void replace_imp(size_type p, ptr_type && child) {
 		at(p) = std::move(child);
 		recomputeBoundary();
 	}
+	ptr_type remove_imp(size_type p) {
+		ptr_type result = std::move(at(p));
+		--m_s;
+		if (p != m_s) {
+			m_c.at(p) = std::move(m_c.at(m_s));
+		}
+		recomputeBoundary();
+		return result;
+	}
 	void push_back_imp(ptr_type && child) {
 		if (m_s >= MaxLoad) {
 			throw NodeOverflowException();
@@ -203,6 +265,7 @@ protected:
 private:
 	size_type m_s;
 	Boundary m_b;
+	double m_a;
 	ParentPtr m_p;
 	Children m_c;
 };
@@ -245,6 +308,11 @@ public:
 		child->template as<Parent>().setParent(this);
 		Parent::push_back_imp(std::move(child));
 	}
+	ptr_type remove(size_type p) override {
+		ptr_type result = Parent::remove_imp(p);
+		result->template as<Parent>().setParent(0);
+		return result;
+	}
 };
 
 template<typename T_PAYLOAD, uint8_t T_MIN_LOAD, uint8_t T_MAX_LOAD>
@@ -277,6 +345,9 @@ public:
 		SSERIALIZE_CHEAP_ASSERT_EQUAL(child->type(), Node::ITEM);
 		Parent::push_back_imp(std::move(child));
 	}
+	ptr_type remove(size_type p) override {
+		return Parent::remove_imp(p);
+	}
 };
 
 template<typename T_PAYLOAD, typename T_ITEM>
@@ -331,6 +402,7 @@ public:
 	static constexpr uint8_t MaxLoad = TMaxLoad;
 	static_assert(MinLoad <= MaxLoad/2);
 	static_assert(2 <= MinLoad);
+	static constexpr std::size_t DefaultChooseSubTreeCandidates = 8;
 public:
 	using SignatureTraits = TSignatureTraits;
 	using Signature = typename SignatureTraits::Signature;
@@ -341,6 +413,9 @@ public:
 	using Boundary = typename GeometryTraits::Boundary;
 	using GeometryMatchPredicate = typename GeometryTraits::MayHaveMatch;
 	
+	///Signature traits with an Enlargement support signature-aware insertion, see setSignatureWeight()
+	static constexpr bool HasSignatureEnlargement = detail::HasSignatureEnlargement<SignatureTraits>::value;
+	
 	using ItemType = uint32_t;
 	using ItemNode = detail::ItemNode<Signature, ItemType>;
 	
@@ -368,14 +443,54 @@ public:
 	///size(item.signature.intersect(sig)) >= sigBound
 	template<typename T_OUTPUT_ITERATOR>
 	void find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out) const;
+	
+	///Same as find(gmp, smp, out) but the predicates are evaluated in the order chosen per level by @param stats,
+	///which records the evaluations, see TraversalStatistics.
+	///Every reported item matches both predicates. Signature tests of internal nodes may be skipped, hence items below nodes
+	///whose signature gives a false negative (e.g. MinWise signatures) may be reported in addition to the ones of find(gmp, smp, out).
+	template<typename T_OUTPUT_ITERATOR>
+	void find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out, TraversalStatistics & stats) const;
 public:
 	///@return a pointer to the item node created in the tree which is valid during the lifetime of the tree
 	ItemNode const * insert(Boundary const & b, Signature const & sig, ItemType const & item);
-	void recalculateSignatures();
+	ItemNode const * insert(ItemDescription const & d);
+	ItemNode const * insert(ItemDescription && d);
+	///Remove the item node @param in, @return false if @param in is not part of the tree
+	///Pointers to other item nodes stay valid
+	bool erase(ItemNode const * in);
+	///Remove the item node with boundary @param b and item @param item
+	bool erase(Boundary const & b, ItemType const & item);
+	///Set boundary and signature of the item node @param in
+	///@return the item node holding the new data, @param in is invalid afterwards unless the boundary is unchanged
+	ItemNode const * update(ItemNode const * in, Boundary const & b, Signature const & sig);
+	///Recompute the signatures of all internal and leaf nodes level by level, bottom-up.
+	///The nodes of a level are processed in parallel by @param numThreads threads, 0 uses all hardware threads.
+	///The Combine of the signature traits has to be thread-safe
+	void recalculateSignatures(uint32_t numThreads = 0);
+	///Keep the signatures of internal and leaf nodes up-to-date during insert, erase and update.
+	///Signatures are combined upward along the insertion path and recomputed from the children of nodes that are split, reinserted or condensed.
+	///Enabling recomputes all signatures once.
+	///This is off by default since bulk builds are faster with a single call to recalculateSignatures() at the end
+	///and StringSetTraits would store the intermediate string sets of every modification.
+	void setIncrementalSignatures(bool enable);
+	inline bool incrementalSignatures() const { return m_is; }
+	///Number of children with the least area enlargement that are checked for overlap when choosing a leaf during insertion.
+	///0 checks all children which is exact but quadratic in MaxLoad
+	inline void setChooseSubTreeCandidates(std::size_t count) { m_cstc = count; }
+	inline std::size_t chooseSubTreeCandidates() const { return m_cstc; }
+	///Weight in [0, 1] of the signature enlargement in the cost of choosing a subtree, a split distribution and the children to reinsert.
+	///The remaining weight goes to the geometric cost, which is normalized to [0, 1] as well.
+	///0 disables it and results in the plain R*-tree heuristics.
+	///The signature enlargement needs up-to-date signatures of internal nodes, hence a positive weight enables incremental signatures.
+	///Throws a PreconditionViolationException if the signature traits have no Enlargement
+	void setSignatureWeight(double weight);
+	inline double signatureWeight() const { return m_sw; }
 public:
 	bool checkConsistency() const;
 public:
-	sserialize::UByteArrayAdapter & serialize(sserialize::UByteArrayAdapter & dest) const;
+	///Boundaries and signatures are encoded by @param numThreads threads in parallel, 0 uses all hardware threads.
+	///The Serializer of the signature traits has to be thread-safe if each thread uses its own instance
+	sserialize::UByteArrayAdapter & serialize(sserialize::UByteArrayAdapter & dest, uint32_t numThreads = 0) const;
 	template<typename TStaticSignatureTraits, typename TStaticGeometryTraits>
 	bool checkEquality(srtree::Static::SRTree<TStaticSignatureTraits, TStaticGeometryTraits> const & stree) const;
 private:
@@ -395,20 +510,53 @@ private:
 			return n.template as<NodeWithPayload>().payload();
 		}
 	};
+	using PayloadIterator = boost::transform_iterator<PayloadDerefer, typename NodeWithChildren::const_iterator>;
+	using EnlargementValue = typename detail::SignatureEnlargementValue<SignatureTraits>::Type;
 private:
 	void splitNode(std::array<Node::ptr_type, MaxLoad+1> & node, NodeWithChildren & fn, NodeWithChildren & sn) const;
 	//note that level(m_root) == m_depth, so leafs are in level 0
 	void insert(Node::ptr_type && node, std::size_t level);
 	//note that level(m_root) == m_depth, so leafs are in level 0
-	Node * chooseSubTree(Boundary const & b, std::size_t level) const;
+	Node * chooseSubTree(Boundary const & b, Payload const & sig, std::size_t level) const;
 	//note that level(m_root) == m_depth, so leafs are in level 0
 	void overflowTreatment(Node* tn, Node::ptr_type&& node, std::size_t level);
+	///@return the leaf and the position of the first item node within it that matches @param pred
+	template<typename T_PREDICATE>
+	std::pair<LeafNode*, std::size_t> findLeaf(Boundary const & b, T_PREDICATE pred);
+	///remove underfull nodes on the path from @param lf to the root and reinsert their children
+	void condenseTree(LeafNode * lf);
+	///recompute the payload of @param n from its children
+	void recomputeSignature(Node & n, SignatureCombine & combine) const;
+	///recompute the payloads of @param n and all of its ancestors from their children
+	void recomputeSignatures(Node * n);
+	///combine @param sig into the payloads of @param n and all of its ancestors
+	void propagateSignature(Node * n, Payload const & sig);
+	///Report the items below the root whose path only consists of children for which @param match returns true.
+	///@param match bool(Node const & child, std::size_t level) where level is the level of the parent of child, leaf nodes are in level 0
+	template<typename T_OUTPUT_ITERATOR, typename T_MATCH>
+	void traverse(T_OUTPUT_ITERATOR out, T_MATCH match) const;
+	///Encode the values of @param count chunks in parallel and append them to @param ac in order.
+	///The output does not depend on @param numThreads, serializers with deferred serialization (see detail::HasDeferredSerialization)
+	///store the encoded values while appending them. Exceptions of the encoding threads are rethrown.
+	///@param chunk functor chunk(begin, end, cb) calling cb(value) for every value in the chunks [begin, end) in order
+	///@param serializerFactory returns the serializer used by a single thread
+	template<typename T_ARRAY_CREATOR, typename T_SERIALIZER_FACTORY, typename T_CHUNK_FUNC>
+	static void parallelPut(T_ARRAY_CREATOR & ac, std::size_t count, std::size_t chunkSize, T_SERIALIZER_FACTORY serializerFactory, T_CHUNK_FUNC chunk, uint32_t numThreads);
+	///@return the value of @param sig combined and compared by the insertion heuristics
+	EnlargementValue enlargementValue(Payload const & sig) const;
+	///fraction of the combination of @param base and @param toAdd that is not in @param base, 0 without an Enlargement
+	double signatureEnlargement(EnlargementValue const & base, EnlargementValue const & toAdd) const;
+	///how much the signature of each child is not covered by the signatures of its siblings
+	std::array<double, MaxLoad+1> signatureMisfits(std::array<Node::ptr_type, MaxLoad+1> const & nodes) const;
 private:
 	SignatureTraits m_straits;
 	GeometryTraits m_gtraits;
 	Node::ptr_type m_root;
 	std::size_t m_depth{0};
 	std::size_t m_rip{MaxLoad/3}; //number of children to reinsert
+	bool m_is{false}; //incremental signatures
+	std::size_t m_cstc{DefaultChooseSubTreeCandidates}; //number of overlap candidates in chooseSubTree
+	double m_sw{0}; //weight of the signature enlargement in insertion decisions
 private:
 	sserialize::SimpleBitVector m_ail; //level active dring a insertion
 	sserialize::spatial::DistanceCalculator m_dc;
@@ -516,19 +664,46 @@ MHR_TMPL_PARAMS
 template<typename T_OUTPUT_ITERATOR>
 void
 MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out) const {
+	if (!m_root || !gmp(m_root->boundary())) {
+		return;
+	}
+	traverse(out, [&gmp, &smp](Node const & child, std::size_t) {
+		return gmp(child.boundary()) && smp(child.template as<NodeWithPayload>().payload());
+	});
+}
+
+MHR_TMPL_PARAMS
+template<typename T_OUTPUT_ITERATOR>
+void
+MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out, TraversalStatistics & stats) const {
+	if (!m_root || !gmp(m_root->boundary())) {
+		return;
+	}
+	traverse(out, [&gmp, &smp, &stats](Node const & child, std::size_t level) {
+		return stats(level,
+			[&]() { return gmp(child.boundary()); },
+			[&]() { return smp(child.template as<NodeWithPayload>().payload()); }
+		);
+	});
+}
+
+MHR_TMPL_PARAMS
+template<typename T_OUTPUT_ITERATOR, typename T_MATCH>
+void
+MHR_CLS_NAME::traverse(T_OUTPUT_ITERATOR out, T_MATCH match) const {
 	using OutputIterator = T_OUTPUT_ITERATOR;
+	using Match = T_MATCH;
 	struct Recurser {
-		GeometryMatchPredicate & gmp;
-		SignatureMatchPredicate & smp;
 		OutputIterator & out;
-		void operator()(Node const & node) {
+		Match & match;
+		void operator()(Node const & node, std::size_t level) {
 			switch (node.type()) {
 			case Node::INTERNAL:
 			{
 				InternalNode const & inode = node.as<InternalNode>();
 				for(std::size_t i(0), s(inode.size()); i < s; ++i) {
-					if (gmp(inode.at(i)->boundary()) && smp(inode.at(i)->template as<NodeWithPayload>().payload())) {
-						(*this)(*inode.at(i));
+					if (match(*inode.at(i), level)) {
+						(*this)(*inode.at(i), level-1);
 					}
 				}
 			}
@@ -537,7 +712,7 @@ MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OU
 			{
 				LeafNode const & lnode = node.as<LeafNode>();
 				for(std::size_t i(0), s(lnode.size()); i < s; ++i) {
-					if (gmp(lnode.at(i)->boundary()) && smp(lnode.at(i)->template as<NodeWithPayload>().payload())) {
+					if (match(*lnode.at(i), level)) {
 						*out = lnode.at(i)->template as<ItemNode>().item();
 						++out;
 					}
@@ -549,14 +724,9 @@ MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OU
 				break;
 			};
 		}
-		Recurser(GeometryMatchPredicate & gmp, SignatureMatchPredicate & smp, OutputIterator & out) :
-		gmp(gmp), smp(smp), out(out)
-		{}
+		Recurser(OutputIterator & out, Match & match) : out(out), match(match) {}
 	};
-	if (!m_root || !gmp(m_root->boundary())) {
-		return;
-	}
-	Recurser(gmp, smp, out)(*m_root);
+	Recurser(out, match)(*m_root, m_depth);
 }
 
 MHR_TMPL_PARAMS
@@ -571,13 +741,35 @@ MHR_CLS_NAME::insert(Boundary const & b, Signature const & sig, ItemType const &
 	return result;
 }
 
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::ItemNode const *
+MHR_CLS_NAME::insert(ItemDescription const & d) {
+	return insert(d.boundary, d.signature, d.item);
+}
+
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::ItemNode const *
+MHR_CLS_NAME::insert(ItemDescription && d) {
+	auto in = ItemNode::make_unique(d.boundary, d.item);
+	ItemNode const * result = in.get();
+	in->payload() = std::move(d.signature);
+	m_ail.reset();
+	insert(std::move(in), 0);
+	SSERIALIZE_EXPENSIVE_ASSERT( checkConsistency() );
+	return result;
+}
+
 MHR_TMPL_PARAMS
 void
 MHR_CLS_NAME::insert(std::unique_ptr<Node> && node, std::size_t level) {
 	SSERIALIZE_EXPENSIVE_ASSERT( checkConsistency() );
-	Node * tn = chooseSubTree(node->boundary(), level);
+	Node * tn = chooseSubTree(node->boundary(), node->as<NodeWithPayload>().payload(), level);
 	if (!tn->as<PageNode>().isFull()) {
+		Payload const & sig = node->as<NodeWithPayload>().payload();
 		tn->as<NodeWithChildren>().push_back(std::move(node));
+		if (m_is) {
+			propagateSignature(tn, sig);
+		}
 	}
 	else {
 		overflowTreatment(tn, std::move(node), level);
@@ -606,6 +798,11 @@ MHR_CLS_NAME::overflowTreatment(Node * tn, Node::ptr_type && node, std::size_t l
 		tnc.back() = std::move(node);
 		
 		splitNode(tnc, fn->as<NodeWithChildren>(), sn->as<NodeWithChildren>());
+		if (m_is) {
+			SignatureCombine combine = straits().combine();
+			recomputeSignature(*fn, combine);
+			recomputeSignature(*sn, combine);
+		}
 		Node * tnp = tn->as<NodeWithChildren>().parent();
 		if (!tnp) {// root node was split
 			SSERIALIZE_CHEAP_ASSERT_EQUAL(m_depth, level);
@@ -614,10 +811,19 @@ MHR_CLS_NAME::overflowTreatment(Node * tn, Node::ptr_type && node, std::size_t l
 			m_root->as<InternalNode>().push_back(std::move(fn));
 			m_root->as<InternalNode>().push_back(std::move(sn));
 			m_depth += 1;
+			if (m_is) {
+				recomputeSignatures(m_root.get());
+			}
 		}
 		else if (!tnp->as<NodeWithChildren>().isFull()) { //parent has enough room
 			tnp->as<NodeWithChildren>().replace(tn, std::move(fn));
 			tnp->as<NodeWithChildren>().push_back(std::move(sn));
+			if (m_is) {
+				//the ancestors of tnp already contain the old children of tn, they only miss the new node
+				SignatureCombine combine = straits().combine();
+				recomputeSignature(*tnp, combine);
+				propagateSignature(tnp->as<NodeWithChildren>().parent(), tnp->as<NodeWithPayload>().payload());
+			}
 		}
 		else {
 			tnp->as<NodeWithChildren>().replace(tn, std::move(fn));
@@ -644,13 +850,30 @@ MHR_CLS_NAME::overflowTreatment(Node * tn, Node::ptr_type && node, std::size_t l
 			dists[i] = m_dc.calc(tnc[i]->boundary().midLat(), tnc[i]->boundary().midLon(), center.lat(), center.lon());
 			tmp[i] = i;
 		}
+		if (m_sw > 0) {
+			//children whose signature is not covered by their siblings are reinserted as well
+			std::array<double, MaxLoad+1> misfits = signatureMisfits(tnc);
+			double maxDist = *std::max_element(dists.begin(), dists.end());
+			for(std::size_t i(0); i < MaxLoad+1; ++i) {
+				dists[i] = (1-m_sw)*(maxDist > 0 ? dists[i]/maxDist : 0) + m_sw*misfits[i];
+			}
+		}
 		std::sort(tmp.begin(), tmp.end(), [&dists](std::size_t a, std::size_t b) {
 			return dists[a] > dists[b];
 		});
 		for(std::size_t i(m_rip); i < MaxLoad+1; ++i) {
 			nn->as<NodeWithChildren>().push_back(std::move(tnc.at(tmp[i])));
 		}
-		tn->as<NodeWithChildren>().parent()->template as<NodeWithChildren>().replace(tn, std::move(nn));
+		Node * tnp = tn->as<NodeWithChildren>().parent();
+		if (m_is) {
+			SignatureCombine combine = straits().combine();
+			recomputeSignature(*nn, combine);
+		}
+		tnp->as<NodeWithChildren>().replace(tn, std::move(nn));
+		if (m_is) {
+			//the reinserted children are added back during their insertion
+			recomputeSignatures(tnp);
+		}
 		//reinsert the remaining children, these are the ones that are far apart
 		for(std::size_t i(0); i < m_rip; ++i) {
 			insert(std::move(tnc.at(tmp[i])), level);
@@ -661,97 +884,374 @@ MHR_CLS_NAME::overflowTreatment(Node * tn, Node::ptr_type && node, std::size_t l
 
 MHR_TMPL_PARAMS
 typename MHR_CLS_NAME::Node *
-MHR_CLS_NAME::chooseSubTree(Boundary const & b, std::size_t level) const {
+MHR_CLS_NAME::chooseSubTree(Boundary const & b, Payload const & sig, std::size_t level) const {
 	SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(level, m_depth);
 	
 	auto overlap = [](Boundary const & b, auto begin, auto end) {
 		double result = 0;
 		for(; begin != end; ++begin) {
-			result += (b / (*begin)->boundary()).area();
+			Boundary const & cb = (*begin)->boundary();
+			if (b.overlap(cb)) {
+				result += (b / cb).area();
+			}
 		}
 		return result;
 	};
-	auto areaEnlargement = [](Boundary const & base, Boundary const & toAdd) {
-		return base.enlarged(toAdd).area() - base.area();
+	auto areaEnlargement = [](NodeWithChildren const & base, Boundary const & toAdd) {
+		return base.boundary().enlarged(toAdd).area() - base.area();
+	};
+	//area enlargement, with a signature weight it is relative to the enlarged area and mixed with the signature enlargement
+	std::array<double, MaxLoad> sigCosts;
+	EnlargementValue sigValue;
+	if (m_sw > 0) {
+		sigValue = enlargementValue(sig);
+	}
+	auto enlargementCost = [&](NodeWithChildren const & base, std::size_t i) {
+		double ae = areaEnlargement(base, b);
+		if (m_sw <= 0) {
+			return ae;
+		}
+		double ea = base.area() + ae;
+		sigCosts[i] = signatureEnlargement(enlargementValue(base.payload()), sigValue);
+		return (1-m_sw)*(ea > 0 ? ae/ea : 0) + m_sw*sigCosts[i];
 	};
+	std::array<std::pair<double, std::size_t>, MaxLoad> candidates;
+	std::array<double, MaxLoad> overlaps;
 	Node * cn = m_root.get();
 	std::size_t clvl = m_depth;
 	while (clvl > level) {
 		InternalNode const & n = cn->as<InternalNode>();
+		std::size_t bestPos = std::numeric_limits<std::size_t>::max();
 		if (n.at(0)->type() == Node::LEAF) {
 			SSERIALIZE_CHEAP_ASSERT_EQUAL(clvl-1, std::size_t(0));
-			std::size_t bestPos = std::numeric_limits<std::size_t>::max();
+			//Only the candidates with the least area enlargement are checked for overlap, see the R*-tree paper
+			std::size_t ns = n.size();
+			for(std::size_t i(0); i < ns; ++i) {
+				candidates[i] = std::make_pair(enlargementCost(n.at(i)->template as<LeafNode>(), i), i);
+			}
+			std::size_t cs = ns;
+			if (m_cstc && m_cstc < ns) {
+				cs = m_cstc;
+				std::partial_sort(candidates.begin(), candidates.begin()+cs, candidates.begin()+ns);
+			}
+			double maxOverlap = 0;
+			for(std::size_t i(0); i < cs; ++i) {
+				auto const & myln = n.at(candidates[i].second)->template as<LeafNode>();
+				overlaps[i] = overlap(b, myln.begin(), myln.end());
+				maxOverlap = std::max(maxOverlap, overlaps[i]);
+			}
 			double bestOverlap = std::numeric_limits<double>::max();
-			double bestAreaEnlargement = std::numeric_limits<double>::max();
-			for(std::size_t i(0), s(n.size()); i < s; ++i) {
-				auto const & myln = n.at(i)->template as<LeafNode>();
-				double ov = overlap(b, myln.begin(), myln.end());
-				if (ov < bestOverlap) {
-					bestPos = i;
-					bestOverlap = ov;
-					bestAreaEnlargement = areaEnlargement(myln.boundary(), b);
+			double bestCost = std::numeric_limits<double>::max();
+			for(std::size_t i(0); i < cs; ++i) {
+				double ov = overlaps[i];
+				if (m_sw > 0) {
+					ov = (1-m_sw)*(maxOverlap > 0 ? ov/maxOverlap : 0) + m_sw*sigCosts[candidates[i].second];
 				}
-				else if (ov == bestOverlap) {
-					double ae = areaEnlargement(myln.boundary(), b);
-					if (ae < bestAreaEnlargement) {
-						bestPos = i;
-					}
+				if (ov < bestOverlap || (ov == bestOverlap && candidates[i].first < bestCost)) {
+					bestPos = candidates[i].second;
+					bestOverlap = ov;
+					bestCost = candidates[i].first;
 				}
 			}
-			cn = n.at(bestPos).get();
-			--clvl;
 		}
 		else {
 			SSERIALIZE_CHEAP_ASSERT_EQUAL(Node::INTERNAL, n.template as<InternalNode>().at(0)->type());
-			std::size_t bestPos = std::numeric_limits<std::size_t>::max();
-			double bestAreaEnlargement = std::numeric_limits<double>::max();
+			double bestCost = std::numeric_limits<double>::max();
 			for(std::size_t i(0), s(n.size()); i < s; ++i) {
-				auto const & myin = n.at(i)->template as<InternalNode>();
-				double ae = areaEnlargement(myin.boundary(), b);
-				if (ae < bestAreaEnlargement) {
-					bestAreaEnlargement = ae;
+				double c = enlargementCost(n.at(i)->template as<InternalNode>(), i);
+				if (c < bestCost) {
+					bestCost = c;
 					bestPos = i;
 				}
 			}
-			cn = n.at(bestPos).get();
-			--clvl;
 		}
+		cn = n.at(bestPos).get();
+		--clvl;
 	}
 	return cn;
 }
 
 MHR_TMPL_PARAMS
 void
-MHR_CLS_NAME::recalculateSignatures() {
-	
+MHR_CLS_NAME::recalculateSignatures(uint32_t numThreads) {
+	if (!m_root) {
+		return;
+	}
+	if (!numThreads) {
+		numThreads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+	}
+	//nodes of each level, leafs are in level 0
+	std::vector< std::vector<Node*> > levels(m_depth+1);
+	levels.at(m_depth).push_back(m_root.get());
+	for(std::size_t lvl(m_depth); lvl > 0; --lvl) {
+		for(Node * n : levels.at(lvl)) {
+			InternalNode & in = n->as<InternalNode>();
+			for(auto it(in.begin()), end(in.end()); it != end; ++it) {
+				levels.at(lvl-1).push_back(it->get());
+			}
+		}
+	}
+	//the payload of a node only depends on its children which are all in the level below
+	for(std::vector<Node*> const & level : levels) {
+		std::size_t ls = level.size();
+		#pragma omp parallel num_threads(numThreads) if(numThreads > 1 && ls > 1)
+		{
+			SignatureCombine combine = straits().combine();
+			#pragma omp for schedule(dynamic, 16)
+			for(std::size_t i = 0; i < ls; ++i) {
+				recomputeSignature(*level[i], combine);
+			}
+		}
+	}
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::setIncrementalSignatures(bool enable) {
+	if (enable && !m_is) {
+		recalculateSignatures();
+	}
+	m_is = enable;
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::setSignatureWeight(double weight) {
+	if (weight < 0 || weight > 1) {
+		throw sserialize::PreconditionViolationException("SRTree: signature weight has to be in [0, 1]");
+	}
+	if (weight > 0) {
+		if constexpr (!HasSignatureEnlargement) {
+			throw sserialize::PreconditionViolationException("SRTree: signature traits have no Enlargement");
+		}
+		setIncrementalSignatures(true);
+	}
+	m_sw = weight;
+}
+
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::EnlargementValue
+MHR_CLS_NAME::enlargementValue(Payload const & sig) const {
+	if constexpr (detail::SignatureEnlargementValue<SignatureTraits>::HasValue) {
+		return straits().enlargement().value(sig);
+	}
+	else {
+		return sig;
+	}
+}
+
+MHR_TMPL_PARAMS
+double
+MHR_CLS_NAME::signatureEnlargement(EnlargementValue const & base, EnlargementValue const & toAdd) const {
+	if constexpr (HasSignatureEnlargement) {
+		return straits().enlargement()(base, toAdd);
+	}
+	else {
+		return 0;
+	}
+}
+
+MHR_TMPL_PARAMS
+std::array<double, MHR_CLS_NAME::MaxLoad+1>
+MHR_CLS_NAME::signatureMisfits(std::array<Node::ptr_type, MaxLoad+1> const & nodes) const {
+	constexpr std::size_t Count = MaxLoad+1;
+	PayloadDerefer pd;
+	SignatureCombine combine = straits().combine();
+	std::array<EnlargementValue, Count> values;
+	for(std::size_t i(0); i < Count; ++i) {
+		values[i] = enlargementValue(pd(nodes[i]));
+	}
+	//prefix[i] combines the first i nodes, suffix[i] the nodes starting at i+1
+	std::array<EnlargementValue, Count> prefix, suffix;
+	prefix[1] = values[0];
+	for(std::size_t i(2); i < Count; ++i) {
+		prefix[i] = combine(prefix[i-1], values[i-1]);
+	}
+	suffix[Count-2] = values[Count-1];
+	for(std::size_t i(Count-2); i > 0; --i) {
+		suffix[i-1] = combine(suffix[i], values[i]);
+	}
+	std::array<double, Count> result;
+	result[0] = signatureEnlargement(suffix[0], values[0]);
+	result[Count-1] = signatureEnlargement(prefix[Count-1], values[Count-1]);
+	for(std::size_t i(1); i < Count-1; ++i) {
+		result[i] = signatureEnlargement(combine(prefix[i], suffix[i]), values[i]);
+	}
+	return result;
+}
+
+MHR_TMPL_PARAMS
+bool
+MHR_CLS_NAME::erase(ItemNode const * in) {
+	auto pos = findLeaf(in->boundary(), [in](ItemNode const & x) {
+		return &x == in;
+	});
+	if (!pos.first) {
+		return false;
+	}
+	pos.first->remove(pos.second);
+	condenseTree(pos.first);
+	SSERIALIZE_EXPENSIVE_ASSERT( checkConsistency() );
+	return true;
+}
+
+MHR_TMPL_PARAMS
+bool
+MHR_CLS_NAME::erase(Boundary const & b, ItemType const & item) {
+	auto pos = findLeaf(b, [&b, &item](ItemNode const & x) {
+		return x.item() == item && x.boundary() == b;
+	});
+	if (!pos.first) {
+		return false;
+	}
+	pos.first->remove(pos.second);
+	condenseTree(pos.first);
+	SSERIALIZE_EXPENSIVE_ASSERT( checkConsistency() );
+	return true;
+}
+
+MHR_TMPL_PARAMS
+typename MHR_CLS_NAME::ItemNode const *
+MHR_CLS_NAME::update(ItemNode const * in, Boundary const & b, Signature const & sig) {
+	if (in->boundary() == b) { //position in the tree stays the same
+		auto pos = findLeaf(b, [in](ItemNode const & x) {
+			return &x == in;
+		});
+		if (!pos.first) {
+			throw std::out_of_range("SRTree::update: item node is not part of the tree");
+		}
+		const_cast<ItemNode*>(in)->payload() = sig;
+		if (m_is) {
+			recomputeSignatures(pos.first);
+		}
+		return in;
+	}
+	ItemType item = in->item();
+	if (!erase(in)) {
+		throw std::out_of_range("SRTree::update: item node is not part of the tree");
+	}
+	return insert(b, sig, item);
+}
+
+MHR_TMPL_PARAMS
+template<typename T_PREDICATE>
+std::pair<typename MHR_CLS_NAME::LeafNode*, std::size_t>
+MHR_CLS_NAME::findLeaf(Boundary const & b, T_PREDICATE pred) {
+	using Result = std::pair<LeafNode*, std::size_t>;
 	struct Recurser {
-		using PayloadIterator = boost::transform_iterator<PayloadDerefer, typename NodeWithChildren::const_iterator>;
-		Recurser(SignatureCombine combine) : combine(combine) {}
-		void operator()(Node & node) {
-			switch(node.type()) {
+		Boundary const & b;
+		T_PREDICATE & pred;
+		Result operator()(Node & node) {
+			switch (node.type()) {
 			case Node::INTERNAL:
 			{
 				InternalNode & in = node.as<InternalNode>();
 				for(auto it(in.begin()), end(in.end()); it != end; ++it) {
-					(*this)(**it);
+					if ((*it)->boundary().contains(b)) {
+						Result r = (*this)(**it);
+						if (r.first) {
+							return r;
+						}
+					}
 				}
-				in.payload() = combine(PayloadIterator(in.begin()), PayloadIterator(in.end()));
 			}
 				break;
 			case Node::LEAF:
 			{
 				LeafNode & lf = node.as<LeafNode>();
-				lf.payload() = combine(PayloadIterator(lf.begin()), PayloadIterator(lf.end()));
+				std::size_t i(0);
+				for(auto it(lf.begin()), end(lf.end()); it != end; ++it, ++i) {
+					if (pred((*it)->template as<ItemNode>())) {
+						return Result(&lf, i);
+					}
+				}
 			}
 				break;
+			case Node::ITEM:
 			default:
 				break;
 			};
+			return Result(0, 0);
 		}
-		SignatureCombine combine;
+		Recurser(Boundary const & b, T_PREDICATE & pred) : b(b), pred(pred) {}
 	};
-	if (m_root) {
-		Recurser(straits().combine())(*m_root);
+	if (!m_root || !m_root->boundary().contains(b)) {
+		return Result(0, 0);
+	}
+	return Recurser(b, pred)(*m_root);
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::condenseTree(LeafNode * lf) {
+	SignatureCombine combine = straits().combine();
+	//children of removed nodes together with the level they have to be inserted into
+	std::vector< std::pair<Node::ptr_type, std::size_t> > orphans;
+	Node * n = lf;
+	for(std::size_t level(0); n != m_root.get(); ++level) {
+		NodeWithChildren & nwc = n->as<NodeWithChildren>();
+		NodeWithChildren & p = nwc.parent()->template as<NodeWithChildren>();
+		if (nwc.size() < MinLoad) {
+			Node::ptr_type removed = p.remove(p.find(n));
+			std::vector<Node::ptr_type> children;
+			nwc.prepareReplacement(std::back_inserter(children));
+			for(Node::ptr_type & child : children) {
+				orphans.emplace_back(std::move(child), level);
+			}
+		}
+		else if (m_is) {
+			recomputeSignature(nwc, combine);
+		}
+		n = &p;
+	}
+	if (m_is) {
+		recomputeSignature(*m_root, combine);
+	}
+	for(auto & x : orphans) {
+		m_ail.reset();
+		insert(std::move(x.first), x.second);
+	}
+	//shorten the tree
+	while (m_root->type() == Node::INTERNAL && m_root->as<InternalNode>().size() == 1) {
+		Node::ptr_type child = m_root->as<InternalNode>().remove(0);
+		m_root = std::move(child);
+		m_depth -= 1;
+	}
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::recomputeSignature(Node & n, SignatureCombine & combine) const {
+	NodeWithChildren & nwc = n.as<NodeWithChildren>();
+	if (nwc.size()) {
+		nwc.payload() = combine(PayloadIterator(nwc.cbegin()), PayloadIterator(nwc.cend()));
+	}
+	else {
+		nwc.payload() = Payload();
+	}
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::recomputeSignatures(Node * n) {
+	SignatureCombine combine = straits().combine();
+	for(; n; n = n->as<NodeWithChildren>().parent()) {
+		recomputeSignature(*n, combine);
+	}
+}
+
+MHR_TMPL_PARAMS
+void
+MHR_CLS_NAME::propagateSignature(Node * n, Payload const & sig) {
+	SignatureCombine combine = straits().combine();
+	for(; n; n = n->as<NodeWithChildren>().parent()) {
+		NodeWithChildren & nwc = n->as<NodeWithChildren>();
+		if (nwc.size() > 1) {
+			nwc.payload() = combine(nwc.payload(), sig);
+		}
+		else { //first child, payload is not initialized yet
+			recomputeSignature(nwc, combine);
+		}
 	}
 }
 
@@ -826,7 +1326,7 @@ MHR_CLS_NAME::checkConsistency() const {
 
 MHR_TMPL_PARAMS
 sserialize::UByteArrayAdapter &
-MHR_CLS_NAME::serialize(sserialize::UByteArrayAdapter & dest) const {
+MHR_CLS_NAME::serialize(sserialize::UByteArrayAdapter & dest, uint32_t numThreads) const {
 	
 	struct MetaData {
 		uint32_t numInternalNodes{0};
@@ -866,62 +1366,84 @@ MHR_CLS_NAME::serialize(sserialize::UByteArrayAdapter & dest) const {
 	
 	using SSelf = srtree::Static::SRTree<SignatureTraits, GeometryTraits>;
 	
-	std::vector<Node const *> nodes;
-	nodes.push_back(m_root.get());
+	if (!numThreads) {
+		numThreads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+	}
+	
+	//Nodes are stored in BFS order which is level by level starting at the root.
+	//Only internal and leaf nodes are kept, item nodes are enumerated through the leaves which form the last level of page nodes.
+	std::vector<NodeWithChildren const *> pageNodes;
+	pageNodes.reserve(md.numInternalNodes+md.numLeafNodes);
+	pageNodes.push_back(&m_root->as<NodeWithChildren>());
 	
 	sserialize::Static::ArrayCreator<typename SSelf::Node> nac(dest);
 	std::cout << "SRTree: Serializing nodes..." << std::flush;
-	for(std::size_t i(0); i < nodes.size(); ++i) {
-		Node const & node = * (nodes.at(i));
-		switch(node.type()) {
-		case Node::INTERNAL:
-		{
-			InternalNode const & in = node.as<InternalNode>();
-			nac.put( typename SSelf::Node(nodes.size(), in.size()) );
-			for(auto it(in.begin()), end(in.end()); it != end; ++it) {
-				nodes.push_back(it->get());
-			}
-		}
-			break;
-		case Node::LEAF:
-		{
-			LeafNode const & lf = node.as<LeafNode>();
-			nac.put( typename SSelf::Node(nodes.size(), lf.size()) );
-			for(auto it(lf.begin()), end(lf.end()); it != end; ++it) {
-				nodes.push_back(it->get());
+	{
+		std::size_t nextId = 1;
+		for(std::size_t i(0); i < pageNodes.size(); ++i) {
+			NodeWithChildren const & node = *pageNodes[i];
+			nac.put( typename SSelf::Node(nextId, node.size()) );
+			nextId += node.size();
+			if (node.type() == Node::INTERNAL) {
+				for(auto it(node.begin()), end(node.end()); it != end; ++it) {
+					pageNodes.push_back(&(*it)->template as<NodeWithChildren>());
+				}
 			}
 		}
-			break;
-		default:
-			break;
-		};
 	}
 	nac.flush();
 	std::cout << nac.size() << std::endl;
 	
+	SSERIALIZE_CHEAP_ASSERT_EQUAL(pageNodes.size(), std::size_t(md.numInternalNodes+md.numLeafNodes));
+	//the leafs and the offset of their first item node in the item nodes
+	auto leafsBegin = pageNodes.begin()+md.numInternalNodes;
+	auto leafsEnd = pageNodes.end();
+	std::vector<std::size_t> leafItemOffsets(1, 0);
+	leafItemOffsets.reserve(md.numLeafNodes+1);
+	for(auto it(leafsBegin); it != leafsEnd; ++it) {
+		leafItemOffsets.push_back(leafItemOffsets.back() + (*it)->size());
+	}
+	
+	//page nodes in chunks of nodes, item nodes in chunks of leafs to keep the chunk sizes similar
+	auto putNodes = [&](auto & ac, auto serializerFactory, auto value) {
+		parallelPut(ac, pageNodes.size(), 1024, serializerFactory, [&](std::size_t begin, std::size_t end, auto & cb) {
+			for(; begin < end; ++begin) {
+				cb(value(*pageNodes[begin]));
+			}
+		}, numThreads);
+		parallelPut(ac, md.numLeafNodes, 64, serializerFactory, [&](std::size_t begin, std::size_t end, auto & cb) {
+			for(; begin < end; ++begin) {
+				NodeWithChildren const & lf = *leafsBegin[begin];
+				for(auto it(lf.begin()), lend(lf.end()); it != lend; ++it) {
+					cb(value(**it));
+				}
+			}
+		}, numThreads);
+	};
+	
 	std::cout << "SRTree: Serializing boundaries..." << std::flush;
 	sserialize::Static::ArrayCreator<typename GeometryTraits::Serializer::Type, typename GeometryTraits::Serializer> bac(dest, gtraits().serializer());
-	for(auto n : nodes) {
-		bac.put( n->boundary() );
-	}
+	putNodes(bac,
+		[this]() { return gtraits().serializer(); },
+		[](Node const & n) -> Boundary const & { return n.boundary(); }
+	);
 	bac.flush();
 	std::cout << bac.size() << std::endl;
 	
 	std::cout << "SRTree: Serializing signatures..." << std::flush;
 	sserialize::Static::ArrayCreator<typename SignatureTraits::Serializer::Type, typename SignatureTraits::Serializer> sac(dest, straits().serializer());
-	for(auto n : nodes) {
-		sac.beginRawPut();
-		straits().serializer()(sac.rawPut(), n->template as<NodeWithPayload>().payload() );
-		sac.endRawPut();
-	}
+	putNodes(sac,
+		[this]() { return straits().serializer(); },
+		[](Node const & n) -> Payload const & { return n.template as<NodeWithPayload>().payload(); }
+	);
 	sac.flush();
 	std::cout << sac.size() << std::endl;
 	
 	std::cout << "SRTree: Serializing items..." << std::flush;
 	sserialize::Static::ArrayCreator<ItemType> iac(dest);
-	for(auto n : nodes) {
-		if (n->type() == Node::ITEM) {
-			iac.put( n->template as<ItemNode>().item() );
+	for(auto it(leafsBegin); it != leafsEnd; ++it) {
+		for(auto iit((*it)->begin()), iend((*it)->end()); iit != iend; ++iit) {
+			iac.put( (*iit)->template as<ItemNode>().item() );
 		}
 	}
 	iac.flush();
@@ -929,6 +1451,93 @@ MHR_CLS_NAME::serialize(sserialize::UByteArrayAdapter & dest) const {
 	return dest;
 }
 
+MHR_TMPL_PARAMS
+template<typename T_ARRAY_CREATOR, typename T_SERIALIZER_FACTORY, typename T_CHUNK_FUNC>
+void
+MHR_CLS_NAME::parallelPut(T_ARRAY_CREATOR & ac, std::size_t count, std::size_t chunkSize, T_SERIALIZER_FACTORY serializerFactory, T_CHUNK_FUNC chunk, uint32_t numThreads) {
+	using Serializer = decltype(serializerFactory());
+	constexpr bool Deferred = detail::HasDeferredSerialization<Serializer>::value;
+	struct Chunk {
+		sserialize::UByteArrayAdapter data{sserialize::MM_PROGRAM_MEMORY};
+		std::vector<sserialize::UByteArrayAdapter::OffsetType> offsets;
+	};
+	std::size_t numChunks = (count + chunkSize - 1)/chunkSize;
+	//chunks are encoded in rounds, this bounds the memory used by encoded but not yet spliced chunks
+	std::size_t roundSize = std::size_t(numThreads)*4;
+	std::vector<Chunk> chunks(std::min(roundSize, numChunks));
+	//exceptions must not leave the parallel region, the first one is rethrown after it
+	std::exception_ptr error;
+	std::atomic<bool> failed(false);
+	auto setError = [&error, &failed]() {
+		#pragma omp critical(srtree_parallel_put_error)
+		{
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+		failed = true;
+	};
+	std::optional<Serializer> storer;
+	if constexpr (Deferred) {
+		storer.emplace(serializerFactory());
+	}
+	for(std::size_t rb(0); rb < numChunks; rb += roundSize) {
+		std::size_t re = std::min(numChunks, rb+roundSize);
+		#pragma omp parallel num_threads(numThreads) if(numThreads > 1 && re-rb > 1)
+		{
+			std::optional<Serializer> serializer;
+			try {
+				serializer.emplace(serializerFactory());
+			}
+			catch (...) {
+				setError();
+			}
+			#pragma omp for schedule(dynamic, 1)
+			for(std::size_t c = rb; c < re; ++c) {
+				if (!serializer || failed) {
+					continue;
+				}
+				try {
+					Chunk & ch = chunks[c-rb];
+					ch.data = sserialize::UByteArrayAdapter(sserialize::MM_PROGRAM_MEMORY);
+					ch.offsets.clear();
+					auto cb = [&ch, &serializer](auto const & v) {
+						ch.offsets.push_back(ch.data.tellPutPtr());
+						if constexpr (Deferred) {
+							serializer->encode(ch.data, v);
+						}
+						else {
+							(*serializer)(ch.data, v);
+						}
+					};
+					chunk(c*chunkSize, std::min(count, (c+1)*chunkSize), cb);
+					ch.offsets.push_back(ch.data.tellPutPtr());
+				}
+				catch (...) {
+					setError();
+				}
+			}
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+		for(std::size_t c(rb); c < re; ++c) {
+			Chunk const & ch = chunks[c-rb];
+			for(std::size_t i(1), s(ch.offsets.size()); i < s; ++i) {
+				auto encoded = ch.data.subArray(ch.offsets[i-1], ch.offsets[i]-ch.offsets[i-1]);
+				ac.beginRawPut();
+				if constexpr (Deferred) {
+					storer->store(ac.rawPut(), encoded);
+				}
+				else {
+					ac.rawPut().put(encoded);
+				}
+				ac.endRawPut();
+			}
+		}
+	}
+}
+
 MHR_TMPL_PARAMS
 template<typename TStaticSignatureTraits, typename TStaticGeometryTraits>
 bool
@@ -984,84 +1593,38 @@ MHR_CLS_NAME::checkEquality(srtree::Static::SRTree<TStaticSignatureTraits, TStat
 MHR_TMPL_PARAMS
 void
 MHR_CLS_NAME::splitNode(std::array<Node::ptr_type, MaxLoad+1> & node, NodeWithChildren & fn, NodeWithChildren & sn) const {
-	
-	struct OverlapArea {
-		double o{std::numeric_limits<double>::max()};
-		double a{std::numeric_limits<double>::max()};
-		bool operator<(OverlapArea const & other) const {
-			return o == other.o ? a < other.a : o < other.o;
-		}
+	using Split = detail::RStarSplit<Boundary, MinLoad, MaxLoad+1>;
+	auto boundary = [&node](std::size_t i) -> Boundary const & {
+		return node[i]->boundary();
 	};
-	
-	auto minValue = [&node](std::array<std::size_t, MaxLoad+1> const & sort, auto quantity, auto initial) {
-		std::size_t minValuePosition = MinLoad;
-		for(std::size_t i(MinLoad); (MaxLoad+1-i) >= MinLoad; ++i) { //the different groupings with each node having at least MinLoad elements
-			Boundary fgBounds, sgBounds;
-			std::size_t j(0);
-			for(; j < i; ++j) { //first group
-				fgBounds.enlarge(node.at(sort.at(j))->boundary());
-			}
-			for(; j < MaxLoad+1; ++j) { //second group
-				sgBounds.enlarge(node.at(sort.at(j))->boundary());
-			}
-			auto q = quantity(fgBounds, sgBounds);
-			if (q < initial) {
-				q = initial;
-				minValuePosition = i;
-			}
+	//Jaccard similarity of the signatures of both groups
+	auto signatureOverlap = [this, &node](typename Split::Order const & order) {
+		constexpr std::size_t Count = MaxLoad+1;
+		PayloadDerefer pd;
+		SignatureCombine combine = straits().combine();
+		std::array<EnlargementValue, Count> prefix, suffix;
+		prefix[0] = enlargementValue(pd(node[order[0]]));
+		for(std::size_t i(1); i < Count-MinLoad; ++i) {
+			prefix[i] = combine(prefix[i-1], enlargementValue(pd(node[order[i]])));
 		}
-		return std::make_pair(initial, minValuePosition);
-	};
-	
-	auto quantityMargin = [](Boundary const & fgBounds, Boundary const & sgBounds) {
-		return fgBounds.lengthInM()+sgBounds.lengthInM();
-	};
-	auto quantityOverlapArea = [](Boundary const & fgBounds, Boundary const & sgBounds) {
-		OverlapArea oa;
-		oa.o = (fgBounds / sgBounds).area();
-		oa.a = fgBounds.area()+sgBounds.area();
-		return oa;
-	};
-	
-	enum {LATS_MIN=0, LATS_MAX=1, LONS_MIN=2, LONS_MAX=3};
-	std::array<std::array<std::size_t, MaxLoad+1>, 4> corners;
-	for(std::size_t i(0); i < 4; ++i) {
-		for(std::size_t j(0); j < MaxLoad+1; ++j) {
-			corners[i][j] = j;
+		suffix[Count-1] = enlargementValue(pd(node[order[Count-1]]));
+		for(std::size_t i(Count-1); i > MinLoad; --i) {
+			suffix[i-1] = combine(suffix[i], enlargementValue(pd(node[order[i-1]])));
 		}
-	}
-	
-	std::sort(corners[LATS_MIN].begin(), corners[LATS_MIN].end(), [&node](std::size_t a, std::size_t b) {
-		return node.at(a)->boundary().minLat() < node.at(b)->boundary().minLat();
-	});
-	std::sort(corners[LATS_MAX].begin(), corners[LATS_MAX].end(), [&node](std::size_t a, std::size_t b) {
-		return node.at(a)->boundary().maxLat() < node.at(b)->boundary().maxLat();
-	});
-	std::sort(corners[LONS_MIN].begin(), corners[LONS_MIN].end(), [&node](std::size_t a, std::size_t b) {
-		return node.at(a)->boundary().minLon() < node.at(b)->boundary().minLon();
-	});
-	std::sort(corners[LONS_MAX].begin(), corners[LONS_MAX].end(), [&node](std::size_t a, std::size_t b) {
-		return node.at(a)->boundary().maxLon() < node.at(b)->boundary().maxLon();
-	});
-	
-	//BEGIN ChooseSplitAxis
-	std::array<double, 4> margins; //best margins for each sort
-	for(std::size_t k(0); k < 4; ++k) {
-		margins[k] = minValue(corners[k], quantityMargin, std::numeric_limits<double>::max()).first;
-	}
-	auto m = std::min_element(margins.begin(), margins.end()) - margins.begin();
-	//END ChooseSplitAxis
-	
-	//BEGIN ChooseSplitIndex
-	auto splitIndex = minValue(corners.at(m), quantityOverlapArea, OverlapArea());
-	//END ChooseSplitIndex
-	
+		std::array<double, Count> result;
+		for(std::size_t i(MinLoad); Count-i >= MinLoad; ++i) {
+			result[i] = std::max<double>(0, 1 - signatureEnlargement(prefix[i-1], suffix[i]) - signatureEnlargement(suffix[i], prefix[i-1]));
+		}
+		return result;
+	};
+	Split split;
+	auto r = split(boundary, signatureOverlap, m_sw);
 	std::size_t i(0);
-	for(; i < splitIndex.second; ++i) {
-		fn.push_back(std::move(node.at(corners.at(m).at(i))));
+	for(; i < r.splitPosition; ++i) {
+		fn.push_back(std::move(node.at(r.order.at(i))));
 	}
 	for(; i < MaxLoad+1; ++i) {
-		sn.push_back(std::move(node.at(corners.at(m).at(i))));
+		sn.push_back(std::move(node.at(r.order.at(i))));
 	}
 }
 
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <ostream>
+#include <unordered_map>
+
+namespace srtree {
+
+///Concurrent cache of signatures of strings that occur very often, e.g. the key:value pairs of OSM items
+///The strings are identified by 64 bit keys, see key(). The cache is split into shards with their own lock,
+///each shard evicts entries by the CLOCK algorithm once its share of the memory budget is used up.
+///Signatures are computed outside of the lock, hence two threads may compute the same signature at the same time.
+///The memory budget only accounts for sizeof(Signature) and the bookkeeping, not for memory owned by the signatures.
+///
+///Usage:
+///SignatureCache<Signature> cache(budget);
+///Signature sig = cache.get(SignatureCache<Signature>::key(keyId, valueId), [&]() { return straits.signature(str); });
+template<typename T_SIGNATURE>
+class SignatureCache final {
+public:
+	using Signature = T_SIGNATURE;
+	using key_type = uint64_t;
+	static constexpr std::size_t DefaultShardCount = 64;
+	///Estimated memory of an entry besides the signature: key, reference bit and hash map node
+	static constexpr std::size_t EntryOverhead = 2*sizeof(key_type) + 4*sizeof(void*);
+	struct Stats {
+		uint64_t hits{0};
+		uint64_t misses{0};
+		uint64_t evictions{0};
+		std::size_t size{0};
+		std::size_t capacity{0};
+		double hitRate() const { return hits+misses ? double(hits)/(hits+misses) : 0; }
+		friend std::ostream & operator<<(std::ostream & out, Stats const & s) {
+			return out << "hits=" << s.hits << " misses=" << s.misses << " hit rate=" << 100*s.hitRate() << "%"
+				<< " evictions=" << s.evictions << " entries=" << s.size << "/" << s.capacity;
+		}
+	};
+public:
+	///@param memoryBudget in bytes, 0 disables the cache
+	SignatureCache(std::size_t memoryBudget, std::size_t shardCount = DefaultShardCount) :
+	m_shards( std::max<std::size_t>(1, std::min(shardCount, entries(memoryBudget))) )
+	{
+		for(Shard & shard : m_shards) {
+			shard.capacity = entries(memoryBudget) / m_shards.size();
+			shard.slots.reserve(shard.capacity);
+		}
+	}
+	SignatureCache(SignatureCache const &) = delete;
+	~SignatureCache() {}
+	SignatureCache & operator=(SignatureCache const &) = delete;
+public:
+	static inline key_type key(uint32_t first, uint32_t second) {
+		return (key_type(first) << 32) | second;
+	}
+	///Signature of @param k, computed by @param compute if it is not in the cache
+	template<typename T_COMPUTE>
+	Signature get(key_type k, T_COMPUTE && compute) {
+		Shard & shard = m_shards[mix(k) % m_shards.size()];
+		if (!shard.capacity) {
+			m_misses.fetch_add(1, std::memory_order_relaxed);
+			return compute();
+		}
+		{
+			std::lock_guard<std::mutex> lck(shard.lock);
+			auto it = shard.index.find(k);
+			if (it != shard.index.end()) {
+				Slot & slot = shard.slots[it->second];
+				slot.referenced = true;
+				m_hits.fetch_add(1, std::memory_order_relaxed);
+				return slot.sig;
+			}
+		}
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+		Signature sig = compute();
+		std::lock_guard<std::mutex> lck(shard.lock);
+		if (shard.index.count(k)) {
+			return sig;
+		}
+		if (shard.slots.size() < shard.capacity) {
+			shard.index.emplace(k, shard.slots.size());
+			shard.slots.push_back(Slot{k, sig, false});
+			return sig;
+		}
+		//CLOCK: clear the reference bits until an entry without one is found
+		while (shard.slots[shard.hand].referenced) {
+			shard.slots[shard.hand].referenced = false;
+			shard.hand = (shard.hand+1) % shard.slots.size();
+		}
+		Slot & victim = shard.slots[shard.hand];
+		shard.index.erase(victim.key);
+		shard.index.emplace(k, shard.hand);
+		victim.key = k;
+		victim.sig = sig;
+		shard.hand = (shard.hand+1) % shard.slots.size();
+		m_evictions.fetch_add(1, std::memory_order_relaxed);
+		return sig;
+	}
+	Stats stats() const {
+		Stats result;
+		result.hits = m_hits.load(std::memory_order_relaxed);
+		result.misses = m_misses.load(std::memory_order_relaxed);
+		result.evictions = m_evictions.load(std::memory_order_relaxed);
+		for(Shard const & shard : m_shards) {
+			std::lock_guard<std::mutex> lck(shard.lock);
+			result.size += shard.slots.size();
+			result.capacity += shard.capacity;
+		}
+		return result;
+	}
+private:
+	struct Slot {
+		key_type key;
+		Signature sig;
+		bool referenced;
+	};
+	struct Shard {
+		mutable std::mutex lock;
+		std::unordered_map<key_type, std::size_t> index;
+		std::vector<Slot> slots;
+		std::size_t hand{0};
+		std::size_t capacity{0};
+	};
+private:
+	static inline std::size_t entries(std::size_t memoryBudget) {
+		return memoryBudget / (sizeof(Signature) + EntryOverhead);
+	}
+	///Keys of consecutive ids differ only in their lowest bits, spread them over all shards
+	static inline key_type mix(key_type k) {
+		k ^= k >> 33;
+		k *= 0xFF51AFD7ED558CCDull;
+		return k ^ (k >> 33);
+	}
+private:
+	std::vector<Shard> m_shards;
+	std::atomic<uint64_t> m_hits{0};
+	std::atomic<uint64_t> m_misses{0};
+	std::atomic<uint64_t> m_evictions{0};
+};
+
+}//end namespace srtree
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <srtree/BBitMinWiseSignature.h>
+#include <srtree/QGram.h>
+#include <srtree/PredicateProgram.h>
+
+#include <sserialize/Static/Version.h>
+#include <sserialize/utility/exceptions.h>
+
+#include <boost/rational.hpp>
+
+namespace srtree::detail {
+
+///Query side of BBitSerializationTraitsAdapter, the signatures of the tree are BBitMinWiseSignature
+///T_BASE_TRAIT is a MinWiseSignatureTraits, its generator computes the signatures of queries
+template<typename T_BASE_TRAIT, std::size_t T_BITS>
+class BBitDeserializationTraitsAdapter: private sserialize::Static::SimpleVersion<1>, public T_BASE_TRAIT {
+public:
+	using Version = sserialize::Static::SimpleVersion<1>;
+	using Parent = T_BASE_TRAIT;
+	static constexpr std::size_t Bits = T_BITS;
+	using Signature = BBitMinWiseSignature<Parent::SignatureSize, Bits>;
+public:
+	class Deserializer {
+	public:
+		using Type = Signature;
+	public:
+		Signature operator()(Type v) const {
+			return v;
+		}
+	};
+
+	///Jaccard index corrected for accidental collisions of the b-bit entries
+	///(P - C)/(1 - C) with the fraction P of equal entries and the collision probability C = 2^-b
+	struct Resemblence {
+		boost::rational<int64_t> operator()(Signature const & first, Signature const & second) const {
+			int64_t k = Signature::size;
+			int64_t c = int64_t(1) << Bits;
+			int64_t eq = first / second;
+			return boost::rational<int64_t>(std::max<int64_t>(0, eq*c - k), k*(c-1));
+		}
+	};
+
+	class MayHaveMatch final {
+	public:
+		MayHaveMatch(MayHaveMatch const &) = default;
+		MayHaveMatch(MayHaveMatch &&) = default;
+		MayHaveMatch & operator=(MayHaveMatch const &) = default;
+		MayHaveMatch & operator=(MayHaveMatch &&) = default;
+		~MayHaveMatch() {}
+	public:
+		bool operator()(Signature const & ns) const {
+			return m_p([&ns](LeafNode const & leaf) { return leaf.matches(ns); });
+		}
+		MayHaveMatch operator/(MayHaveMatch const & other) const {
+			return MayHaveMatch(m_p / other.m_p);
+		}
+		MayHaveMatch operator+(MayHaveMatch const & other) const {
+			return MayHaveMatch(m_p + other.m_p);
+		}
+	private:
+		///The b-bit entries do not allow to combine the node signature with the reference.
+		///Instead the size of the intersection is estimated by J*(|A|+|B|)/(1+J) with the stored cardinality |A| of the node.
+		///J is the fraction of equal entries without the collision correction. It overestimates the jaccard index,
+		///hence the test is never stricter than the one with the corrected estimate.
+		///The stored |A| is an upper bound of the number of q-grams of the node (see BBitMinWiseSignature::cardinalityBound()),
+		///a larger |A| only makes the test less strict.
+		class LeafNode {
+		public:
+			LeafNode(Signature const & ref, std::size_t refSize, int32_t threshold) : m_ref(ref), m_refSize(refSize), m_th(threshold) {}
+		public:
+			bool matches(Signature const & ns) const {
+				if (m_th <= 0) {
+					return true;
+				}
+				//j*(|A|+|B|)/(1+j) >= th with j = eq/size without any division
+				int64_t eq = ns / m_ref;
+				return eq*(int64_t(ns.cardinality()) + int64_t(m_refSize)) >= int64_t(m_th)*(int64_t(Signature::size) + eq);
+			}
+		private:
+			Signature m_ref;
+			std::size_t m_refSize;
+			int32_t m_th;
+		};
+		using Program = PredicateProgram<LeafNode>;
+	private:
+		friend class BBitDeserializationTraitsAdapter;
+	private:
+		MayHaveMatch(Program && p) : m_p(std::move(p)) {}
+	private:
+		Program m_p;
+	};
+public:
+	BBitDeserializationTraitsAdapter() {}
+	BBitDeserializationTraitsAdapter(sserialize::UByteArrayAdapter d) :
+	Version(d, Version::Consume()),
+	Parent(d)
+	{
+		d += sserialize::SerializationInfo<Parent>::sizeInBytes( static_cast<Parent const &>(*this) );
+		uint8_t bits;
+		d >> bits;
+		if (bits != Bits) {
+			throw sserialize::TypeMissMatchException("BBitDeserializationTraitsAdapter: signatures have " + std::to_string(bits) + " bits instead of " + std::to_string(Bits));
+		}
+	}
+	BBitDeserializationTraitsAdapter(BBitDeserializationTraitsAdapter && other) = default;
+	~BBitDeserializationTraitsAdapter() override {}
+	BBitDeserializationTraitsAdapter & operator=(BBitDeserializationTraitsAdapter &&) = default;
+	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const {
+		return 1+sserialize::SerializationInfo<Parent>::sizeInBytes( static_cast<Parent const &>(*this) )+1;
+	}
+public:
+	Deserializer deserializer() const { return Deserializer(); }
+	MayHaveMatch mayHaveMatch(std::string const & str, std::size_t editDistance) const {
+		QGram qg(str, this->q());
+		auto sig = Parent::signature(qg);
+		int32_t th = int32_t(qg.base().size() + qg.q() - 1) - int32_t(editDistance * qg.q());
+		return MayHaveMatch( typename MayHaveMatch::Program(typename MayHaveMatch::LeafNode(Signature(sig, qg.size()), qg.size(), th)) );
+	}
+	///b-bit signature of @param str
+	Signature signature(std::string const & str) const {
+		auto sig = Parent::signature(str);
+		return Signature(sig, Signature::cardinalityBound(this->sg().cardinality(sig)));
+	}
+};
+
+}//end namespace srtree::detail
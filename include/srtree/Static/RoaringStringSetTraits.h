@@ -0,0 +1,80 @@
+#pragma once
+
+#include <sserialize/Static/UnicodeTrie/FlatTrie.h>
+#include <sserialize/Static/Version.h>
+
+#include <srtree/RoaringBitmap.h>
+#include <srtree/PredicateProgram.h>
+
+namespace srtree::Static::detail {
+
+/**
+ * struct RoaringStringSetTraits: Version(1) {
+ *   sserialize::Static::UnicodeTrie::FlatTrie<uint32_t> str2Id;
+ * }
+ * The signatures are serialized RoaringBitmap, usually stored by the DedupDeserializationTraitsAdapter
+ */
+
+class RoaringStringSetTraits {
+private:
+	struct Data: sserialize::Static::SimpleVersion<1> {
+		using Version = sserialize::Static::SimpleVersion<1>;
+		sserialize::Static::UnicodeTrie::FlatTrie<uint32_t> str2Id;
+		Data(sserialize::UByteArrayAdapter d);
+		sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const;
+	};
+	using DataPtr = std::shared_ptr<Data>;
+public:
+	using StaticTraits = RoaringStringSetTraits;
+public:
+	using Signature = srtree::RoaringBitmap;
+
+	class Deserializer {
+	public:
+		using Type = Signature;
+	public:
+		inline Signature operator()(Type v) const {
+			return v;
+		}
+	};
+
+	class MayHaveMatch final {
+	public:
+		MayHaveMatch(MayHaveMatch const & other) = default;
+		MayHaveMatch(MayHaveMatch && other) = default;
+		MayHaveMatch & operator=(MayHaveMatch const&) = default;
+		MayHaveMatch & operator=(MayHaveMatch &&) = default;
+		~MayHaveMatch();
+	public:
+		bool operator()(Signature const & ns) const;
+		MayHaveMatch operator/(MayHaveMatch const & other) const;
+		MayHaveMatch operator+(MayHaveMatch const & other) const;
+	private:
+		friend class RoaringStringSetTraits;
+	private:
+		using Program = srtree::detail::PredicateProgram<Signature>;
+	private:
+		MayHaveMatch(Signature const & reference);
+		MayHaveMatch(Program && p);
+	private:
+		Program m_p;
+	};
+public:
+	RoaringStringSetTraits();
+	RoaringStringSetTraits(sserialize::UByteArrayAdapter d);
+	RoaringStringSetTraits(RoaringStringSetTraits const &) = default;
+	RoaringStringSetTraits(RoaringStringSetTraits && other) = default;
+	virtual ~RoaringStringSetTraits();
+	RoaringStringSetTraits & operator=(RoaringStringSetTraits const &) = default;
+	RoaringStringSetTraits & operator=(RoaringStringSetTraits &&) = default;
+	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const;
+public:
+	MayHaveMatch mayHaveMatch(std::string const & str, uint32_t editDistance) const;
+	inline Deserializer deserializer() const { return Deserializer(); }
+public:
+	uint32_t strId(std::string const & str) const;
+private:
+	std::shared_ptr<Data> m_d;
+};
+
+}//end namespace srtree::Static::detail
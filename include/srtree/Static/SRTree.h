@@ -10,6 +10,7 @@
 
 #include <srtree/MinWiseSignatureTraits.h>
 #include <srtree/GeoRectGeometryTraits.h>
+#include <srtree/TraversalStatistics.h>
 
 namespace srtree::Static {
 namespace detail {
@@ -203,6 +204,13 @@ public:
 	///size(item.signature.intersect(sig)) >= sigBound
 	template<typename T_OUTPUT_ITERATOR>
 	void find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out) const;
+	
+	///Same as find(gmp, smp, out) but the predicates are evaluated in the order chosen per level by @param stats,
+	///which records the evaluations, see TraversalStatistics.
+	///Every reported item matches both predicates. Signature tests of internal nodes may be skipped, hence items below nodes
+	///whose signature gives a false negative (e.g. MinWise signatures) may be reported in addition to the ones of find(gmp, smp, out).
+	template<typename T_OUTPUT_ITERATOR>
+	void find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out, TraversalStatistics & stats) const;
 
 	///Visit all nodes obeying the following conditions:
 	///item.boundary.intersect(b) == TRUE
@@ -223,6 +231,10 @@ private:
 	Boundary boundary(uint32_t nodeId) const;
 	Signature signature(uint32_t nodeId) const;
 	ItemType item(uint32_t nodeId) const;
+	///Report the items whose path from the root only consists of children for which @param match returns true.
+	///@param match bool(uint32_t childId, Level level) where level is the level of the parent of the child, leaf nodes are in level 0
+	template<typename T_OUTPUT_ITERATOR, typename T_MATCH>
+	void traverse(T_OUTPUT_ITERATOR out, T_MATCH match) const;
 public:
 	SignatureTraits m_straits;
 	GeometryTraits m_gtraits;
@@ -325,19 +337,40 @@ MHR_TMPL_PARAMS
 template<typename T_OUTPUT_ITERATOR>
 void
 MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out) const {
+	traverse(out, [this, &gmp, &smp](uint32_t childId, Level) {
+		return gmp( boundary(childId) ) && smp( signature(childId) );
+	});
+}
+
+MHR_TMPL_PARAMS
+template<typename T_OUTPUT_ITERATOR>
+void
+MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OUTPUT_ITERATOR out, TraversalStatistics & stats) const {
+	traverse(out, [this, &gmp, &smp, &stats](uint32_t childId, Level level) {
+		return stats(level,
+			[&]() { return gmp( boundary(childId) ); },
+			[&]() { return smp( signature(childId) ); }
+		);
+	});
+}
+
+MHR_TMPL_PARAMS
+template<typename T_OUTPUT_ITERATOR, typename T_MATCH>
+void
+MHR_CLS_NAME::traverse(T_OUTPUT_ITERATOR out, T_MATCH match) const {
 	using OutputIterator = T_OUTPUT_ITERATOR;
+	using Match = T_MATCH;
 	struct Recurser {
 		SRTree const & that;
-		GeometryMatchPredicate & gmp;
-		SignatureMatchPredicate & smp;
 		OutputIterator & out;
+		Match & match;
 		void operator()(uint32_t nodeId, Level level) {
 			Node node = that.node(nodeId);
 			switch (that.type(level)) {
 			case INTERNAL_NODE:
 			{
 				for(uint32_t childId : node) {
-					if ( gmp( that.boundary(childId) ) && smp(that.signature(childId)) ) {
+					if ( match(childId, level) ) {
 						(*this)(childId, level-1);
 					}
 				}
@@ -346,7 +379,7 @@ MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OU
 			case LEAF_NODE:
 			{
 				for(uint32_t childId : node) {
-					if ( gmp( that.boundary(childId) ) && smp(that.signature(childId)) ) {
+					if ( match(childId, level) ) {
 						*out = that.item(childId);
 						++out;
 					}
@@ -356,14 +389,14 @@ MHR_CLS_NAME::find(GeometryMatchPredicate gmp, SignatureMatchPredicate smp, T_OU
 				break;
 			};
 		}
-		Recurser(SRTree const & that, GeometryMatchPredicate & gmp, SignatureMatchPredicate & smp, OutputIterator & out) :
-		that(that), gmp(gmp), smp(smp), out(out)
+		Recurser(SRTree const & that, OutputIterator & out, Match & match) :
+		that(that), out(out), match(match)
 		{}
 	};
 	if (!m_nodes.size()) {
 		return;
 	}
-	Recurser(*this, gmp, smp, out)(0, m_md.depth());
+	Recurser(*this, out, match)(0, m_md.depth());
 }
 
 MHR_TMPL_PARAMS
@@ -4,6 +4,8 @@
 #include <sserialize/Static/UnicodeTrie/FlatTrie.h>
 #include <sserialize/Static/Version.h>
 
+#include <srtree/PredicateProgram.h>
+
 namespace srtree::Static::detail {
 	
 /**
@@ -40,8 +42,8 @@ public:
 
 	class MayHaveMatch {
 	public:
-		MayHaveMatch(MayHaveMatch const & other);
-		MayHaveMatch(MayHaveMatch && other);
+		MayHaveMatch(MayHaveMatch const & other) = default;
+		MayHaveMatch(MayHaveMatch && other) = default;
 		MayHaveMatch & operator=(MayHaveMatch const&) = default;
 		MayHaveMatch & operator=(MayHaveMatch &&) = default;
 		~MayHaveMatch();
@@ -55,41 +57,12 @@ public:
 	private:
 		MayHaveMatch(DataPtr const & d, sserialize::ItemIndex const & reference);
 	private:
-		struct Node {
-			enum Type {LEAF, INTERSECT, UNITE};
-			virtual ~Node() {}
-			virtual bool matches(sserialize::ItemIndex const & v) = 0;
-			virtual std::unique_ptr<Node> copy() const = 0;
-		};
-		struct IntersectNode: public Node {
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-			bool matches(sserialize::ItemIndex const & v) override;
-			IntersectNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			~IntersectNode() override;
-			std::unique_ptr<Node> copy() const override;
-		};
-		struct UniteNode: public Node {
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-			~UniteNode() override;
-			bool matches(sserialize::ItemIndex const & v) override;
-			
-			UniteNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			std::unique_ptr<Node> copy() const override;
-		};
-		struct LeafNode: public Node {
-			~LeafNode() override;
-			bool matches(sserialize::ItemIndex const & v) override;
-			LeafNode(sserialize::ItemIndex const & ref);
-			std::unique_ptr<Node> copy() const override;
-			sserialize::ItemIndex ref;
-		};
+		using Program = srtree::detail::PredicateProgram<sserialize::ItemIndex>;
 	private:
-		MayHaveMatch(DataPtr const & d, std::unique_ptr<Node> && t);
+		MayHaveMatch(DataPtr const & d, Program && p);
 	private:
 		DataPtr m_d;
-		std::unique_ptr<Node> m_t;
+		Program m_p;
 	};
 public:
 	StringSetTraits();
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <shared_mutex>
+
 #include <sserialize/containers/ItemIndex.h>
 #include <sserialize/containers/ItemIndexFactory.h>
 #include <sserialize/containers/HashBasedFlatTrie.h>
 
 #include <srtree/Static/StringSetTraits.h>
+#include <srtree/PredicateProgram.h>
 
 namespace srtree::detail {
 	
@@ -24,6 +27,8 @@ private:
 	using String2IdMap = sserialize::HashBasedFlatTrie<StringId>;
 	struct Data {
 		sserialize::ItemIndexFactory idxFactory;
+		///Shared for reading indexes, exclusive for adding indexes
+		std::shared_mutex idxFactoryLock;
 		String2IdMap str2Id;
 		Data() {}
 		Data(sserialize::ItemIndexFactory && idxFactory) :
@@ -54,22 +59,36 @@ public:
 		}
 	};
 
+	///Thread-safe, the unions are computed concurrently, adding the result to the factory is serialized
 	class Combine {
 	public:
 		inline Signature operator()(Signature const & first, Signature const & second) {
-			return m_d->idxFactory.addIndex( m_d->idxFactory.indexById(first) + m_d->idxFactory.indexById(second) );
+			sserialize::ItemIndex result;
+			{
+				std::shared_lock<std::shared_mutex> lck(m_d->idxFactoryLock);
+				result = m_d->idxFactory.indexById(first) + m_d->idxFactory.indexById(second);
+			}
+			return add(result);
 		}
 		inline sserialize::ItemIndex operator()(sserialize::ItemIndex const & first, sserialize::ItemIndex const & second) {
 			return first + second;
 		}
 		template<typename Iterator>
 		Signature operator()(Iterator begin, Iterator end) {
-			return m_d->idxFactory.addIndex(
-				sserialize::treeReduceMap<Iterator, sserialize::ItemIndex>(begin, end, *this, [this](Signature sig) {
+			sserialize::ItemIndex result;
+			{
+				std::shared_lock<std::shared_mutex> lck(m_d->idxFactoryLock);
+				result = sserialize::treeReduceMap<Iterator, sserialize::ItemIndex>(begin, end, *this, [this](Signature sig) {
 						return m_d->idxFactory.indexById(sig);
 					}
-				)
-			);
+				);
+			}
+			return add(result);
+		}
+	private:
+		inline Signature add(sserialize::ItemIndex const & idx) {
+			std::unique_lock<std::shared_mutex> lck(m_d->idxFactoryLock);
+			return m_d->idxFactory.addIndex(idx);
 		}
 	private:
 		Combine(DataPtr const & d) :
@@ -81,10 +100,37 @@ public:
 		DataPtr m_d;
 	};
 	
+	///Fraction of the strings in the union of @param base and @param toAdd that are not in @param base
+	///The insertion heuristics work on the string sets (Value) since combining signatures adds the result to the factory
+	class Enlargement {
+	public:
+		using Value = sserialize::ItemIndex;
+	public:
+		inline Value value(Signature const & sig) const {
+			std::shared_lock<std::shared_mutex> lck(m_d->idxFactoryLock);
+			return m_d->idxFactory.indexById(sig);
+		}
+		inline double operator()(Value const & base, Value const & toAdd) const {
+			uint32_t us = (base + toAdd).size();
+			return us ? double(us - base.size())/us : 0;
+		}
+		inline double operator()(Signature const & base, Signature const & toAdd) const {
+			return (*this)(value(base), value(toAdd));
+		}
+	private:
+		Enlargement(DataPtr const & d) :
+		m_d(d)
+		{}
+	private:
+		friend class StringSetTraits;
+	private:
+		DataPtr m_d;
+	};
+	
 	class MayHaveMatch {
 	public:
-		MayHaveMatch(MayHaveMatch const & other);
-		MayHaveMatch(MayHaveMatch && other);
+		MayHaveMatch(MayHaveMatch const & other) = default;
+		MayHaveMatch(MayHaveMatch && other) = default;
 		MayHaveMatch & operator=(MayHaveMatch const&) = default;
 		MayHaveMatch & operator=(MayHaveMatch &&) = default;
 		~MayHaveMatch();
@@ -98,41 +144,12 @@ public:
 	private:
 		MayHaveMatch(DataPtr const & d, sserialize::ItemIndex const & reference);
 	private:
-		struct Node {
-			enum Type {LEAF, INTERSECT, UNITE};
-			virtual ~Node() {}
-			virtual bool matches(sserialize::ItemIndex const & v) = 0;
-			virtual std::unique_ptr<Node> copy() const = 0;
-		};
-		struct IntersectNode: public Node {
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-			bool matches(sserialize::ItemIndex const & v) override;
-			IntersectNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			~IntersectNode() override;
-			std::unique_ptr<Node> copy() const override;
-		};
-		struct UniteNode: public Node {
-			std::unique_ptr<Node> first;
-			std::unique_ptr<Node> second;
-			~UniteNode() override;
-			bool matches(sserialize::ItemIndex const & v) override;
-			
-			UniteNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second);
-			std::unique_ptr<Node> copy() const override;
-		};
-		struct LeafNode: public Node {
-			~LeafNode() override;
-			bool matches(sserialize::ItemIndex const & v) override;
-			LeafNode(sserialize::ItemIndex const & ref);
-			std::unique_ptr<Node> copy() const override;
-			sserialize::ItemIndex ref;
-		};
+		using Program = PredicateProgram<sserialize::ItemIndex>;
 	private:
-		MayHaveMatch(DataPtr const & d, std::unique_ptr<Node> && t);
+		MayHaveMatch(DataPtr const & d, Program && p);
 	private:
 		DataPtr m_d;
-		std::unique_ptr<Node> m_t;
+		Program m_p;
 	};
 public:
 	StringSetTraits();
@@ -142,6 +159,7 @@ public:
 	~StringSetTraits();
 public:
 	inline Combine combine() const { return Combine(m_d); }
+	inline Enlargement enlargement() const { return Enlargement(m_d); }
 	inline MayHaveMatch mayHaveMatch(sserialize::ItemIndex const & validStrings) const { return MayHaveMatch(m_d, validStrings); }
 	inline Serializer serializer() const { return Serializer(); }
 	inline Deserializer deserializer() const { return Deserializer(); }
@@ -154,12 +172,19 @@ public:
 		return addSignature( sserialize::ItemIndex(std::vector<uint32_t>(stringId, 1)) );
 	}
 	Signature addSignature(sserialize::ItemIndex const & strIdSet) {
+		std::unique_lock<std::shared_mutex> lck(m_d->idxFactoryLock);
 		return idxFactory().addIndex(strIdSet); 
 	}
 	template<typename T_STRING_ID_ITERATOR>
 	Signature addSignature(T_STRING_ID_ITERATOR begin, T_STRING_ID_ITERATOR end) {
+		std::unique_lock<std::shared_mutex> lck(m_d->idxFactoryLock);
 		return idxFactory().addIndex(begin, end);
 	}
+	///The string ids of @param sig
+	sserialize::ItemIndex strIds(Signature const & sig) const {
+		std::shared_lock<std::shared_mutex> lck(m_d->idxFactoryLock);
+		return idxFactory().indexById(sig);
+	}
 public:
 	sserialize::ItemIndexFactory & idxFactory() { return m_d->idxFactory; }
 	sserialize::ItemIndexFactory const & idxFactory() const { return m_d->idxFactory; }
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace srtree {
+
+///Adaptive evaluation of the geometry and the signature predicate during a tree traversal and the statistics it is based on.
+///The conjunction gmp(boundary) && smp(signature) of a child is evaluated with the cheaper or more selective predicate first,
+///decided per level of the tree. At internal levels the signature test is skipped if it almost never prunes.
+///Children of leaf nodes are items, their signature test is never skipped since it decides the result.
+///
+///Evaluations are sampled: during the first Config::minSamples tests of a level and for every Config::sampleRate-th test after that
+///both predicates are evaluated and timed. The order of a level is revised after each sample with the rule for two independent conjuncts:
+///a first is cheaper iff cost(a)*(1-pass(b)) < cost(b)*(1-pass(a)).
+///The statistics are kept between traversals, reuse an instance for queries of the same tree to reuse what it learned.
+///
+///Usage:
+///TraversalStatistics stats;
+///tree.find(gmp, smp, out, stats);
+///std::cout << stats;
+class TraversalStatistics final {
+public:
+	enum class Order : uint8_t {GEOMETRY_FIRST, SIGNATURE_FIRST, GEOMETRY_ONLY};
+	struct Config {
+		///Every sampleRate-th test of a level is sampled, 0 only samples the first minSamples tests
+		uint32_t sampleRate{64};
+		///Number of samples of a level before its order is changed
+		uint32_t minSamples{32};
+		///The signature test of internal levels is skipped if at least this fraction of the samples passes it
+		double skipPassRate{0.98};
+	};
+	///Counters of the tests of the children of nodes in one level, level 0 are the leaf nodes whose children are items
+	struct Level {
+		uint64_t tested{0};
+		uint64_t accepted{0};
+		uint64_t geometryCalls{0};
+		uint64_t signatureCalls{0};
+		uint64_t samples{0};
+		///Passed tests and time in nanoseconds of the sampled evaluations
+		uint64_t geometryPassed{0};
+		uint64_t signaturePassed{0};
+		uint64_t geometryTime{0};
+		uint64_t signatureTime{0};
+		Order order{Order::GEOMETRY_FIRST};
+		double geometryPassRate() const { return samples ? double(geometryPassed)/samples : 1; }
+		double signaturePassRate() const { return samples ? double(signaturePassed)/samples : 1; }
+		double geometryCost() const { return samples ? double(geometryTime)/samples : 0; }
+		double signatureCost() const { return samples ? double(signatureTime)/samples : 0; }
+	};
+public:
+	TraversalStatistics() {}
+	TraversalStatistics(Config const & cfg) : m_cfg(cfg) {}
+	~TraversalStatistics() {}
+public:
+	///@return gmp() && smp() for a child of a node in @param level, evaluated in the order chosen for the level
+	template<typename T_GEOMETRY_TEST, typename T_SIGNATURE_TEST>
+	bool operator()(std::size_t level, T_GEOMETRY_TEST && gmp, T_SIGNATURE_TEST && smp) {
+		if (level >= m_levels.size()) {
+			m_levels.resize(level+1);
+		}
+		Level & l = m_levels[level];
+		++l.tested;
+		bool result;
+		if (l.samples < m_cfg.minSamples || (m_cfg.sampleRate && l.tested % m_cfg.sampleRate == 0)) {
+			using clock = std::chrono::steady_clock;
+			auto t0 = clock::now();
+			bool g = gmp();
+			auto t1 = clock::now();
+			bool s = smp();
+			auto t2 = clock::now();
+			++l.samples;
+			++l.geometryCalls;
+			++l.signatureCalls;
+			l.geometryPassed += g;
+			l.signaturePassed += s;
+			l.geometryTime += std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+			l.signatureTime += std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count();
+			decide(l, level == 0);
+			result = g && s;
+		}
+		else {
+			switch (l.order) {
+			case Order::SIGNATURE_FIRST:
+				++l.signatureCalls;
+				result = smp();
+				if (result) {
+					++l.geometryCalls;
+					result = gmp();
+				}
+				break;
+			case Order::GEOMETRY_ONLY:
+				++l.geometryCalls;
+				result = gmp();
+				break;
+			case Order::GEOMETRY_FIRST:
+			default:
+				++l.geometryCalls;
+				result = gmp();
+				if (result) {
+					++l.signatureCalls;
+					result = smp();
+				}
+				break;
+			}
+		}
+		l.accepted += result;
+		return result;
+	}
+public:
+	Config const & config() const { return m_cfg; }
+	std::vector<Level> const & levels() const { return m_levels; }
+	///Forget all statistics and decisions
+	void reset() { m_levels.clear(); }
+	friend std::ostream & operator<<(std::ostream & out, TraversalStatistics const & stats) {
+		static const char * orderNames[] = {"geometry first", "signature first", "geometry only"};
+		for(std::size_t i(stats.levels().size()); i > 0; --i) {
+			Level const & l = stats.levels()[i-1];
+			out << "Level " << i-1 << ": " << orderNames[int(l.order)]
+				<< ", tested=" << l.tested << " accepted=" << l.accepted
+				<< " geometry calls=" << l.geometryCalls << " signature calls=" << l.signatureCalls
+				<< ", sampled pass rates geometry=" << 100*l.geometryPassRate() << "% signature=" << 100*l.signaturePassRate() << "%"
+				<< ", sampled costs geometry=" << l.geometryCost() << "ns signature=" << l.signatureCost() << "ns\n";
+		}
+		return out;
+	}
+private:
+	void decide(Level & l, bool itemLevel) const {
+		if (l.samples < m_cfg.minSamples) {
+			return;
+		}
+		if (!itemLevel && l.signaturePassRate() >= m_cfg.skipPassRate) {
+			l.order = Order::GEOMETRY_ONLY;
+		}
+		else if (l.signatureCost()*(1-l.geometryPassRate()) < l.geometryCost()*(1-l.signaturePassRate())) {
+			l.order = Order::SIGNATURE_FIRST;
+		}
+		else {
+			l.order = Order::GEOMETRY_FIRST;
+		}
+	}
+private:
+	Config m_cfg;
+	std::vector<Level> m_levels;
+};
+
+}//end namespace srtree
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <srtree/SRTree.h>
+#include <srtree/ConcurrentInserter.h>
+#include <srtree/OOMSRTreeBuilder.h>
+#include <srtree/SignatureCache.h>
 
 #include <srtree/QGram.h>
 
@@ -25,7 +28,6 @@ struct OMHRTree {
 	using Signature = typename Tree::Signature;
 	struct State {
 		Tree tree;
-		std::mutex treeLock;
 		std::vector<typename Tree::ItemNode const *> itemNodes;
 		State(std::size_t q, std::size_t hashSize) : tree(SignatureTraits(q, hashSize)) {}
 	};
@@ -36,6 +38,8 @@ struct OMHRTree {
 		sserialize::SimpleBitVector processedItems;
 		std::mutex processedItemsLock;
 		typename SignatureTraits::Combine combine;
+		///Signatures of key:value pairs by (keyId, valueId), shared by all threads
+		std::unique_ptr< srtree::SignatureCache<Signature> > kvSignatures;
 	public:
 		CreationState(SignatureTraits const & straits) : combine(straits.combine()) {}
 	};
@@ -44,9 +48,15 @@ public:
 	cmp(cmp), state(q, hashSize), cstate(state.tree.straits()) {}
 public:
 	void setCheck(bool check) { this->check = check; }
+	///Cache the signatures of key:value pairs, @param memoryBudget in bytes, 0 disables the cache
+	void setSignatureCacheSize(std::size_t memoryBudget);
 public:
 	void init();
 	void create(uint32_t numThreads);
+	///Build the tree out-of-memory and write it directly to @param treeData, the traits to @param traitsData
+	///The in-memory tree stays empty
+	///@param memoryBudget in bytes
+	void createOOM(sserialize::UByteArrayAdapter & treeData, sserialize::UByteArrayAdapter & traitsData, uint32_t numThreads, std::size_t memoryBudget);
 public:
 	void serialize(sserialize::UByteArrayAdapter & treeData, sserialize::UByteArrayAdapter & traitsData);
 	bool equal(sserialize::UByteArrayAdapter treeData, sserialize::UByteArrayAdapter traitsData);
@@ -55,6 +65,11 @@ public:
 	Signature cellSignature(uint32_t cellId);
 	Signature itemSignature(uint32_t itemId);
 private:
+	///Compute cstate.regionSignatures and cstate.cellSignatures
+	void computeBaseSignatures();
+	///Signature of an item including the signatures of its cells
+	Signature combinedItemSignature(uint32_t itemId);
+	void printSignatureCacheStats() const;
 	std::string normalize(std::string const & str) const;
 	sserialize::ItemIndex matchingItems(typename Tree::GeometryMatchPredicate & gmp, typename Tree::SignatureMatchPredicate & smp);
 	std::set<std::string> strings(liboscar::Static::OsmKeyValueObjectStore::Item const & item, bool inherited) const;
@@ -71,7 +86,26 @@ public:
 
 template<typename T_PARAMETRISED_HASH_FUNCTION>
 void
-OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::create(uint32_t numThreads) {
+OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::setSignatureCacheSize(std::size_t memoryBudget) {
+	if (memoryBudget) {
+		cstate.kvSignatures.reset( new srtree::SignatureCache<Signature>(memoryBudget) );
+	}
+	else {
+		cstate.kvSignatures.reset();
+	}
+}
+
+template<typename T_PARAMETRISED_HASH_FUNCTION>
+void
+OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::printSignatureCacheStats() const {
+	if (cstate.kvSignatures) {
+		std::cout << "Key-value signature cache: " << cstate.kvSignatures->stats() << std::endl;
+	}
+}
+
+template<typename T_PARAMETRISED_HASH_FUNCTION>
+void
+OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::computeBaseSignatures() {
 	sserialize::ProgressInfo pinfo;
 	cstate.regionSignatures.resize(cmp->store().geoHierarchy().regionSize());
 	pinfo.begin(cmp->store().geoHierarchy().regionSize(), "Computing region signatures");
@@ -87,6 +121,25 @@ OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::create(uint32_t numThreads) {
 		pinfo(cellId);
 	}
 	pinfo.end();
+}
+
+template<typename T_PARAMETRISED_HASH_FUNCTION>
+typename OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::Signature
+OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::combinedItemSignature(uint32_t itemId) {
+	auto isig = itemSignature(itemId);
+	for(auto x : cmp->store().cells(itemId)) {
+		isig = cstate.combine(isig, cstate.cellSignatures.at(x));
+	}
+	SSERIALIZE_EXPENSIVE_ASSERT_EXEC(auto istrs = strings(cmp->store().at(itemId), true));
+	SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(isig, state.tree.straits().signature(istrs.begin(), istrs.end()));
+	return isig;
+}
+
+template<typename T_PARAMETRISED_HASH_FUNCTION>
+void
+OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::create(uint32_t numThreads) {
+	sserialize::ProgressInfo pinfo;
+	computeBaseSignatures();
 	
 	state.itemNodes.resize(cmp->store().size(), 0);
 	
@@ -94,7 +147,11 @@ OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::create(uint32_t numThreads) {
 	
 	pinfo.begin(cmp->store().size(), "Inserting items");
 	std::atomic<uint32_t> cellIdIt{0};
+	srtree::ConcurrentInserter<Tree> inserter(state.tree, [this](typename Tree::ItemNode const * in) {
+		state.itemNodes.at(in->item()) = in;
+	});
 	sserialize::ThreadPool::execute([&](){
+		auto buffer = inserter.buffer();
 		uint32_t cs(cmp->store().geoHierarchy().cellSize());
 		while (true) {
 			uint32_t cellId = cellIdIt.fetch_add(1, std::memory_order_relaxed);
@@ -111,38 +168,84 @@ OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::create(uint32_t numThreads) {
 					cstate.processedItems.set(itemId);
 				}
 				auto b = cmp->store().geoShape(itemId).boundary();
-				auto isig = itemSignature(itemId);
-				for(auto x : cmp->store().cells(itemId)) {
-					isig = cstate.combine(isig, cstate.cellSignatures.at(x));
-				}
-				SSERIALIZE_EXPENSIVE_ASSERT_EXEC(auto istrs = strings(cmp->store().at(itemId), true));
-				SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(isig, state.tree.straits().signature(istrs.begin(), istrs.end()));
-				{
-					std::lock_guard<std::mutex> lck(state.treeLock);
-					state.itemNodes.at(itemId) = state.tree.insert(b, isig, itemId);
-				}
+				auto isig = combinedItemSignature(itemId);
+				buffer.insert(typename Tree::ItemDescription{b, std::move(isig), itemId});
 				++numProcItems;
 				pinfo(numProcItems);
 			}
 			if (check) {
-				std::lock_guard<std::mutex> lck(state.treeLock);
-				if (!state.tree.checkConsistency()) {
+				buffer.flush();
+				bool ok = inserter.exclusive([](Tree const & tree) {
+					return tree.checkConsistency();
+				});
+				if (!ok) {
 					throw sserialize::CreationException("Tree failed consistency check!");
 				}
 			}
 		}
+		buffer.flush();
 	},
 	numThreads,
 	sserialize::ThreadPool::CopyTaskTag());
 	pinfo.end();
 	
+	printSignatureCacheStats();
+	
 	if (check && !state.tree.checkConsistency()) {
 		throw sserialize::CreationException("Tree failed consistency check!");
 	}
 	
 	pinfo.begin(1, "Calculating signatures");
-	state.tree.recalculateSignatures();
+	state.tree.recalculateSignatures(numThreads);
+	pinfo.end();
+}
+
+template<typename T_PARAMETRISED_HASH_FUNCTION>
+void
+OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::createOOM(sserialize::UByteArrayAdapter & treeData, sserialize::UByteArrayAdapter & traitsData, uint32_t numThreads, std::size_t memoryBudget) {
+	using Builder = srtree::OOMSRTreeBuilder<SignatureTraits, GeometryTraits, Tree::MaxLoad>;
+	sserialize::ProgressInfo pinfo;
+	computeBaseSignatures();
+	
+	Builder builder(state.tree.straits(), state.tree.gtraits(), memoryBudget);
+	std::atomic<uint32_t> numProcItems = 0;
+	
+	pinfo.begin(cmp->store().size(), "Staging items");
+	std::atomic<uint32_t> cellIdIt{0};
+	sserialize::ThreadPool::execute([&](){
+		uint32_t cs(cmp->store().geoHierarchy().cellSize());
+		while (true) {
+			uint32_t cellId = cellIdIt.fetch_add(1, std::memory_order_relaxed);
+			if (cellId >= cs) {
+				break;
+			}
+			sserialize::ItemIndex cellItems = cmp->indexStore().at(cmp->store().geoHierarchy().cellItemsPtr(cellId));
+			for(uint32_t itemId : cellItems) {
+				{
+					std::lock_guard<std::mutex> lck(cstate.processedItemsLock);
+					if (cstate.processedItems.isSet(itemId)) {
+						continue;
+					}
+					cstate.processedItems.set(itemId);
+				}
+				builder.insert(cmp->store().geoShape(itemId).boundary(), combinedItemSignature(itemId), itemId);
+				++numProcItems;
+				pinfo(numProcItems);
+			}
+		}
+	},
+	numThreads,
+	sserialize::ThreadPool::CopyTaskTag());
 	pinfo.end();
+	
+	printSignatureCacheStats();
+	
+	//Region and cell signatures are not needed anymore
+	cstate.regionSignatures = std::vector<Signature>();
+	cstate.cellSignatures = std::vector<Signature>();
+	
+	builder.serialize(treeData, numThreads);
+	traitsData << state.tree.straits() << state.tree.gtraits();
 }
 
 
@@ -303,7 +406,15 @@ OMHRTree<T_PARAMETRISED_HASH_FUNCTION>::itemSignature(uint32_t itemId) {
 	auto item = cmp->store().at(itemId);
 	Signature sig;
 	for(uint32_t i(0), s(item.size()); i < s; ++i) {
-		sig = cstate.combine(sig, state.tree.straits().signature(keyValue(item, i)));
+		if (cstate.kvSignatures) {
+			auto key = srtree::SignatureCache<Signature>::key(item.keyId(i), item.valueId(i));
+			sig = cstate.combine(sig, cstate.kvSignatures->get(key, [&]() {
+				return state.tree.straits().signature(keyValue(item, i));
+			}));
+		}
+		else {
+			sig = cstate.combine(sig, state.tree.straits().signature(keyValue(item, i)));
+		}
 	}
 	return sig;
 }
@@ -6,6 +6,7 @@
 #include <liboscar/KVStats.h>
 
 #include <srtree/SRTree.h>
+#include <srtree/ConcurrentInserter.h>
 
 template<typename T_QGRAM_TRAITS = srtree::detail::PQGramTraits>
 struct OPQGramsRTree {
@@ -65,13 +66,29 @@ OPQGramsRTree<T_QGRAM_TRAITS>::create() {
 	sserialize::ProgressInfo pinfo;
 	
 	pinfo.begin(cmp->store().size(), "Gathering candidate strings");
-	for(uint32_t i(0), s(cmp->store().size()); i < s; ++i) {
-		auto item = cmp->store().kvItem(i);
-		for(uint32_t j(0), js(item.size()); j < js; ++j) {
-			std::string token = "@" + item.key(j) + ":" + item.value(j);
-			state.tree.straits().add( normalize(token) );
+	{
+		//the tokens of a chunk of items are computed in parallel and then added to the q-gram db in parallel
+		constexpr uint32_t ChunkSize = 1 << 16;
+		std::vector<std::vector<std::string>> itemTokens;
+		std::vector<std::string> tokens;
+		for(uint32_t begin(0), s(cmp->store().size()); begin < s; begin += ChunkSize) {
+			uint32_t end = std::min(s, begin+ChunkSize);
+			itemTokens.assign(end-begin, std::vector<std::string>());
+			#pragma omp parallel for schedule(dynamic, 256)
+			for(uint32_t i = begin; i < end; ++i) {
+				auto item = cmp->store().kvItem(i);
+				for(uint32_t j(0), js(item.size()); j < js; ++j) {
+					std::string token = "@" + item.key(j) + ":" + item.value(j);
+					itemTokens[i-begin].push_back( normalize(token) );
+				}
+			}
+			tokens.clear();
+			for(auto & x : itemTokens) {
+				std::move(x.begin(), x.end(), std::back_inserter(tokens));
+			}
+			state.tree.straits().add(tokens);
+			pinfo(end);
 		}
-		pinfo(i);
 	}
 	pinfo.end();
 	
@@ -96,46 +113,55 @@ OPQGramsRTree<T_QGRAM_TRAITS>::create() {
 	pinfo.begin(cmp->store().size(), "Inserting items");
 	uint32_t cs(cmp->store().geoHierarchy().cellSize());
 	
-	#pragma omp parallel for schedule(dynamic, 1)
-	for(uint32_t cellId = 0; cellId < cs; ++cellId) {
-		sserialize::ItemIndex cellItems = cmp->indexStore().at(cmp->store().geoHierarchy().cellItemsPtr(cellId));
-		for(uint32_t itemId : cellItems) {
-			bool itemProcessed = false;
-			#pragma omp critical(processedItems)
-			{
-				itemProcessed = cstate.processedItems.isSet(itemId);
-			}
-			if (itemProcessed) {
-				continue;
-			}
-			#pragma omp critical(processedItems)
-			{
-				cstate.processedItems.set(itemId);
-			}
-			auto b = cmp->store().geoShape(itemId).boundary();
-			auto isig = itemSignature(itemId);
-			for(auto x : cmp->store().cells(itemId)) {
-				isig = cstate.combine(isig, cstate.cellSignatures.at(x));
-			}
-			#pragma omp critical(treeAccess)
-			{
-				state.itemNodes.at(itemId) = state.tree.insert(b, isig, itemId);
-			}
-			
-			#pragma omp atomic
-			++numProcItems;
-			
-			#pragma omp critical(pinfo)
-			{
-				pinfo(numProcItems);
+	srtree::ConcurrentInserter<Tree> inserter(state.tree, [this](typename Tree::ItemNode const * in) {
+		state.itemNodes.at(in->item()) = in;
+	});
+	
+	#pragma omp parallel
+	{
+		auto buffer = inserter.buffer();
+		#pragma omp for schedule(dynamic, 1)
+		for(uint32_t cellId = 0; cellId < cs; ++cellId) {
+			sserialize::ItemIndex cellItems = cmp->indexStore().at(cmp->store().geoHierarchy().cellItemsPtr(cellId));
+			for(uint32_t itemId : cellItems) {
+				bool itemProcessed = false;
+				#pragma omp critical(processedItems)
+				{
+					itemProcessed = cstate.processedItems.isSet(itemId);
+				}
+				if (itemProcessed) {
+					continue;
+				}
+				#pragma omp critical(processedItems)
+				{
+					cstate.processedItems.set(itemId);
+				}
+				auto b = cmp->store().geoShape(itemId).boundary();
+				auto isig = itemSignature(itemId);
+				for(auto x : cmp->store().cells(itemId)) {
+					isig = cstate.combine(isig, cstate.cellSignatures.at(x));
+				}
+				buffer.insert(typename Tree::ItemDescription{b, std::move(isig), itemId});
+				
+				#pragma omp atomic
+				++numProcItems;
+				
+				#pragma omp critical(pinfo)
+				{
+					pinfo(numProcItems);
+				}
 			}
-		}
-		if (check) {
-			#pragma omp critical(treeAccess)
-			if (!state.tree.checkConsistency()) {
-				throw sserialize::CreationException("Tree failed consistency check!");
+			if (check) {
+				buffer.flush();
+				bool ok = inserter.exclusive([](Tree const & tree) {
+					return tree.checkConsistency();
+				});
+				if (!ok) {
+					throw sserialize::CreationException("Tree failed consistency check!");
+				}
 			}
 		}
+		buffer.flush();
 	}
 	pinfo.end();
 	
@@ -1,26 +1,38 @@
 #pragma once
 
+#include <sserialize/utility/debuggerfunctions.h>
+#include <sserialize/strings/unicode_case_functions.h>
+
 #include <liboscar/StaticOsmCompleter.h>
+#include <liboscar/KVStats.h>
+
 #include <srtree/SRTree.h>
+#include <srtree/ConcurrentInserter.h>
 
+///@param T_SIGNATURE_TRAITS string set signature traits, i.e. StringSetTraits or RoaringStringSetTraits (possibly with the dedup adapter)
+template<typename T_SIGNATURE_TRAITS = srtree::detail::StringSetTraits>
 struct OStringSetRTree {
-	using Tree = srtree::StringSetRTree<12, 32>;
+	using Tree = srtree::SRTree<
+	T_SIGNATURE_TRAITS,
+	srtree::detail::GeoRectGeometryTraits,
+	12,
+	32>;
 	
-	using GeometryTraits = Tree::GeometryTraits;
+	using GeometryTraits = typename Tree::GeometryTraits;
 	
-	using SignatureTraits = Tree::SignatureTraits;
-	using Signature = Tree::Signature;
+	using SignatureTraits = typename Tree::SignatureTraits;
+	using Signature = typename Tree::Signature;
 	
 	struct State {
 		Tree tree;
-		std::vector<Tree::ItemNode const *> itemNodes;
+		std::vector<typename Tree::ItemNode const *> itemNodes;
 	};
 	struct CreationState {
 		///in ghId order!
 		std::vector<sserialize::ItemIndex> regionStrIds;
 		std::vector<sserialize::ItemIndex> cellStrIds;
 		sserialize::SimpleBitVector processedItems;
-		SignatureTraits::Combine combine;
+		typename SignatureTraits::Combine combine;
 	public:
 		CreationState(SignatureTraits const & straits) : combine(straits.combine()) {}
 	};
@@ -52,3 +64,320 @@ public:
 	bool check{false};
 	
 };
+
+//Implementation
+template<typename T_SIGNATURE_TRAITS>
+void
+OStringSetRTree<T_SIGNATURE_TRAITS>::create() {
+	sserialize::ProgressInfo pinfo;
+	
+	pinfo.begin(cmp->store().size(), "Gathering candidate strings");
+	for(uint32_t i(0), s(cmp->store().size()); i < s; ++i) {
+		auto item = cmp->store().kvItem(i);
+		for(uint32_t j(0), js(item.size()); j < js; ++j) {
+			std::string token = "@" + item.key(j) + ":" + item.value(j);
+			state.tree.straits().addString(normalize(token));
+		}
+		pinfo(i);
+	}
+	pinfo.end();
+
+	state.tree.straits().finalizeStringTable();
+	
+	pinfo.begin(cmp->store().geoHierarchy().regionSize(), "Computing region string ids");
+	for(uint32_t regionId(0), rs(cmp->store().geoHierarchy().regionSize()); regionId < rs; ++regionId) {
+		cstate.regionStrIds.push_back(
+			itemStrIds(
+				cmp->store().geoHierarchy().ghIdToStoreId(regionId)
+			)
+		);
+		pinfo(regionId);
+	}
+	pinfo.end();
+	
+	pinfo.begin(cmp->store().geoHierarchy().cellSize(), "Computing cell string ids");
+	for(uint32_t cellId(0), cs(cmp->store().geoHierarchy().cellSize()); cellId < cs; ++cellId) {
+		cstate.cellStrIds.push_back( cellStrIds(cellId) );
+		pinfo(cellId);
+	}
+	pinfo.end();
+	
+	state.itemNodes.resize(cmp->store().size(), 0);
+	
+	uint32_t numProcItems = 0;
+	uint32_t cellCount(cmp->store().geoHierarchy().cellSize());
+	pinfo.begin(cmp->store().size(), "Inserting items");
+	srtree::ConcurrentInserter<Tree> inserter(state.tree, [this](typename Tree::ItemNode const * in) {
+		state.itemNodes.at(in->item()) = in;
+	});
+	#pragma omp parallel
+	{
+		auto buffer = inserter.buffer();
+		#pragma omp for schedule(dynamic, 1)
+		for(uint32_t cellId = 0; cellId < cellCount; ++cellId) {
+			sserialize::ItemIndex cellItems = cmp->indexStore().at(cmp->store().geoHierarchy().cellItemsPtr(cellId));
+			for(uint32_t itemId : cellItems) {
+				bool itemProcessed = false;
+				#pragma omp critical(processedItems)
+				{
+					itemProcessed = cstate.processedItems.isSet(itemId);
+				}
+				if (itemProcessed) {
+					continue;
+				}
+				#pragma omp critical(processedItems)
+				{
+					cstate.processedItems.set(itemId);
+				}
+				auto b = cmp->store().geoShape(itemId).boundary();
+				auto iStrIds = itemStrIds(itemId);
+				for(auto x : cmp->store().cells(itemId)) {
+					iStrIds += cstate.cellStrIds.at(x);
+				}
+				auto isig = state.tree.straits().addSignature(iStrIds);
+				buffer.insert(b, isig, itemId);
+				
+				#pragma omp atomic
+				++numProcItems;
+				#pragma omp critical(pinfo)
+				{
+					pinfo(numProcItems);
+				}
+			}
+			if (check) {
+				buffer.flush();
+				bool ok = inserter.exclusive([](Tree const & tree) {
+					return tree.checkConsistency();
+				});
+				if (!ok) {
+					throw sserialize::CreationException("Tree failed consistency check!");
+				}
+			}
+		}
+		buffer.flush();
+	}
+	pinfo.end();
+	
+	if (check && !state.tree.checkConsistency()) {
+		throw sserialize::CreationException("Tree failed consistency check!");
+	}
+	
+	pinfo.begin(1, "Calculating signatures");
+	state.tree.recalculateSignatures();
+	pinfo.end();
+}
+
+// NO_OPTIMIZE
+template<typename T_SIGNATURE_TRAITS>
+void
+OStringSetRTree<T_SIGNATURE_TRAITS>::test() {
+	if (!state.tree.checkConsistency()) {
+		std::cerr << "Tree is not consistent" << std::endl;
+		return;
+	}
+	
+	//check if tree returns all elements of each cell
+	sserialize::ProgressInfo pinfo;
+	auto const & gh = cmp->store().geoHierarchy();
+	pinfo.begin(gh.cellSize(), "Testing spatial constraint");
+	for(uint32_t cellId(0), cs(gh.cellSize()); cellId < cs; ++cellId) {
+		auto cellItems = cmp->indexStore().at(gh.cellItemsPtr(cellId));
+		auto cb = gh.cellBoundary(cellId);
+		
+		std::vector<uint32_t> tmp;
+		state.tree.find(state.tree.gtraits().mayHaveMatch(cb), std::back_inserter(tmp));
+		std::sort(tmp.begin(), tmp.end());
+		sserialize::ItemIndex result(std::move(tmp));
+		
+		if ( (cellItems - result).size() ) {
+			std::cout << "Incorrect result for cell " << cellId << std::endl;
+		}
+	}
+	pinfo.end();
+	//now check the most frequent key:value pair combinations
+	std::cout << "Computing store kv stats..." << std::flush;
+	auto kvstats = liboscar::KVStats(cmp->store()).stats(sserialize::ItemIndex(sserialize::RangeGenerator<uint32_t>(0, cmp->store().size())), 0);
+	std::cout << "done" << std::endl;
+	auto topkv = kvstats.topkv(100, [](auto const & a, auto const & b) {
+		return a.valueCount < b.valueCount;
+	});
+	std::vector<std::string> kvstrings;
+	for(auto const & x : topkv) {
+		std::string str = "@";
+		str += cmp->store().keyStringTable().at(x.keyId);
+		str += ":";
+		str += cmp->store().valueStringTable().at(x.valueId);
+		kvstrings.push_back( normalize(str) );
+	}
+	
+	uint32_t failedQueries = 0;
+	
+	auto storeBoundary = cmp->store().boundary();
+	pinfo.begin(kvstrings.size(), "Testing string constraint");
+	for(std::size_t i(0), s(kvstrings.size()); i < s; ++i) {
+		std::string const & str = kvstrings[i];
+		sserialize::ItemIndex items = cmp->cqrComplete("\"" + str + "\"").flaten();
+		
+		auto smp = state.tree.straits().mayHaveMatch(matchingStrings(str, false));
+		auto gmp = state.tree.gtraits().mayHaveMatch(storeBoundary);
+		
+		std::vector<uint32_t> tmp;
+		state.tree.find(gmp, smp, std::back_inserter(tmp));
+		std::sort(tmp.begin(), tmp.end());
+		sserialize::ItemIndex result(std::move(tmp));
+		
+		if ( (items - result).size() ) {
+			std::cout << "Incorrect result for query string " << str << ": " << (items - result).size() << std::endl;
+			++failedQueries;
+			auto diff = items - result;
+			if (diff.size() < 10) {
+				for(auto itemId : diff) {
+					std::cout << "Item " << itemId << " has the following associated strings:" << std::endl;
+					auto itemStrIds = state.tree.straits().strIds( state.itemNodes.at(itemId)->payload() );
+					for(auto strId : itemStrIds) {
+						std::cout << state.tree.straits().str2Id().toStr((state.tree.straits().str2Id().begin()+strId)->first) << std::endl;
+					}
+					std::cout << std::endl;
+				}
+			}
+
+			sserialize::ItemIndex mustResult(matchingItems(gmp, smp));
+			if (result != mustResult) {
+				std::cout << "Tree does not return all valid items: "<< std::endl;
+				std::cout << "Correct result: " << mustResult.size() << std::endl;
+				std::cout << "Have result: " << result.size() << std::endl;
+				std::cout << "Missing: " << (mustResult - result).size() << std::endl;
+				std::cout << "Invalid: " << (result - mustResult).size() << std::endl;
+			}
+		}
+		pinfo(i);
+	}
+	pinfo.end();
+	
+	failedQueries = 0;
+	pinfo.begin(kvstrings.size(), "Testing string+boundary constraint");
+	for(std::size_t i(0), s(kvstrings.size()); i < s; ++i) {
+		std::string const & str = kvstrings[i];
+		
+		auto smp = state.tree.straits().mayHaveMatch(matchingStrings(str, false));
+		auto cqr = cmp->cqrComplete("\"" + str + "\"");
+		for(uint32_t i(0), s(cqr.cellCount()); i < s; ++i) {
+			std::vector<uint32_t> tmp;
+			auto gmp = state.tree.gtraits().mayHaveMatch(cmp->store().geoHierarchy().cellBoundary(cqr.cellId(i)));
+			state.tree.find(gmp, smp, std::back_inserter(tmp));
+			std::sort(tmp.begin(), tmp.end());
+			sserialize::ItemIndex result(std::move(tmp));
+			
+			if ( (cqr.items(i) - result).size() ) {
+				std::cout << "Incorrect result for query string " << str << " and cell " << cqr.cellId(i) << std::endl;
+				++failedQueries;
+				
+				sserialize::ItemIndex mustResult(matchingItems(gmp, smp));
+				if (result != mustResult) {
+					std::cout << "Tree does not return all valid items: "<< std::endl;
+					std::cout << "Correct result: " << mustResult.size() << std::endl;
+					std::cout << "Have result: " << result.size() << std::endl;
+					std::cout << "Missing: " << (mustResult - result).size() << std::endl;
+					std::cout << "Invalid: " << (result - mustResult).size() << std::endl;
+				}
+			}
+		}
+		
+		pinfo(i);
+	}
+	pinfo.end();
+	
+	if (failedQueries) {
+		std::cout << "There were " << failedQueries << " failed queries out of " << kvstrings.size() << std::endl;
+	}
+}
+
+
+template<typename T_SIGNATURE_TRAITS>
+void
+OStringSetRTree<T_SIGNATURE_TRAITS>::serialize(sserialize::UByteArrayAdapter & treeData, sserialize::UByteArrayAdapter & traitsData) {
+	state.tree.serialize(treeData);
+	traitsData << state.tree.straits() << state.tree.gtraits();
+	if (check && !equal(treeData, traitsData)) {
+		throw sserialize::CreationException("Serialized tree is not equal to in-memory structure");
+	}
+}
+
+template<typename T_SIGNATURE_TRAITS>
+bool
+OStringSetRTree<T_SIGNATURE_TRAITS>::equal(sserialize::UByteArrayAdapter treeData, sserialize::UByteArrayAdapter traitsData) {
+	using StaticTree = srtree::Static::SRTree<typename SignatureTraits::StaticTraits, typename GeometryTraits::StaticTraits>;
+	typename SignatureTraits::StaticTraits sstraits;
+	typename GeometryTraits::StaticTraits sgtraits;
+	traitsData >> sstraits >> sgtraits;
+	StaticTree stree(treeData, std::move(sstraits), std::move(sgtraits));
+	return state.tree.checkEquality(stree);
+}
+
+template<typename T_SIGNATURE_TRAITS>
+sserialize::ItemIndex
+OStringSetRTree<T_SIGNATURE_TRAITS>::cellStrIds(uint32_t cellId) {
+	auto const & gh = cmp->store().geoHierarchy();
+	auto cell = gh.cell(cellId);
+	std::vector<sserialize::ItemIndex> tmp;
+	for(uint32_t i(0), s(cell.parentsSize()); i < s; ++i) {
+		tmp.push_back(
+			cstate.regionStrIds.at( cell.parent(i) )
+		);
+	}
+	return sserialize::ItemIndex::unite(tmp);
+}
+
+template<typename T_SIGNATURE_TRAITS>
+sserialize::ItemIndex
+OStringSetRTree<T_SIGNATURE_TRAITS>::itemStrIds(uint32_t itemId) {
+	auto item = cmp->store().kvItem(itemId);
+	std::vector<uint32_t> tmp;
+	for(uint32_t i(0), s(item.size()); i < s; ++i) {
+		std::string token("@" + item.key(i) + ":" + item.value(i));
+		tmp.push_back( state.tree.straits().strId( normalize(token) ) );
+	}
+	std::sort(tmp.begin(), tmp.end());
+	//items may have key/value paris multiple times
+	tmp.resize( std::unique(tmp.begin(), tmp.end()) - tmp.begin());
+	return sserialize::ItemIndex(std::move(tmp));
+}
+
+template<typename T_SIGNATURE_TRAITS>
+sserialize::ItemIndex
+OStringSetRTree<T_SIGNATURE_TRAITS>::matchingStrings(std::string const & str, bool prefixMatch) {
+	if (!prefixMatch) {
+		return sserialize::ItemIndex( std::vector<uint32_t>(1, state.tree.straits().strId(str)) );
+	}
+	
+	std::vector<uint32_t> tmp;
+	auto node = state.tree.straits().str2Id().findNode(str.begin(), str.end(), true);
+	for(auto it(node->rawBegin()), end(node->rawEnd()); it != end; ++it) {
+		if (it->second.leaf()) {
+			tmp.push_back(it->second.value);
+		}
+	}
+	return sserialize::ItemIndex(std::move(tmp));
+}
+
+template<typename T_SIGNATURE_TRAITS>
+sserialize::ItemIndex
+OStringSetRTree<T_SIGNATURE_TRAITS>::matchingItems(typename Tree::GeometryMatchPredicate & gmp, typename Tree::SignatureMatchPredicate & smp) {
+	std::vector<uint32_t> validItems;
+	//check all items directly
+	for(uint32_t i(cmp->store().geoHierarchy().regionSize()), s(cmp->store().size()); i < s; ++i) {
+		auto x = state.itemNodes.at(i);
+		SSERIALIZE_CHEAP_ASSERT(x);
+		if (gmp(x->boundary()) && smp( x->payload() ) ) {
+			validItems.push_back(x->item());
+		}
+		SSERIALIZE_CHEAP_ASSERT_EQUAL(i, x->item());
+	}
+	return sserialize::ItemIndex(std::move(validItems));
+}
+
+template<typename T_SIGNATURE_TRAITS>
+std::string
+OStringSetRTree<T_SIGNATURE_TRAITS>::normalize(std::string const & str) {
+	return sserialize::unicode_to_lower(str);
+}
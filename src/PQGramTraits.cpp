@@ -7,4 +7,9 @@ PQGramTraits::add(const std::string & str) {
 	db().insert(str);
 }
 
+void
+PQGramTraits::add(std::vector<std::string> const & strs) {
+	db().insert(strs);
+}
+
 }//end namespace
@@ -108,4 +108,57 @@ QGram::intersectionSize(QGram const & first, QGram const & second) {
 	return result;
 }
 
+QGramFingerprints::const_iterator::const_iterator(QGramFingerprints const * d, std::size_t pos) :
+m_d(d),
+m_pos(pos)
+{
+	if (pos == 0 && d->m_size) {
+		m_h = d->c(0);
+		m_len = 1;
+	}
+}
+
+QGramFingerprints::QGramFingerprints(std::string const & base, std::size_t q) :
+QGramFingerprints(base.data(), base.size(), q)
+{}
+
+QGramFingerprints::QGramFingerprints(char const * begin, std::size_t size, std::size_t q) :
+m_base(begin),
+m_size(size),
+m_q(q)
+{
+	if (q < 1) {
+		throw sserialize::InvalidAlgorithmStateException("q < 1");
+	}
+	if (q > MaxQ) {
+		throw sserialize::InvalidAlgorithmStateException("q > QGramFingerprints::MaxQ");
+	}
+	m_pow[0] = 1;
+	for(std::size_t i(1); i <= q; ++i) {
+		m_pow[i] = mul(m_pow[i-1], Base);
+	}
+}
+
+QGramFingerprints::~QGramFingerprints()
+{}
+
+QGramFingerprints::const_iterator
+QGramFingerprints::begin() const {
+	return const_iterator(this, 0);
+}
+
+QGramFingerprints::const_iterator
+QGramFingerprints::end() const {
+	return const_iterator(this, size());
+}
+
+QGramFingerprints::value_type
+QGramFingerprints::fingerprint(std::string const & str) {
+	value_type h = 1;
+	for(char x : str) {
+		h = add(mul(h, Base), value_type(uint8_t(x)) + 1);
+	}
+	return h;
+}
+
 }
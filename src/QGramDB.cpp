@@ -1,6 +1,8 @@
 #include <srtree/QGramDB.h>
 
 #include <algorithm>
+#include <string_view>
+#include <stdexcept>
 
 #include <sserialize/utility/assert.h>
 #include <sserialize/utility/exceptions.h>
@@ -159,8 +161,244 @@ sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest,
 	return dest;
 }
 
+void
+QGramMap::Batch::add(char const * gram, std::size_t len) {
+	//Most grams are already known, checking that in parallel keeps the sequential part small
+	uint64_t key;
+	if (pack(gram, len, key)) {
+		uint64_t h = hash(key);
+		if (!m_map->m_s[shard(h)].packed.find(key, h) && m_seen.insert(key, h, 0).second) {
+			m_packed[shard(h)].push_back(key);
+		}
+	}
+	else {
+		std::size_t s = shard(hash(gram, len));
+		std::string str(gram, len);
+		if (!m_map->m_s[s].other.count(str)) {
+			m_other[s].emplace_back(std::move(str));
+		}
+	}
+}
+
+std::size_t
+QGramMap::count(std::string const & gram) const {
+	uint64_t key;
+	if (pack(gram.data(), gram.size(), key)) {
+		uint64_t h = hash(key);
+		return m_s[shard(h)].packed.find(key, h) ? 1 : 0;
+	}
+	return m_s[shard(hash(gram.data(), gram.size()))].other.count(gram);
+}
+
+uint32_t const &
+QGramMap::at(std::string const & gram) const {
+	uint64_t key;
+	if (pack(gram.data(), gram.size(), key)) {
+		uint64_t h = hash(key);
+		uint32_t const * v = m_s[shard(h)].packed.find(key, h);
+		if (!v) {
+			throw std::out_of_range("QGramMap::at: q-gram not found");
+		}
+		return *v;
+	}
+	return m_s[shard(hash(gram.data(), gram.size()))].other.at(gram);
+}
+
+std::vector<QGramMap::value_type>
+QGramMap::toVector() const {
+	std::vector<value_type> result;
+	result.reserve(size());
+	for(Shard const & s : m_s) {
+		s.packed.forEach([&result](uint64_t key, uint32_t value) {
+			result.emplace_back(unpack(key), value);
+		});
+		result.insert(result.end(), s.other.begin(), s.other.end());
+	}
+	return result;
+}
+
+uint32_t
+QGramMap::insert(char const * gram, std::size_t len) {
+	uint64_t key;
+	if (pack(gram, len, key)) {
+		uint64_t h = hash(key);
+		auto x = m_s[shard(h)].packed.insert(key, h, m_size);
+		m_size += x.second;
+		return *x.first;
+	}
+	auto x = m_s[shard(hash(gram, len))].other.emplace(std::string(gram, len), m_size);
+	m_size += x.second;
+	return x.first->second;
+}
+
+void
+QGramMap::insert(std::vector<Batch> const & batches) {
+	//Every shard numbers its new grams starting at 0, the final ids are offset by the new grams of the preceding shards
+	std::array<std::vector<uint64_t>, ShardCount> newPacked;
+	std::array<std::vector<uint32_t*>, ShardCount> newOther;
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(std::size_t i = 0; i < ShardCount; ++i) {
+		Shard & s = m_s[i];
+		uint32_t next = 0;
+		for(Batch const & b : batches) {
+			for(uint64_t key : b.m_packed[i]) {
+				if (s.packed.insert(key, hash(key), next).second) {
+					newPacked[i].push_back(key);
+					++next;
+				}
+			}
+			for(std::string const & gram : b.m_other[i]) {
+				auto x = s.other.emplace(gram, next);
+				if (x.second) {
+					//nodes of an unordered_map are not moved on rehash
+					newOther[i].push_back(&(x.first->second));
+					++next;
+				}
+			}
+		}
+	}
+	std::array<std::size_t, ShardCount> offsets;
+	for(std::size_t i(0); i < ShardCount; ++i) {
+		offsets[i] = m_size;
+		m_size += newPacked[i].size() + newOther[i].size();
+	}
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(std::size_t i = 0; i < ShardCount; ++i) {
+		for(uint64_t key : newPacked[i]) {
+			*m_s[i].packed.find(key, hash(key)) += offsets[i];
+		}
+		for(uint32_t * v : newOther[i]) {
+			*v += offsets[i];
+		}
+	}
+}
+
+bool
+QGramMap::pack(char const * gram, std::size_t len, uint64_t & key) {
+	if (!len || len > sizeof(uint64_t)) {
+		return false;
+	}
+	key = 0;
+	for(std::size_t i(0); i < len; ++i) {
+		uint8_t c = gram[i];
+		if (!c) {
+			return false;
+		}
+		key |= uint64_t(c) << (8*i);
+	}
+	return true;
+}
+
+std::string
+QGramMap::unpack(uint64_t key) {
+	std::string result;
+	for(; key; key >>= 8) {
+		result.push_back(char(key & 0xFF));
+	}
+	return result;
+}
+
+uint64_t
+QGramMap::hash(uint64_t key) {
+	//finalizer of MurmurHash3
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+uint64_t
+QGramMap::hash(char const * gram, std::size_t len) {
+	return hash(uint64_t(std::hash<std::string_view>()(std::string_view(gram, len))));
+}
+
+std::size_t
+QGramMap::shard(uint64_t hash) {
+	static_assert(ShardCount == 64);
+	return hash >> 58;
+}
+
+uint32_t const *
+QGramMap::Table::find(uint64_t key, uint64_t hash) const {
+	if (m_keys.empty()) {
+		return nullptr;
+	}
+	std::size_t mask = m_keys.size()-1;
+	for(std::size_t i(hash & mask);; i = (i+1) & mask) {
+		if (m_keys[i] == key) {
+			return &m_values[i];
+		}
+		else if (m_keys[i] == Empty) {
+			return nullptr;
+		}
+	}
+}
+
+uint32_t *
+QGramMap::Table::find(uint64_t key, uint64_t hash) {
+	return const_cast<uint32_t*>(static_cast<Table const *>(this)->find(key, hash));
+}
+
+std::pair<uint32_t*, bool>
+QGramMap::Table::insert(uint64_t key, uint64_t hash, uint32_t value) {
+	SSERIALIZE_CHEAP_ASSERT_NOT_EQUAL(key, Empty);
+	//keep the load factor below 3/4
+	if (4*(m_size+1) > 3*m_keys.size()) {
+		grow();
+	}
+	std::size_t mask = m_keys.size()-1;
+	std::size_t i(hash & mask);
+	for(; m_keys[i] != Empty; i = (i+1) & mask) {
+		if (m_keys[i] == key) {
+			return std::pair<uint32_t*, bool>(&m_values[i], false);
+		}
+	}
+	m_keys[i] = key;
+	m_values[i] = value;
+	++m_size;
+	return std::pair<uint32_t*, bool>(&m_values[i], true);
+}
+
+void
+QGramMap::Table::grow() {
+	std::vector<uint64_t> keys(std::max<std::size_t>(16, 2*m_keys.size()), Empty);
+	std::vector<uint32_t> values(keys.size());
+	std::size_t mask = keys.size()-1;
+	for(std::size_t j(0), s(m_keys.size()); j < s; ++j) {
+		if (m_keys[j] == Empty) {
+			continue;
+		}
+		std::size_t i(QGramMap::hash(m_keys[j]) & mask);
+		for(; keys[i] != Empty; i = (i+1) & mask) {}
+		keys[i] = m_keys[j];
+		values[i] = m_values[j];
+	}
+	m_keys = std::move(keys);
+	m_values = std::move(values);
+}
+
 }//end namespace detail::PQGramDB
-	
+
+namespace {
+
+///Calls @param f(gram, length) for the q-grams of @param str in the order of QGram(str, q).at(i) without materializing them
+template<typename T_FUNC>
+void forEachQGram(std::string const & str, std::size_t q, T_FUNC f) {
+	std::size_t n = str.size();
+	for(std::size_t i(0), s(n+q-1); i < s; ++i) {
+		if (i+1 < q) {
+			f(str.data(), std::min(i+1, n));
+		}
+		else {
+			std::size_t begin = i-(q-1);
+			f(str.data()+begin, std::min(q, n-begin));
+		}
+	}
+}
+
+} //end namespace
 	
 PQGramDB::PQGramDB(uint32_t q) :
 Parent(q)
@@ -171,17 +409,29 @@ PQGramDB::~PQGramDB()
 
 void
 PQGramDB::insert(std::string const & str) {
-	QGram qg(str, q());
-	for(std::size_t i(0), s(qg.size()); i < s; ++i) {
-		auto & x = data()[qg.at(i)];
-		if (!x) {
-			x = data().size()-1;
+	forEachQGram(str, q(), [this](char const * gram, std::size_t len) {
+		data().insert(gram, len);
+	});
+}
+
+void
+PQGramDB::insert(std::vector<std::string> const & strs) {
+	constexpr std::size_t BatchSize = 1 << 14;
+	std::vector<detail::PQGramDB::QGramMap::Batch> batches((strs.size()+BatchSize-1)/BatchSize, detail::PQGramDB::QGramMap::Batch(data()));
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(std::size_t b = 0; b < batches.size(); ++b) {
+		auto & batch = batches[b];
+		for(std::size_t i(b*BatchSize), s(std::min(strs.size(), (b+1)*BatchSize)); i < s; ++i) {
+			forEachQGram(strs[i], q(), [&batch](char const * gram, std::size_t len) {
+				batch.add(gram, len);
+			});
 		}
 	}
+	data().insert(batches);
 }
 
 sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, PQGramDB const & v) {
-	std::vector<std::pair<std::string, uint32_t>> tmp(v.data().begin(), v.data().end());
+	std::vector<std::pair<std::string, uint32_t>> tmp = v.data().toVector();
 	using std::sort;
 	sort(tmp.begin(), tmp.end());
 	return dest << PQGramDB::QType(v.q()) << tmp;
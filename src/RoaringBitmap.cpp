@@ -0,0 +1,618 @@
+#include <srtree/RoaringBitmap.h>
+
+#include <sserialize/utility/exceptions.h>
+
+#include <algorithm>
+#include <iterator>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace srtree {
+namespace {
+
+constexpr uint32_t BitmapBytes = RoaringBitmap::BitmapWords*sizeof(uint64_t);
+
+///Number of bytes of the values of an array container with @param cardinality values
+inline uint32_t arrayBytes(uint32_t cardinality) {
+	return cardinality*sizeof(uint16_t);
+}
+
+inline uint32_t runBytes(uint32_t runCount) {
+	return sizeof(uint32_t) + runCount*2*sizeof(uint16_t);
+}
+
+#if defined(__AVX2__)
+///True if one of the 8 values of @param va is one of the 8 values of @param vb
+///All rotations of vb are compared with va
+inline bool blocksIntersect(__m128i va, __m128i vb) {
+	__m128i cmp = _mm_cmpeq_epi16(va, vb);
+	cmp = _mm_or_si128(cmp, _mm_cmpeq_epi16(va, _mm_alignr_epi8(vb, vb, 2)));
+	cmp = _mm_or_si128(cmp, _mm_cmpeq_epi16(va, _mm_alignr_epi8(vb, vb, 4)));
+	cmp = _mm_or_si128(cmp, _mm_cmpeq_epi16(va, _mm_alignr_epi8(vb, vb, 6)));
+	cmp = _mm_or_si128(cmp, _mm_cmpeq_epi16(va, _mm_alignr_epi8(vb, vb, 8)));
+	cmp = _mm_or_si128(cmp, _mm_cmpeq_epi16(va, _mm_alignr_epi8(vb, vb, 10)));
+	cmp = _mm_or_si128(cmp, _mm_cmpeq_epi16(va, _mm_alignr_epi8(vb, vb, 12)));
+	cmp = _mm_or_si128(cmp, _mm_cmpeq_epi16(va, _mm_alignr_epi8(vb, vb, 14)));
+	return !_mm_testz_si128(cmp, cmp);
+}
+#endif
+
+///True if the sorted arrays @param a and @param b have a common value
+bool arraysIntersect(uint16_t const * a, std::size_t n, uint16_t const * b, std::size_t m) {
+	//Search the values of a very small array in the other one, e.g. the few string ids of a query
+	if (n*32 < m || m*32 < n) {
+		if (m < n) {
+			std::swap(a, b);
+			std::swap(n, m);
+		}
+		uint16_t const * it = b;
+		uint16_t const * end = b+m;
+		for(std::size_t i(0); i < n && it != end; ++i) {
+			it = std::lower_bound(it, end, a[i]);
+			if (it != end && *it == a[i]) {
+				return true;
+			}
+		}
+		return false;
+	}
+	std::size_t i = 0;
+	std::size_t j = 0;
+#if defined(__AVX2__)
+	//A block can only have common values with blocks of the other array that do not end before it
+	while (i+8 <= n && j+8 <= m) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a+i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b+j));
+		if (blocksIntersect(va, vb)) {
+			return true;
+		}
+		uint16_t amax = a[i+7];
+		uint16_t bmax = b[j+7];
+		i += 8*(amax <= bmax);
+		j += 8*(bmax <= amax);
+	}
+#endif
+	while (i < n && j < m) {
+		if (a[i] < b[j]) {
+			++i;
+		}
+		else if (b[j] < a[i]) {
+			++j;
+		}
+		else {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool wordsIntersect(uint64_t const * a, uint64_t const * b) {
+	std::size_t i = 0;
+#if defined(__AVX2__)
+	for(; i < RoaringBitmap::BitmapWords; i += 4) {
+		__m256i va = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a+i));
+		__m256i vb = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b+i));
+		if (!_mm256_testz_si256(va, vb)) {
+			return true;
+		}
+	}
+#endif
+	for(; i < RoaringBitmap::BitmapWords; ++i) {
+		if (a[i] & b[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+inline bool testBit(uint64_t const * words, uint32_t v) {
+	return (words[v/64] >> (v%64)) & 1;
+}
+
+///True if one of the bits in [first, last] is set
+bool anyBit(uint64_t const * words, uint32_t first, uint32_t last) {
+	uint32_t fw = first/64;
+	uint32_t lw = last/64;
+	uint64_t fmask = ~uint64_t(0) << (first%64);
+	uint64_t lmask = ~uint64_t(0) >> (63-last%64);
+	if (fw == lw) {
+		return words[fw] & fmask & lmask;
+	}
+	if (words[fw] & fmask) {
+		return true;
+	}
+	for(uint32_t i(fw+1); i < lw; ++i) {
+		if (words[i]) {
+			return true;
+		}
+	}
+	return words[lw] & lmask;
+}
+
+void setBits(uint64_t * words, uint32_t first, uint32_t last) {
+	uint32_t fw = first/64;
+	uint32_t lw = last/64;
+	uint64_t fmask = ~uint64_t(0) << (first%64);
+	uint64_t lmask = ~uint64_t(0) >> (63-last%64);
+	if (fw == lw) {
+		words[fw] |= fmask & lmask;
+		return;
+	}
+	words[fw] |= fmask;
+	for(uint32_t i(fw+1); i < lw; ++i) {
+		words[i] = ~uint64_t(0);
+	}
+	words[lw] |= lmask;
+}
+
+///Number of maximal runs of set bits
+uint32_t runCount(std::vector<uint64_t> const & words) {
+	uint32_t result = 0;
+	uint64_t carry = 0;
+	for(uint64_t w : words) {
+		result += __builtin_popcountll(w & ~((w << 1) | carry));
+		carry = w >> 63;
+	}
+	return result;
+}
+
+uint32_t runCount(std::vector<uint16_t> const & sorted) {
+	uint32_t result = 0;
+	for(std::size_t i(0); i < sorted.size(); ++i) {
+		result += (i == 0 || uint32_t(sorted[i-1])+1 != sorted[i]);
+	}
+	return result;
+}
+
+} //end namespace
+
+RoaringBitmap::RoaringBitmap(sserialize::UByteArrayAdapter d) {
+	uint32_t count;
+	d >> count;
+	m_c.resize(count);
+	for(Container & c : m_c) {
+		uint8_t type;
+		d >> c.key >> type >> c.cardinality;
+		c.type = ContainerType(type);
+		switch (c.type) {
+		case ContainerType::ARRAY:
+			c.values.resize(c.cardinality);
+			break;
+		case ContainerType::BITMAP:
+			c.words.resize(BitmapWords);
+			break;
+		case ContainerType::RUN:
+		{
+			uint32_t runs;
+			d >> runs;
+			c.values.resize(2*runs);
+		}
+			break;
+		default:
+			throw sserialize::TypeMissMatchException("RoaringBitmap: invalid container type " + std::to_string(type));
+		}
+		for(uint16_t & x : c.values) {
+			d >> x;
+		}
+		for(uint64_t & x : c.words) {
+			d >> x;
+		}
+	}
+}
+
+RoaringBitmap::RoaringBitmap(std::vector<value_type> ids) {
+	std::sort(ids.begin(), ids.end());
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+	std::vector<uint16_t> low;
+	for(std::size_t i(0); i < ids.size();) {
+		uint16_t key = ids[i] >> 16;
+		low.clear();
+		for(; i < ids.size() && (ids[i] >> 16) == key; ++i) {
+			low.push_back(uint16_t(ids[i]));
+		}
+		m_c.push_back(makeContainer(key, low));
+	}
+}
+
+RoaringBitmap::size_type
+RoaringBitmap::size() const {
+	size_type result = 0;
+	for(Container const & c : m_c) {
+		result += c.cardinality;
+	}
+	return result;
+}
+
+bool
+RoaringBitmap::contains(value_type id) const {
+	uint16_t key = id >> 16;
+	auto it = std::lower_bound(m_c.begin(), m_c.end(), key, [](Container const & c, uint16_t k) { return c.key < k; });
+	return it != m_c.end() && it->key == key && contains(*it, uint16_t(id));
+}
+
+bool
+RoaringBitmap::intersects(RoaringBitmap const & other) const {
+	auto it = m_c.begin();
+	auto jt = other.m_c.begin();
+	while (it != m_c.end() && jt != other.m_c.end()) {
+		if (it->key < jt->key) {
+			++it;
+		}
+		else if (jt->key < it->key) {
+			++jt;
+		}
+		else {
+			if (intersects(*it, *jt)) {
+				return true;
+			}
+			++it;
+			++jt;
+		}
+	}
+	return false;
+}
+
+std::vector<RoaringBitmap::value_type>
+RoaringBitmap::toVector() const {
+	std::vector<value_type> result;
+	result.reserve(size());
+	for(Container const & c : m_c) {
+		for(uint16_t v : toValues(c)) {
+			result.push_back((value_type(c.key) << 16) | v);
+		}
+	}
+	return result;
+}
+
+sserialize::UByteArrayAdapter::SizeType
+RoaringBitmap::getSizeInBytes() const {
+	sserialize::UByteArrayAdapter::SizeType result = sizeof(uint32_t);
+	for(Container const & c : m_c) {
+		result += sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint32_t);
+		switch (c.type) {
+		case ContainerType::ARRAY:
+			result += arrayBytes(c.cardinality);
+			break;
+		case ContainerType::BITMAP:
+			result += BitmapBytes;
+			break;
+		case ContainerType::RUN:
+			result += runBytes(c.values.size()/2);
+			break;
+		}
+	}
+	return result;
+}
+
+RoaringBitmap
+RoaringBitmap::operator+(RoaringBitmap const & other) const {
+	RoaringBitmap result;
+	result.m_c.reserve(m_c.size() + other.m_c.size());
+	auto it = m_c.begin();
+	auto jt = other.m_c.begin();
+	while (it != m_c.end() && jt != other.m_c.end()) {
+		if (it->key < jt->key) {
+			result.m_c.push_back(*it);
+			++it;
+		}
+		else if (jt->key < it->key) {
+			result.m_c.push_back(*jt);
+			++jt;
+		}
+		else {
+			result.m_c.push_back(unite(*it, *jt));
+			++it;
+			++jt;
+		}
+	}
+	result.m_c.insert(result.m_c.end(), it, m_c.end());
+	result.m_c.insert(result.m_c.end(), jt, other.m_c.end());
+	return result;
+}
+
+RoaringBitmap &
+RoaringBitmap::operator+=(RoaringBitmap const & other) {
+	if (m_c.empty()) {
+		m_c = other.m_c;
+	}
+	else if (!other.m_c.empty()) {
+		*this = *this + other;
+	}
+	return *this;
+}
+
+bool
+RoaringBitmap::operator==(RoaringBitmap const & other) const {
+	return m_c == other.m_c;
+}
+
+bool
+RoaringBitmap::Container::operator==(Container const & other) const {
+	return key == other.key && type == other.type && cardinality == other.cardinality && values == other.values && words == other.words;
+}
+
+RoaringBitmap::Container
+RoaringBitmap::makeContainer(uint16_t key, std::vector<uint16_t> const & sorted) {
+	Container c;
+	c.key = key;
+	c.cardinality = sorted.size();
+	if (sorted.size() <= ArrayMaxSize) {
+		c.type = ContainerType::ARRAY;
+		c.values = sorted;
+	}
+	else {
+		c.type = ContainerType::BITMAP;
+		c.words.assign(BitmapWords, 0);
+		for(uint16_t v : sorted) {
+			c.words[v/64] |= uint64_t(1) << (v%64);
+		}
+	}
+	optimize(c);
+	return c;
+}
+
+RoaringBitmap::Container
+RoaringBitmap::makeContainer(uint16_t key, std::vector<uint64_t> && words) {
+	Container c;
+	c.key = key;
+	c.type = ContainerType::BITMAP;
+	for(uint64_t w : words) {
+		c.cardinality += __builtin_popcountll(w);
+	}
+	c.words = std::move(words);
+	optimize(c);
+	return c;
+}
+
+void
+RoaringBitmap::optimize(Container & c) {
+	//The representation only depends on the values, hence equal sets have equal containers
+	uint32_t runs = c.type == ContainerType::RUN ? c.values.size()/2 : (c.type == ContainerType::BITMAP ? runCount(c.words) : runCount(c.values));
+	ContainerType best = c.cardinality <= ArrayMaxSize ? ContainerType::ARRAY : ContainerType::BITMAP;
+	uint32_t bestBytes = best == ContainerType::ARRAY ? arrayBytes(c.cardinality) : BitmapBytes;
+	if (runBytes(runs) < bestBytes) {
+		best = ContainerType::RUN;
+	}
+	if (best == c.type) {
+		return;
+	}
+	switch (best) {
+	case ContainerType::ARRAY:
+		c.values = toValues(c);
+		c.words.clear();
+		break;
+	case ContainerType::BITMAP:
+		c.words = toWords(c);
+		c.values.clear();
+		break;
+	case ContainerType::RUN:
+	{
+		std::vector<uint16_t> values = toValues(c);
+		c.values.clear();
+		c.values.reserve(2*runs);
+		for(std::size_t i(0); i < values.size();) {
+			std::size_t j = i+1;
+			for(; j < values.size() && uint32_t(values[j-1])+1 == values[j]; ++j) {}
+			c.values.push_back(values[i]);
+			c.values.push_back(uint16_t(j-i-1));
+			i = j;
+		}
+		c.words.clear();
+	}
+		break;
+	}
+	c.type = best;
+}
+
+std::vector<uint64_t>
+RoaringBitmap::toWords(Container const & c) {
+	switch (c.type) {
+	case ContainerType::BITMAP:
+		return c.words;
+	case ContainerType::ARRAY:
+	{
+		std::vector<uint64_t> result(BitmapWords, 0);
+		for(uint16_t v : c.values) {
+			result[v/64] |= uint64_t(1) << (v%64);
+		}
+		return result;
+	}
+	case ContainerType::RUN:
+	default:
+	{
+		std::vector<uint64_t> result(BitmapWords, 0);
+		for(std::size_t i(0); i < c.values.size(); i += 2) {
+			setBits(result.data(), c.values[i], uint32_t(c.values[i]) + c.values[i+1]);
+		}
+		return result;
+	}
+	}
+}
+
+std::vector<uint16_t>
+RoaringBitmap::toValues(Container const & c) {
+	switch (c.type) {
+	case ContainerType::ARRAY:
+		return c.values;
+	case ContainerType::BITMAP:
+	{
+		std::vector<uint16_t> result;
+		result.reserve(c.cardinality);
+		for(uint32_t i(0); i < BitmapWords; ++i) {
+			for(uint64_t w = c.words[i]; w; w &= w-1) {
+				result.push_back(uint16_t(i*64 + __builtin_ctzll(w)));
+			}
+		}
+		return result;
+	}
+	case ContainerType::RUN:
+	default:
+	{
+		std::vector<uint16_t> result;
+		result.reserve(c.cardinality);
+		for(std::size_t i(0); i < c.values.size(); i += 2) {
+			for(uint32_t v(c.values[i]), e(uint32_t(c.values[i]) + c.values[i+1]); v <= e; ++v) {
+				result.push_back(uint16_t(v));
+			}
+		}
+		return result;
+	}
+	}
+}
+
+RoaringBitmap::Container
+RoaringBitmap::unite(Container const & a, Container const & b) {
+	if (a.cardinality + b.cardinality <= ArrayMaxSize) {
+		std::vector<uint16_t> av = toValues(a);
+		std::vector<uint16_t> bv = toValues(b);
+		std::vector<uint16_t> result;
+		result.reserve(av.size() + bv.size());
+		std::set_union(av.begin(), av.end(), bv.begin(), bv.end(), std::back_inserter(result));
+		return makeContainer(a.key, result);
+	}
+	std::vector<uint64_t> words = toWords(a);
+	if (b.type == ContainerType::BITMAP) {
+		for(uint32_t i(0); i < BitmapWords; ++i) {
+			words[i] |= b.words[i];
+		}
+	}
+	else if (b.type == ContainerType::ARRAY) {
+		for(uint16_t v : b.values) {
+			words[v/64] |= uint64_t(1) << (v%64);
+		}
+	}
+	else {
+		for(std::size_t i(0); i < b.values.size(); i += 2) {
+			setBits(words.data(), b.values[i], uint32_t(b.values[i]) + b.values[i+1]);
+		}
+	}
+	return makeContainer(a.key, std::move(words));
+}
+
+bool
+RoaringBitmap::intersects(Container const & a, Container const & b) {
+	if (b.type < a.type) {
+		return intersects(b, a);
+	}
+	switch (a.type) {
+	case ContainerType::ARRAY:
+		if (b.type == ContainerType::ARRAY) {
+			return arraysIntersect(a.values.data(), a.values.size(), b.values.data(), b.values.size());
+		}
+		else if (b.type == ContainerType::BITMAP) {
+			for(uint16_t v : a.values) {
+				if (testBit(b.words.data(), v)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		else {
+			std::size_t i = 0;
+			std::size_t j = 0;
+			while (i < a.values.size() && j < b.values.size()) {
+				uint32_t v = a.values[i];
+				uint32_t first = b.values[j];
+				if (v < first) {
+					++i;
+				}
+				else if (v > first + b.values[j+1]) {
+					j += 2;
+				}
+				else {
+					return true;
+				}
+			}
+			return false;
+		}
+	case ContainerType::BITMAP:
+		if (b.type == ContainerType::BITMAP) {
+			return wordsIntersect(a.words.data(), b.words.data());
+		}
+		for(std::size_t j(0); j < b.values.size(); j += 2) {
+			if (anyBit(a.words.data(), b.values[j], uint32_t(b.values[j]) + b.values[j+1])) {
+				return true;
+			}
+		}
+		return false;
+	case ContainerType::RUN:
+	default:
+	{
+		std::size_t i = 0;
+		std::size_t j = 0;
+		while (i < a.values.size() && j < b.values.size()) {
+			uint32_t aLast = uint32_t(a.values[i]) + a.values[i+1];
+			uint32_t bLast = uint32_t(b.values[j]) + b.values[j+1];
+			if (std::max(a.values[i], b.values[j]) <= std::min(aLast, bLast)) {
+				return true;
+			}
+			if (aLast < bLast) {
+				i += 2;
+			}
+			else {
+				j += 2;
+			}
+		}
+		return false;
+	}
+	}
+}
+
+bool
+RoaringBitmap::contains(Container const & c, uint16_t v) {
+	switch (c.type) {
+	case ContainerType::ARRAY:
+		return std::binary_search(c.values.begin(), c.values.end(), v);
+	case ContainerType::BITMAP:
+		return testBit(c.words.data(), v);
+	case ContainerType::RUN:
+	default:
+	{
+		//last run starting at or before v
+		std::size_t lo = 0;
+		std::size_t hi = c.values.size()/2;
+		while (lo < hi) {
+			std::size_t mid = (lo+hi)/2;
+			if (c.values[2*mid] <= v) {
+				lo = mid+1;
+			}
+			else {
+				hi = mid;
+			}
+		}
+		return lo > 0 && uint32_t(v) <= uint32_t(c.values[2*(lo-1)]) + c.values[2*(lo-1)+1];
+	}
+	}
+}
+
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, RoaringBitmap const & v) {
+	dest << uint32_t(v.m_c.size());
+	for(RoaringBitmap::Container const & c : v.m_c) {
+		dest << c.key << uint8_t(c.type) << c.cardinality;
+		if (c.type == RoaringBitmap::ContainerType::RUN) {
+			dest << uint32_t(c.values.size()/2);
+		}
+		for(uint16_t x : c.values) {
+			dest << x;
+		}
+		for(uint64_t x : c.words) {
+			dest << x;
+		}
+	}
+	return dest;
+}
+
+std::ostream & operator<<(std::ostream & out, RoaringBitmap const & v) {
+	out << "RoaringBitmap(";
+	auto ids = v.toVector();
+	for(std::size_t i(0); i < ids.size(); ++i) {
+		if (i) {
+			out << ", ";
+		}
+		out << ids[i];
+	}
+	return out << ')';
+}
+
+}//end namespace srtree
@@ -0,0 +1,94 @@
+#include <srtree/RoaringStringSetTraits.h>
+
+namespace srtree::detail {
+
+RoaringStringSetTraits::RoaringStringSetTraits() :
+m_d(std::make_shared<Data>())
+{}
+
+RoaringStringSetTraits::~RoaringStringSetTraits() {}
+
+void
+RoaringStringSetTraits::addString(std::string const & str) {
+	str2Id().insert(str);
+}
+
+void
+RoaringStringSetTraits::finalizeStringTable() {
+	//mark all strings as leafs
+	for(auto it(str2Id().begin()), end(str2Id().end()); it != end; ++it) {
+		it->second.value = StringId::GenericLeaf;
+	}
+
+	//this will add internal nodes
+	str2Id().finalize();
+
+	//mark all newly created nodes as internal, the other nodes get increasing ids
+	{
+		uint32_t i{0};
+		for(auto it(str2Id().begin()), end(str2Id().end()); it != end; ++it, ++i) {
+			if (!it->second.valid()) {
+				it->second.value = StringId::Internal;
+			}
+			else {
+				it->second.value = i;
+			}
+		}
+	}
+}
+
+uint32_t
+RoaringStringSetTraits::strId(std::string const & str) const {
+	return str2Id().at(str).value;
+}
+
+RoaringStringSetTraits::Signature
+RoaringStringSetTraits::addSignature(sserialize::ItemIndex const & strIdSet) const {
+	std::vector<uint32_t> tmp;
+	tmp.reserve(strIdSet.size());
+	for(uint32_t x : strIdSet) {
+		tmp.push_back(x);
+	}
+	return Signature(std::move(tmp));
+}
+
+sserialize::ItemIndex
+RoaringStringSetTraits::strIds(Signature const & sig) const {
+	return sserialize::ItemIndex(sig.toVector());
+}
+
+RoaringStringSetTraits::MayHaveMatch::~MayHaveMatch() {}
+
+bool
+RoaringStringSetTraits::MayHaveMatch::operator()(Signature const & ns) const {
+	return m_p([&ns](Signature const & ref) -> bool { return ref.intersects(ns); });
+}
+
+RoaringStringSetTraits::MayHaveMatch
+RoaringStringSetTraits::MayHaveMatch::operator/(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p / other.m_p);
+}
+
+RoaringStringSetTraits::MayHaveMatch
+RoaringStringSetTraits::MayHaveMatch::operator+(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p + other.m_p);
+}
+
+RoaringStringSetTraits::MayHaveMatch::MayHaveMatch(Signature const & reference) :
+m_p(reference)
+{}
+
+RoaringStringSetTraits::MayHaveMatch::MayHaveMatch(Program && p) :
+m_p(std::move(p))
+{}
+
+sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, RoaringStringSetTraits & traits) {
+	dest << sserialize::Static::SimpleVersion<1>(); //version;
+	traits.str2Id().append(dest, [](RoaringStringSetTraits::String2IdMap::NodePtr const & n) -> uint32_t {
+		return n->value().value;
+	},
+	1);
+	return dest;
+}
+
+}//end namespace srtree::detail
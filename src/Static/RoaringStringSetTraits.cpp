@@ -0,0 +1,73 @@
+#include <srtree/Static/RoaringStringSetTraits.h>
+
+#include <sserialize/utility/exceptions.h>
+
+namespace srtree::Static::detail {
+
+RoaringStringSetTraits::RoaringStringSetTraits() {}
+
+RoaringStringSetTraits::RoaringStringSetTraits(sserialize::UByteArrayAdapter d) :
+m_d(std::make_shared<Data>(d))
+{}
+
+RoaringStringSetTraits::~RoaringStringSetTraits() {}
+
+sserialize::UByteArrayAdapter::SizeType
+RoaringStringSetTraits::getSizeInBytes() const {
+	return m_d->getSizeInBytes();
+}
+
+uint32_t
+RoaringStringSetTraits::strId(std::string const & str) const {
+	return m_d->str2Id.at(str, false);
+}
+
+RoaringStringSetTraits::MayHaveMatch
+RoaringStringSetTraits::mayHaveMatch(std::string const & str, uint32_t editDistance) const {
+	if (editDistance > 0) {
+		throw sserialize::UnimplementedFunctionException("RoaringStringSetTraits does not support an editDistance > 0 yet.");
+	}
+	Signature strs;
+	uint32_t pos = m_d->str2Id.find(str, false);
+	if (pos != m_d->str2Id.npos) {
+		strs = Signature(std::vector<uint32_t>(1, m_d->str2Id.at(pos)));
+	}
+	return MayHaveMatch(strs);
+}
+
+RoaringStringSetTraits::Data::Data(sserialize::UByteArrayAdapter d) :
+Version(d, Version::Consume()),
+str2Id(d)
+{}
+
+sserialize::UByteArrayAdapter::SizeType
+RoaringStringSetTraits::Data::getSizeInBytes() const {
+	return 1+str2Id.getSizeInBytes();
+}
+
+RoaringStringSetTraits::MayHaveMatch::~MayHaveMatch() {}
+
+bool
+RoaringStringSetTraits::MayHaveMatch::operator()(Signature const & ns) const {
+	return m_p([&ns](Signature const & ref) -> bool { return ref.intersects(ns); });
+}
+
+RoaringStringSetTraits::MayHaveMatch
+RoaringStringSetTraits::MayHaveMatch::operator/(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p / other.m_p);
+}
+
+RoaringStringSetTraits::MayHaveMatch
+RoaringStringSetTraits::MayHaveMatch::operator+(MayHaveMatch const & other) const {
+	return MayHaveMatch(m_p + other.m_p);
+}
+
+RoaringStringSetTraits::MayHaveMatch::MayHaveMatch(Signature const & reference) :
+m_p(reference)
+{}
+
+RoaringStringSetTraits::MayHaveMatch::MayHaveMatch(Program && p) :
+m_p(std::move(p))
+{}
+
+}//end namespace srtree::Static::detail
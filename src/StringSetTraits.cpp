@@ -51,65 +51,6 @@ StringSetTraits::strId(std::string const & str) const {
 	return str2Id().at(str).value;
 }
 
-StringSetTraits::MayHaveMatch::IntersectNode::IntersectNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second) :
-first(std::move(first)),
-second(std::move(second))
-{}
-
-StringSetTraits::MayHaveMatch::IntersectNode::~IntersectNode()
-{}
-
-bool
-StringSetTraits::MayHaveMatch::IntersectNode::matches(sserialize::ItemIndex const & v) {
-	return first->matches(v) && second->matches(v);
-}
-
-std::unique_ptr<StringSetTraits::MayHaveMatch::Node>
-StringSetTraits::MayHaveMatch::IntersectNode::copy() const {
-	auto fc = first->copy();
-	auto sc = second->copy();
-	return std::unique_ptr<Node>( new IntersectNode(std::move(fc), std::move(sc)) );
-}
-
-StringSetTraits::MayHaveMatch::UniteNode::UniteNode(std::unique_ptr<Node> && first, std::unique_ptr<Node> && second) :
-first(std::move(first)),
-second(std::move(second))
-{}
-
-StringSetTraits::MayHaveMatch::UniteNode::~UniteNode()
-{}
-
-bool
-StringSetTraits::MayHaveMatch::UniteNode::matches(sserialize::ItemIndex const & v) {
-	return first->matches(v) || second->matches(v);
-}
-
-std::unique_ptr<StringSetTraits::MayHaveMatch::Node>
-StringSetTraits::MayHaveMatch::UniteNode::copy() const {
-	return std::unique_ptr<Node>( new UniteNode(first->copy(), second->copy()) );
-}
-
-StringSetTraits::MayHaveMatch::LeafNode::LeafNode(sserialize::ItemIndex const & ref) :
-ref(ref)
-{}
-
-StringSetTraits::MayHaveMatch::LeafNode::~LeafNode()
-{}
-
-bool
-StringSetTraits::MayHaveMatch::LeafNode::matches(sserialize::ItemIndex const & v) {
-	return (ref / v).size();
-}
-
-std::unique_ptr<StringSetTraits::MayHaveMatch::Node>
-StringSetTraits::MayHaveMatch::LeafNode::copy() const {
-	return std::unique_ptr<Node>( new LeafNode(ref) );
-}
-
-StringSetTraits::MayHaveMatch::MayHaveMatch(MayHaveMatch const & other) : m_d(other.m_d), m_t(other.m_t->copy()) {}
-
-StringSetTraits::MayHaveMatch::MayHaveMatch(MayHaveMatch && other) : m_d(std::move(other.m_d)), m_t(std::move(other.m_t)) {}
-
 StringSetTraits::MayHaveMatch::~MayHaveMatch() {}
 
 bool
@@ -119,29 +60,27 @@ StringSetTraits::MayHaveMatch::operator()(Signature const & ns) {
 
 bool
 StringSetTraits::MayHaveMatch::operator()(sserialize::ItemIndex const & ns) {
-	return m_t->matches(ns);
+	return m_p([&ns](sserialize::ItemIndex const & ref) -> bool { return (ref / ns).size(); });
 }
 
 StringSetTraits::MayHaveMatch
 StringSetTraits::MayHaveMatch::operator/(MayHaveMatch const & other) const {
-	auto nt = std::unique_ptr<Node>( new IntersectNode(m_t->copy(), other.m_t->copy()) );
-	return MayHaveMatch(m_d, std::move(nt));
+	return MayHaveMatch(m_d, m_p / other.m_p);
 }
 
 StringSetTraits::MayHaveMatch
 StringSetTraits::MayHaveMatch::operator+(MayHaveMatch const & other) const {
-	auto nt = std::unique_ptr<Node>( new UniteNode(m_t->copy(), other.m_t->copy()) );
-	return MayHaveMatch(m_d, std::move(nt));
+	return MayHaveMatch(m_d, m_p + other.m_p);
 }
 
 StringSetTraits::MayHaveMatch::MayHaveMatch(DataPtr const & d, sserialize::ItemIndex const & reference) :
 m_d(d),
-m_t(std::unique_ptr<Node>( new LeafNode(reference) ))
+m_p(reference)
 {}
 
-StringSetTraits::MayHaveMatch::MayHaveMatch(DataPtr const & d, std::unique_ptr<Node> && t) :
+StringSetTraits::MayHaveMatch::MayHaveMatch(DataPtr const & d, Program && p) :
 m_d(d),
-m_t(std::move(t))
+m_p(std::move(p))
 {}
 
 sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, StringSetTraits & traits) {
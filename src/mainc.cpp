@@ -6,6 +6,10 @@
 
 #include <srtree/PQGramTraits.h>
 #include <srtree/DedupSerializationTraitsAdapter.h>
+#include <srtree/BBitSerializationTraitsAdapter.h>
+#include <srtree/BottomKSignatureTraits.h>
+#include <srtree/BloomFilterSignatureTraits.h>
+#include <srtree/RoaringStringSetTraits.h>
 
 #include <crypto++/sha.h>
 
@@ -17,7 +21,16 @@ enum TreeType {
 	TT_MINWISE_LCG_32_DEDUP,
 	TT_MINWISE_LCG_64_DEDUP,
 	TT_MINWISE_SHA_DEDUP,
+	TT_MINWISE_MS_32,
+	TT_MINWISE_MS_64,
+	TT_MINWISE_OPH_64,
+	TT_MINWISE_XXH,
+	TT_BOTTOMK,
+	TT_BOTTOMK_DEDUP,
+	TT_BLOOM,
+	TT_BLOOM_DEDUP,
 	TT_STRINGSET,
+	TT_STRINGSET_ROARING_DEDUP,
 	TT_QGRAM,
 	TT_QGRAM_DEDUP
 };
@@ -31,6 +44,16 @@ struct Config {
 	uint32_t numThreads{0};
 	uint32_t q{3};
 	uint32_t hashSize{2};
+	uint32_t chooseSubTreeCandidates{8};
+	double signatureWeight{0};
+	///memory budget in MiB of the out-of-memory build, 0 builds the tree in memory
+	std::size_t oomMemoryBudget{0};
+	///number of bits per serialized signature entry, 0 stores the full entries
+	uint32_t bbits{0};
+	///number of bits of the Bloom filter signatures
+	uint32_t bloomBits{1024};
+	///memory budget in MiB of the cache of key:value signatures, 0 disables the cache
+	std::size_t signatureCacheSize{0};
 };
 
 struct BaseState {
@@ -41,8 +64,78 @@ struct BaseState {
 	sserialize::UByteArrayAdapter traitsData;
 };
 
+template<typename T_SIGNATURE_TRAITS>
+void createMinWise(Config const & cfg, BaseState & baseState) {
+	OMHRTree<T_SIGNATURE_TRAITS> state(baseState.cmp, cfg.q, cfg.hashSize);
+	state.setSignatureCacheSize(cfg.signatureCacheSize << 20);
+	if (cfg.oomMemoryBudget) {
+		state.createOOM(baseState.treeData, baseState.traitsData, cfg.numThreads, cfg.oomMemoryBudget << 20);
+		return;
+	}
+	state.setCheck(cfg.check);
+	state.state.tree.setChooseSubTreeCandidates(cfg.chooseSubTreeCandidates);
+	state.state.tree.setSignatureWeight(cfg.signatureWeight);
+	state.create(cfg.numThreads);
+	state.setCheck(cfg.checkSerialization);
+	state.serialize(baseState.treeData, baseState.traitsData);
+}
+
+///Create a tree whose signatures are serialized with cfg.bbits bits per entry
+template<typename T_SIGNATURE_TRAITS>
+void createBBitMinWise(Config const & cfg, BaseState & baseState) {
+	switch(cfg.bbits) {
+	case 1:
+		createMinWise< srtree::detail::BBitSerializationTraitsAdapter<T_SIGNATURE_TRAITS, 1> >(cfg, baseState);
+		break;
+	case 2:
+		createMinWise< srtree::detail::BBitSerializationTraitsAdapter<T_SIGNATURE_TRAITS, 2> >(cfg, baseState);
+		break;
+	case 4:
+		createMinWise< srtree::detail::BBitSerializationTraitsAdapter<T_SIGNATURE_TRAITS, 4> >(cfg, baseState);
+		break;
+	case 8:
+		createMinWise< srtree::detail::BBitSerializationTraitsAdapter<T_SIGNATURE_TRAITS, 8> >(cfg, baseState);
+		break;
+	default:
+		createMinWise<T_SIGNATURE_TRAITS>(cfg, baseState);
+		break;
+	}
+}
+
+///Create a tree whose signatures are Bloom filters of T_BITS bits
+template<std::size_t T_BITS, bool T_DEDUP>
+void createBloomFilter(Config const & cfg, BaseState & baseState) {
+	using Traits = srtree::detail::BloomFilterSignatureTraits<T_BITS>;
+	if constexpr (T_DEDUP) {
+		createMinWise< srtree::detail::DedupSerializationTraitsAdapter<Traits> >(cfg, baseState);
+	}
+	else {
+		createMinWise<Traits>(cfg, baseState);
+	}
+}
+
+///Create a tree whose signatures are Bloom filters of cfg.bloomBits bits
+template<bool T_DEDUP>
+void createBloomFilter(Config const & cfg, BaseState & baseState) {
+	switch(cfg.bloomBits) {
+	case 512:
+		createBloomFilter<512, T_DEDUP>(cfg, baseState);
+		break;
+	case 2048:
+		createBloomFilter<2048, T_DEDUP>(cfg, baseState);
+		break;
+	case 4096:
+		createBloomFilter<4096, T_DEDUP>(cfg, baseState);
+		break;
+	case 1024:
+	default:
+		createBloomFilter<1024, T_DEDUP>(cfg, baseState);
+		break;
+	}
+}
+
 void help() {
-	std::cout << "prg -i <oscar search files> -o <path to srtree files> -t <minwise-lcg32|minwise-lcg64|minwise-sha|minwise-lcg32-dedup|minwise-lcg64-dedup|minwise-sha-dedup|stringset|qgram|qgram-dedup> --check --threads <num threads> --hashSize <num> -q <size of q-grams> --check-serialization" << std::endl;
+	std::cout << "prg -i <oscar search files> -o <path to srtree files> -t <minwise-lcg32|minwise-lcg64|minwise-sha|minwise-lcg32-dedup|minwise-lcg64-dedup|minwise-sha-dedup|minwise-ms32|minwise-ms64|minwise-oph|minwise-xxh|bottomk|bottomk-dedup|bloom|bloom-dedup|stringset|stringset-roaring-dedup|qgram|qgram-dedup> --check --threads <num threads> --hashSize <num> -q <size of q-grams> --check-serialization --cst-candidates <num, 0=exact> --signature-weight <0..1> --oom <memory budget in MiB, minwise, bottomk and bloom only, not with --check or --check-serialization> --bbits <1|2|4|8, minwise without dedup only> --bloom-bits <512|1024|2048|4096, bloom only> --signature-cache <memory budget in MiB, minwise, bottomk and bloom only>" << std::endl;
 }
 
 int main(int argc, char ** argv) {
@@ -80,9 +173,36 @@ int main(int argc, char ** argv) {
 			else if ("minwise-sha-dedup" == token) {
 				cfg.tt = TT_MINWISE_SHA_DEDUP;
 			}
+			else if ("minwise-ms32" == token) {
+				cfg.tt = TT_MINWISE_MS_32;
+			}
+			else if ("minwise-ms64" == token) {
+				cfg.tt = TT_MINWISE_MS_64;
+			}
+			else if ("minwise-oph" == token) {
+				cfg.tt = TT_MINWISE_OPH_64;
+			}
+			else if ("minwise-xxh" == token) {
+				cfg.tt = TT_MINWISE_XXH;
+			}
+			else if ("bottomk" == token) {
+				cfg.tt = TT_BOTTOMK;
+			}
+			else if ("bottomk-dedup" == token) {
+				cfg.tt = TT_BOTTOMK_DEDUP;
+			}
+			else if ("bloom" == token) {
+				cfg.tt = TT_BLOOM;
+			}
+			else if ("bloom-dedup" == token) {
+				cfg.tt = TT_BLOOM_DEDUP;
+			}
 			else if ("stringset" == token) {
 				cfg.tt = TT_STRINGSET;
 			}
+			else if ("stringset-roaring-dedup" == token) {
+				cfg.tt = TT_STRINGSET_ROARING_DEDUP;
+			}
 			else if ("qgram" == token) {
 				cfg.tt = TT_QGRAM;
 			}
@@ -118,6 +238,30 @@ int main(int argc, char ** argv) {
 			cfg.hashSize = ::atoi(argv[i+1]);
 			++i;
 		}
+		else if ("--cst-candidates" == token && i+1 < argc) {
+			cfg.chooseSubTreeCandidates = ::atoi(argv[i+1]);
+			++i;
+		}
+		else if ("--signature-weight" == token && i+1 < argc) {
+			cfg.signatureWeight = ::atof(argv[i+1]);
+			++i;
+		}
+		else if ("--oom" == token && i+1 < argc) {
+			cfg.oomMemoryBudget = ::atoll(argv[i+1]);
+			++i;
+		}
+		else if ("--bbits" == token && i+1 < argc) {
+			cfg.bbits = ::atoi(argv[i+1]);
+			++i;
+		}
+		else if ("--bloom-bits" == token && i+1 < argc) {
+			cfg.bloomBits = ::atoi(argv[i+1]);
+			++i;
+		}
+		else if ("--signature-cache" == token && i+1 < argc) {
+			cfg.signatureCacheSize = ::atoll(argv[i+1]);
+			++i;
+		}
 	}
 	
 	if (cfg.outdir.empty()) {
@@ -153,17 +297,40 @@ int main(int argc, char ** argv) {
 		return -1;
 	}
 
+	if (cfg.oomMemoryBudget && (cfg.tt == TT_STRINGSET || cfg.tt == TT_STRINGSET_ROARING_DEDUP || cfg.tt == TT_QGRAM || cfg.tt == TT_QGRAM_DEDUP)) {
+		std::cerr << "Out-of-memory build is only supported by minwise trees" << std::endl;
+		return -1;
+	}
+	
+	if (cfg.oomMemoryBudget && (cfg.check || cfg.checkSerialization)) {
+		std::cerr << "--check and --check-serialization need the in-memory tree and are not supported by the out-of-memory build" << std::endl;
+		return -1;
+	}
+	
+	if (cfg.bbits && cfg.bbits != 1 && cfg.bbits != 2 && cfg.bbits != 4 && cfg.bbits != 8) {
+		help();
+		std::cerr << "Invalid number of bits per signature entry: " << cfg.bbits << std::endl;
+		return -1;
+	}
+	
+	if (cfg.bbits && (cfg.tt == TT_MINWISE_LCG_32_DEDUP || cfg.tt == TT_MINWISE_LCG_64_DEDUP || cfg.tt == TT_MINWISE_SHA_DEDUP || cfg.tt == TT_BOTTOMK || cfg.tt == TT_BOTTOMK_DEDUP || cfg.tt == TT_BLOOM || cfg.tt == TT_BLOOM_DEDUP || cfg.tt == TT_STRINGSET || cfg.tt == TT_STRINGSET_ROARING_DEDUP || cfg.tt == TT_QGRAM || cfg.tt == TT_QGRAM_DEDUP)) {
+		std::cerr << "b-bit signatures are only supported by minwise trees without dedup" << std::endl;
+		return -1;
+	}
+	
+	if (cfg.bloomBits != 512 && cfg.bloomBits != 1024 && cfg.bloomBits != 2048 && cfg.bloomBits != 4096) {
+		help();
+		std::cerr << "Invalid number of bits of the Bloom filters: " << cfg.bloomBits << std::endl;
+		return -1;
+	}
+
 	switch(cfg.tt) {
 	case TT_MINWISE_LCG_32:
 	{
 		constexpr std::size_t SignatureSize = 56;
 		using Hash = srtree::detail::MinWisePermutation::LinearCongruentialHash<32>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
-		OMHRTree<Traits> state(baseState.cmp, cfg.q, cfg.hashSize);
-		state.setCheck(cfg.check);
-		state.create(cfg.numThreads);
-		state.setCheck(cfg.checkSerialization);
-		state.serialize(baseState.treeData, baseState.traitsData);
+		createBBitMinWise<Traits>(cfg, baseState);
 	}
 		break;
 	case TT_MINWISE_LCG_64:
@@ -171,11 +338,7 @@ int main(int argc, char ** argv) {
 		constexpr std::size_t SignatureSize = 56;
 		using Hash = srtree::detail::MinWisePermutation::LinearCongruentialHash<64>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
-		OMHRTree<Traits> state(baseState.cmp, cfg.q, cfg.hashSize);
-		state.setCheck(cfg.check);
-		state.create(cfg.numThreads);
-		state.setCheck(cfg.checkSerialization);
-		state.serialize(baseState.treeData, baseState.traitsData);
+		createBBitMinWise<Traits>(cfg, baseState);
 	}
 		break;
 	case TT_MINWISE_SHA:
@@ -183,11 +346,7 @@ int main(int argc, char ** argv) {
 		constexpr std::size_t SignatureSize = 56;
 		using Hash = srtree::detail::MinWisePermutation::CryptoPPHash<CryptoPP::SHA3_64>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
-		OMHRTree<Traits> state(baseState.cmp, cfg.q, cfg.hashSize);
-		state.setCheck(cfg.check);
-		state.create(cfg.numThreads);
-		state.setCheck(cfg.checkSerialization);
-		state.serialize(baseState.treeData, baseState.traitsData);
+		createBBitMinWise<Traits>(cfg, baseState);
 	}
 		break;
 	case TT_MINWISE_LCG_32_DEDUP:
@@ -196,11 +355,7 @@ int main(int argc, char ** argv) {
 		using Hash = srtree::detail::MinWisePermutation::LinearCongruentialHash<32>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
 		using DedupTraits = srtree::detail::DedupSerializationTraitsAdapter<Traits>;
-		OMHRTree<DedupTraits> state(baseState.cmp, cfg.q, cfg.hashSize);
-		state.setCheck(cfg.check);
-		state.create(cfg.numThreads);
-		state.setCheck(cfg.checkSerialization);
-		state.serialize(baseState.treeData, baseState.traitsData);
+		createMinWise<DedupTraits>(cfg, baseState);
 	}
 		break;
 	case TT_MINWISE_LCG_64_DEDUP:
@@ -209,11 +364,7 @@ int main(int argc, char ** argv) {
 		using Hash = srtree::detail::MinWisePermutation::LinearCongruentialHash<64>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
 		using DedupTraits = srtree::detail::DedupSerializationTraitsAdapter<Traits>;
-		OMHRTree<DedupTraits> state(baseState.cmp, cfg.q, cfg.hashSize);
-		state.setCheck(cfg.check);
-		state.create(cfg.numThreads);
-		state.setCheck(cfg.checkSerialization);
-		state.serialize(baseState.treeData, baseState.traitsData);
+		createMinWise<DedupTraits>(cfg, baseState);
 	}
 		break;
 	case TT_MINWISE_SHA_DEDUP:
@@ -222,17 +373,80 @@ int main(int argc, char ** argv) {
 		using Hash = srtree::detail::MinWisePermutation::CryptoPPHash<CryptoPP::SHA3_64>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
 		using DedupTraits = srtree::detail::DedupSerializationTraitsAdapter<Traits>;
-		OMHRTree<DedupTraits> state(baseState.cmp, cfg.q, cfg.hashSize);
+		createMinWise<DedupTraits>(cfg, baseState);
+	}
+		break;
+	case TT_MINWISE_MS_32:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::MultiplyShiftHash<32>;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		createBBitMinWise<Traits>(cfg, baseState);
+	}
+		break;
+	case TT_MINWISE_MS_64:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::MultiplyShiftHash<64>;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		createBBitMinWise<Traits>(cfg, baseState);
+	}
+		break;
+	case TT_MINWISE_OPH_64:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::OnePermutation<srtree::detail::MinWisePermutation::MultiplyShiftHash<64>>;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		createBBitMinWise<Traits>(cfg, baseState);
+	}
+		break;
+	case TT_MINWISE_XXH:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::XXHash64;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		createBBitMinWise<Traits>(cfg, baseState);
+	}
+		break;
+	case TT_BOTTOMK:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Traits = srtree::detail::BottomKSignatureTraits<SignatureSize>;
+		createMinWise<Traits>(cfg, baseState);
+	}
+		break;
+	case TT_BOTTOMK_DEDUP:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Traits = srtree::detail::BottomKSignatureTraits<SignatureSize>;
+		using DedupTraits = srtree::detail::DedupSerializationTraitsAdapter<Traits>;
+		createMinWise<DedupTraits>(cfg, baseState);
+	}
+		break;
+	case TT_BLOOM:
+		createBloomFilter<false>(cfg, baseState);
+		break;
+	case TT_BLOOM_DEDUP:
+		createBloomFilter<true>(cfg, baseState);
+		break;
+	case TT_STRINGSET:
+	{
+		OStringSetRTree<srtree::detail::StringSetTraits> state(baseState.cmp);
 		state.setCheck(cfg.check);
-		state.create(cfg.numThreads);
+		state.state.tree.setChooseSubTreeCandidates(cfg.chooseSubTreeCandidates);
+		state.state.tree.setSignatureWeight(cfg.signatureWeight);
+		state.create();
 		state.setCheck(cfg.checkSerialization);
 		state.serialize(baseState.treeData, baseState.traitsData);
 	}
 		break;
-	case TT_STRINGSET:
+	case TT_STRINGSET_ROARING_DEDUP:
 	{
-		OStringSetRTree state(baseState.cmp);
+		using Traits = srtree::detail::DedupSerializationTraitsAdapter<srtree::detail::RoaringStringSetTraits>;
+		OStringSetRTree<Traits> state(baseState.cmp);
 		state.setCheck(cfg.check);
+		state.state.tree.setChooseSubTreeCandidates(cfg.chooseSubTreeCandidates);
+		state.state.tree.setSignatureWeight(cfg.signatureWeight);
 		state.create();
 		state.setCheck(cfg.checkSerialization);
 		state.serialize(baseState.treeData, baseState.traitsData);
@@ -242,6 +456,8 @@ int main(int argc, char ** argv) {
 	{
 		OPQGramsRTree<srtree::detail::PQGramTraits> state(baseState.cmp, cfg.q);
 		state.setCheck(cfg.check);
+		state.state.tree.setChooseSubTreeCandidates(cfg.chooseSubTreeCandidates);
+		state.state.tree.setSignatureWeight(cfg.signatureWeight);
 		state.create();
 		state.setCheck(cfg.checkSerialization);
 		state.serialize(baseState.treeData, baseState.traitsData);
@@ -252,6 +468,8 @@ int main(int argc, char ** argv) {
 		using Traits = srtree::detail::DedupSerializationTraitsAdapter<srtree::detail::PQGramTraits>;
 		OPQGramsRTree<Traits> state(baseState.cmp, cfg.q);
 		state.setCheck(cfg.check);
+		state.state.tree.setChooseSubTreeCandidates(cfg.chooseSubTreeCandidates);
+		state.state.tree.setSignatureWeight(cfg.signatureWeight);
 		state.create();
 		state.setCheck(cfg.checkSerialization);
 		state.serialize(baseState.treeData, baseState.traitsData);
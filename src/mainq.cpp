@@ -1,7 +1,11 @@
 #include <srtree/Static/SRTree.h>
 #include <srtree/PQGramTraits.h>
 #include <srtree/Static/DedupDeserializationTraitsAdapter.h>
+#include <srtree/Static/BBitDeserializationTraitsAdapter.h>
 #include <srtree/Static/StringSetTraits.h>
+#include <srtree/Static/RoaringStringSetTraits.h>
+#include <srtree/BottomKSignatureTraits.h>
+#include <srtree/BloomFilterSignatureTraits.h>
 #include <liboscar/AdvancedOpTree.h>
 #include <liboscar/StaticOsmCompleter.h>
 #include <liboscar/KVStats.h>
@@ -18,7 +22,16 @@ enum TreeType {
 	TT_MINWISE_LCG_32_DEDUP,
 	TT_MINWISE_LCG_64_DEDUP,
 	TT_MINWISE_SHA_DEDUP,
+	TT_MINWISE_MS_32,
+	TT_MINWISE_MS_64,
+	TT_MINWISE_OPH_64,
+	TT_MINWISE_XXH,
+	TT_BOTTOMK,
+	TT_BOTTOMK_DEDUP,
+	TT_BLOOM,
+	TT_BLOOM_DEDUP,
 	TT_STRINGSET,
+	TT_STRINGSET_ROARING_DEDUP,
 	TT_QGRAM,
 	TT_QGRAM_DEDUP
 };
@@ -29,6 +42,7 @@ struct BenchConfig {
 	uint32_t branch{10}; //number of sub-queries for each query, recurive until count is reached
 	uint32_t bounds{5}; //maximum number of bounds (union of these is the result)
 	std::string out; //raw stats output
+	bool adaptive{false}; //evaluate the predicates in the order chosen by srtree::TraversalStatistics
 };
 
 struct Config {
@@ -40,6 +54,10 @@ struct Config {
 	TreeType tt;
 	std::vector<std::string> queries;
 	bool preload{false};
+	///number of bits per signature entry of b-bit trees, 0 for full signatures
+	uint32_t bbits{0};
+	///number of bits of the Bloom filters of bloom trees, has to be the one used to create the tree
+	uint32_t bloomBits{1024};
 };
 
 struct Data {
@@ -541,6 +559,24 @@ struct Completer {
 		
 		std::cout << "Leaf nodes visit overhead (scaled with result size):";
 		sserialize::statistics::StatPrinting::print(std::cout, overhead.leafNodes.begin(), overhead.leafNodes.end());
+		
+		//raw numbers to compare trees built with different parameters on the same queries
+		if (bc.out.size()) {
+			std::ofstream of(bc.out);
+			if (!of.is_open()) {
+				std::cerr << "Could not open file " << bc.out << std::endl;
+			}
+			else {
+				of << "Query;Visited internal nodes;Visited leaf nodes;Visited item nodes;Required internal nodes;Required leaf nodes;Required item nodes;\n";
+				for(std::size_t i(0), s(be.size()); i < s; ++i) {
+					of << strs2OQ(be[i].strs) << ';';
+					of << visited.internalNodes[i] << ';' << visited.leafNodes[i] << ';' << visited.itemNodes[i] << ';';
+					of << mustVisit.internalNodes[i] << ';' << mustVisit.leafNodes[i] << ';' << mustVisit.itemNodes[i] << ';';
+					of << '\n';
+				}
+				of << std::flush;
+			}
+		}
 	}
 	
 	void bench(liboscar::Static::OsmCompleter & cmp, BenchConfig const & bc) {
@@ -549,6 +585,7 @@ struct Completer {
 		std::vector<BenchEntry> be = createBenchEntries(cmp, bc);
 		
 		std::vector<StatsEntry> stats(be.size());
+		srtree::TraversalStatistics tstats;
 		
 		pinfo.begin(be.size(), "Benchmarking tree");
 		for(std::size_t i(0), s(be.size()); i < s; ++i) {
@@ -557,7 +594,12 @@ struct Completer {
 			std::vector<uint32_t> result;
 			
 			tm.begin();
-			tree.find(gmp, smp, std::back_inserter(result));
+			if (bc.adaptive) {
+				tree.find(gmp, smp, std::back_inserter(result), tstats);
+			}
+			else {
+				tree.find(gmp, smp, std::back_inserter(result));
+			}
 			tm.end();
 			
 			std::sort(result.begin(), result.end());
@@ -569,6 +611,10 @@ struct Completer {
 		}
 		pinfo.end();
 		
+		if (bc.adaptive) {
+			std::cout << "Adaptive predicate order:\n" << tstats << std::flush;
+		}
+		
 		pinfo.begin(be.size(), "Benchmarking OSCAR");
 		for(std::size_t i(0), s(be.size()); i < s; ++i) {
 			auto smp = strs2OQ(be[i].strs);
@@ -634,8 +680,77 @@ struct Completer {
 	Tree tree;
 };
 
+template<typename T_SIGNATURE_TRAITS>
+void complete(Config const & cfg, Data & data) {
+	Completer<T_SIGNATURE_TRAITS> tcmp(data.treeData, data.traitsData);
+	if (cfg.test) {
+		tcmp.test(data.cmp);
+	}
+	if (cfg.bc.count) {
+		tcmp.bench(data.cmp, cfg.bc);
+	}
+	if (cfg.pbc.count) {
+		tcmp.benchPruning(data.cmp, cfg.pbc);
+	}
+	tcmp.complete(cfg.queries);
+}
+
+///Query a tree whose signatures are serialized with cfg.bbits bits per entry
+template<typename T_SIGNATURE_TRAITS>
+void completeBBitMinWise(Config const & cfg, Data & data) {
+	switch(cfg.bbits) {
+	case 1:
+		complete< srtree::detail::BBitDeserializationTraitsAdapter<T_SIGNATURE_TRAITS, 1> >(cfg, data);
+		break;
+	case 2:
+		complete< srtree::detail::BBitDeserializationTraitsAdapter<T_SIGNATURE_TRAITS, 2> >(cfg, data);
+		break;
+	case 4:
+		complete< srtree::detail::BBitDeserializationTraitsAdapter<T_SIGNATURE_TRAITS, 4> >(cfg, data);
+		break;
+	case 8:
+		complete< srtree::detail::BBitDeserializationTraitsAdapter<T_SIGNATURE_TRAITS, 8> >(cfg, data);
+		break;
+	default:
+		complete<T_SIGNATURE_TRAITS>(cfg, data);
+		break;
+	}
+}
+
+///Query a tree whose signatures are Bloom filters of T_BITS bits
+template<std::size_t T_BITS, bool T_DEDUP>
+void completeBloomFilter(Config const & cfg, Data & data) {
+	using Traits = srtree::detail::BloomFilterSignatureTraits<T_BITS>;
+	if constexpr (T_DEDUP) {
+		complete< srtree::detail::DedupDeserializationTraitsAdapter<Traits> >(cfg, data);
+	}
+	else {
+		complete<Traits>(cfg, data);
+	}
+}
+
+///Query a tree whose signatures are Bloom filters of cfg.bloomBits bits
+template<bool T_DEDUP>
+void completeBloomFilter(Config const & cfg, Data & data) {
+	switch(cfg.bloomBits) {
+	case 512:
+		completeBloomFilter<512, T_DEDUP>(cfg, data);
+		break;
+	case 2048:
+		completeBloomFilter<2048, T_DEDUP>(cfg, data);
+		break;
+	case 4096:
+		completeBloomFilter<4096, T_DEDUP>(cfg, data);
+		break;
+	case 1024:
+	default:
+		completeBloomFilter<1024, T_DEDUP>(cfg, data);
+		break;
+	}
+}
+
 void help() {
-	std::cout << "prg -i <input dir> -o <oscar dir> -t <minwise-lcg32|minwise-lcg64|minwise-sha|minwise-lcg32-dedup|minwise-lcg64-dedup|minwise-sha-dedup|stringset|qgram|qgram-dedup> -m <query> --test --bench count initial branch bounds --prune-bench count initial branch bounds --help [bench]" << std::endl;
+	std::cout << "prg -i <input dir> -o <oscar dir> -t <minwise-lcg32|minwise-lcg64|minwise-sha|minwise-lcg32-dedup|minwise-lcg64-dedup|minwise-sha-dedup|minwise-ms32|minwise-ms64|minwise-oph|minwise-xxh|bottomk|bottomk-dedup|bloom|bloom-dedup|stringset|stringset-roaring-dedup|qgram|qgram-dedup> -m <query> --test --bench count initial branch bounds --prune-bench count initial branch bounds --bbits <1|2|4|8> --bloom-bits <512|1024|2048|4096> --adaptive --help [bench]" << std::endl;
 }
 void benchHelp() {
 	std::cout <<
@@ -647,7 +762,9 @@ void benchHelp() {
 		"We then compute for each query 1 to @bounds many rectangular queries as follows.\n"
 		"We first compute the region-DAG of the query and sort the regions by their id.\n"
 		"We partition the regions into 10 bins (approximately the size of the regions) and select a bin with geometric distribution.\n"
-		"Within a bin we select the region uniformly at random."
+		"Within a bin we select the region uniformly at random.\n"
+		"With --adaptive the tree chooses per level whether to test the boundary or the signature of a node first\n"
+		"and skips the signature test of levels where it rarely prunes. The choices are printed after the benchmark."
 	<< std::endl;
 }
 
@@ -684,9 +801,36 @@ int main(int argc, char ** argv) {
 			else if ("minwise-sha-dedup" == token) {
 				cfg.tt = TT_MINWISE_SHA_DEDUP;
 			}
+			else if ("minwise-ms32" == token) {
+				cfg.tt = TT_MINWISE_MS_32;
+			}
+			else if ("minwise-ms64" == token) {
+				cfg.tt = TT_MINWISE_MS_64;
+			}
+			else if ("minwise-oph" == token) {
+				cfg.tt = TT_MINWISE_OPH_64;
+			}
+			else if ("minwise-xxh" == token) {
+				cfg.tt = TT_MINWISE_XXH;
+			}
+			else if ("bottomk" == token) {
+				cfg.tt = TT_BOTTOMK;
+			}
+			else if ("bottomk-dedup" == token) {
+				cfg.tt = TT_BOTTOMK_DEDUP;
+			}
+			else if ("bloom" == token) {
+				cfg.tt = TT_BLOOM;
+			}
+			else if ("bloom-dedup" == token) {
+				cfg.tt = TT_BLOOM_DEDUP;
+			}
 			else if ("stringset" == token) {
 				cfg.tt = TT_STRINGSET;
 			}
+			else if ("stringset-roaring-dedup" == token) {
+				cfg.tt = TT_STRINGSET_ROARING_DEDUP;
+			}
 			else if ("qgram" == token) {
 				cfg.tt = TT_QGRAM;
 			}
@@ -725,13 +869,24 @@ int main(int argc, char ** argv) {
 			cfg.pbc.bounds = ::atoi(argv[i+4]);
 			i += 4;
 			if (i+1 < argc && argv[i+1][0] != '-') {
-				cfg.bc.out = std::string(argv[i+1]);
+				cfg.pbc.out = std::string(argv[i+1]);
 				++i;
 			}
 		}
+		else if ("--adaptive" == token) {
+			cfg.bc.adaptive = true;
+		}
 		else if ("--preload" == token) {
 			cfg.preload = true;
 		}
+		else if ("--bbits" == token && i+1 < argc) {
+			cfg.bbits = ::atoi(argv[i+1]);
+			++i;
+		}
+		else if ("--bloom-bits" == token && i+1 < argc) {
+			cfg.bloomBits = ::atoi(argv[i+1]);
+			++i;
+		}
 		else if ("--help" == token) {
 			if (i+1 < argc && "bench" == std::string(argv[i+1])) {
 				benchHelp();
@@ -754,6 +909,23 @@ int main(int argc, char ** argv) {
 		return -1;
 	}
 	
+	if (cfg.bbits && cfg.bbits != 1 && cfg.bbits != 2 && cfg.bbits != 4 && cfg.bbits != 8) {
+		help();
+		std::cerr << "Invalid number of bits per signature entry: " << cfg.bbits << std::endl;
+		return -1;
+	}
+	
+	if (cfg.bbits && (cfg.tt == TT_MINWISE_LCG_32_DEDUP || cfg.tt == TT_MINWISE_LCG_64_DEDUP || cfg.tt == TT_MINWISE_SHA_DEDUP || cfg.tt == TT_BOTTOMK || cfg.tt == TT_BOTTOMK_DEDUP || cfg.tt == TT_BLOOM || cfg.tt == TT_BLOOM_DEDUP || cfg.tt == TT_STRINGSET || cfg.tt == TT_STRINGSET_ROARING_DEDUP || cfg.tt == TT_QGRAM || cfg.tt == TT_QGRAM_DEDUP)) {
+		std::cerr << "b-bit signatures are only supported by minwise trees without dedup" << std::endl;
+		return -1;
+	}
+	
+	if (cfg.bloomBits != 512 && cfg.bloomBits != 1024 && cfg.bloomBits != 2048 && cfg.bloomBits != 4096) {
+		help();
+		std::cerr << "Invalid number of bits of the Bloom filters: " << cfg.bloomBits << std::endl;
+		return -1;
+	}
+	
 	data.treeData = sserialize::UByteArrayAdapter::openRo(cfg.indir + "/tree", false);
 	data.traitsData = sserialize::UByteArrayAdapter::openRo(cfg.indir + "/traits", false);
 	
@@ -787,17 +959,7 @@ int main(int argc, char ** argv) {
 		constexpr std::size_t SignatureSize = 56;
 		using Hash = srtree::detail::MinWisePermutation::LinearCongruentialHash<32>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
-		Completer<Traits> tcmp(data.treeData, data.traitsData);
-		if (cfg.test) {
-			tcmp.test(data.cmp);
-		}
-		if (cfg.bc.count) {
-			tcmp.bench(data.cmp, cfg.bc);
-		}
-		if (cfg.pbc.count) {
-			tcmp.benchPruning(data.cmp, cfg.pbc);
-		}
-		tcmp.complete(cfg.queries);
+		completeBBitMinWise<Traits>(cfg, data);
 	}
 		break;
 	case TT_MINWISE_LCG_64:
@@ -805,17 +967,7 @@ int main(int argc, char ** argv) {
 		constexpr std::size_t SignatureSize = 56;
 		using Hash = srtree::detail::MinWisePermutation::LinearCongruentialHash<64>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
-		Completer<Traits> tcmp(data.treeData, data.traitsData);
-		if (cfg.test) {
-			tcmp.test(data.cmp);
-		}
-		if (cfg.bc.count) {
-			tcmp.bench(data.cmp, cfg.bc);
-		}
-		if (cfg.pbc.count) {
-			tcmp.benchPruning(data.cmp, cfg.pbc);
-		}
-		tcmp.complete(cfg.queries);
+		completeBBitMinWise<Traits>(cfg, data);
 	}
 		break;
 	case TT_MINWISE_SHA:
@@ -823,17 +975,7 @@ int main(int argc, char ** argv) {
 		constexpr std::size_t SignatureSize = 56;
 		using Hash = srtree::detail::MinWisePermutation::CryptoPPHash<CryptoPP::SHA3_64>;
 		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
-		Completer<Traits> tcmp(data.treeData, data.traitsData);
-		if (cfg.test) {
-			tcmp.test(data.cmp);
-		}
-		if (cfg.bc.count) {
-			tcmp.bench(data.cmp, cfg.bc);
-		}
-		if (cfg.pbc.count) {
-			tcmp.benchPruning(data.cmp, cfg.pbc);
-		}
-		tcmp.complete(cfg.queries);
+		completeBBitMinWise<Traits>(cfg, data);
 	}
 		break;
 	case TT_MINWISE_LCG_32_DEDUP:
@@ -893,6 +1035,59 @@ int main(int argc, char ** argv) {
 		tcmp.complete(cfg.queries);
 	}
 		break;
+	case TT_MINWISE_MS_32:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::MultiplyShiftHash<32>;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		completeBBitMinWise<Traits>(cfg, data);
+	}
+		break;
+	case TT_MINWISE_MS_64:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::MultiplyShiftHash<64>;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		completeBBitMinWise<Traits>(cfg, data);
+	}
+		break;
+	case TT_MINWISE_OPH_64:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::OnePermutation<srtree::detail::MinWisePermutation::MultiplyShiftHash<64>>;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		completeBBitMinWise<Traits>(cfg, data);
+	}
+		break;
+	case TT_MINWISE_XXH:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Hash = srtree::detail::MinWisePermutation::XXHash64;
+		using Traits = srtree::detail::MinWiseSignatureTraits<SignatureSize, Hash>;
+		completeBBitMinWise<Traits>(cfg, data);
+	}
+		break;
+	case TT_BOTTOMK:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using Traits = srtree::detail::BottomKSignatureTraits<SignatureSize>;
+		complete<Traits>(cfg, data);
+	}
+		break;
+	case TT_BOTTOMK_DEDUP:
+	{
+		constexpr std::size_t SignatureSize = 56;
+		using BaseTraits = srtree::detail::BottomKSignatureTraits<SignatureSize>;
+		using Traits = srtree::detail::DedupDeserializationTraitsAdapter<BaseTraits>;
+		complete<Traits>(cfg, data);
+	}
+		break;
+	case TT_BLOOM:
+		completeBloomFilter<false>(cfg, data);
+		break;
+	case TT_BLOOM_DEDUP:
+		completeBloomFilter<true>(cfg, data);
+		break;
 	case TT_STRINGSET:
 	{
 		using Traits = srtree::Static::detail::StringSetTraits;
@@ -909,6 +1104,13 @@ int main(int argc, char ** argv) {
 		tcmp.complete(cfg.queries);
 	}
 		break;
+	case TT_STRINGSET_ROARING_DEDUP:
+	{
+		using BaseTraits = srtree::Static::detail::RoaringStringSetTraits;
+		using Traits = srtree::detail::DedupDeserializationTraitsAdapter<BaseTraits>;
+		complete<Traits>(cfg, data);
+	}
+		break;
 	case TT_QGRAM:
 	{
 		using Traits = srtree::Static::detail::PQGramTraits;
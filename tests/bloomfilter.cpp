@@ -0,0 +1,267 @@
+#include "TestBase.h"
+#include <srtree/BloomFilterSignature.h>
+#include <srtree/BloomFilterSignatureTraits.h>
+
+#include <random>
+#include <algorithm>
+
+namespace srtree::tests {
+
+class BloomFilterSignatureTest: public TestBase {
+CPPUNIT_TEST_SUITE( BloomFilterSignatureTest );
+CPPUNIT_TEST( contains );
+CPPUNIT_TEST( combine );
+CPPUNIT_TEST( noFalseNegatives );
+CPPUNIT_TEST_SUITE_END();
+public:
+	static constexpr std::size_t test_count = 300;
+	static constexpr std::size_t string_count = 10;
+	static constexpr std::size_t max_edit_distance = 3;
+public:
+	BloomFilterSignatureTest() {}
+public:
+	void setUp() override;
+public:
+	///contains() (the AVX2 test if enabled) compared with containsScalar() and a plain loop
+	void contains();
+	///Combined signatures are the signatures of the union
+	void combine();
+	///Every string within the edit distance of a string of a set matches the signature of the set
+	void noFalseNegatives();
+private:
+	template<std::size_t T_BITS>
+	void checkContains();
+	template<std::size_t T_BITS>
+	void checkNoFalseNegatives(std::size_t q, std::size_t hashCount);
+	///Random mask with about @param density of its bits set
+	template<typename T_MASK>
+	T_MASK randomMask(double density);
+	std::string randomString(std::size_t minSize, std::size_t maxSize);
+	///Apply @param count random insertions, deletions or substitutions to @param str
+	std::string edit(std::string str, std::size_t count);
+	static std::size_t editDistance(std::string const & a, std::string const & b);
+private:
+	std::default_random_engine m_g;
+};
+
+void
+BloomFilterSignatureTest::setUp() {
+	m_g = std::default_random_engine();
+}
+
+template<typename T_MASK>
+T_MASK
+BloomFilterSignatureTest::randomMask(double density) {
+	auto d = std::bernoulli_distribution(density);
+	T_MASK result{};
+	for(uint64_t & w : result.w) {
+		for(uint32_t i(0); i < 64; ++i) {
+			w |= uint64_t(d(m_g)) << i;
+		}
+	}
+	return result;
+}
+
+std::string
+BloomFilterSignatureTest::randomString(std::size_t minSize, std::size_t maxSize) {
+	auto dc = std::uniform_int_distribution<int>('a', 'h');
+	auto ds = std::uniform_int_distribution<std::size_t>(minSize, maxSize);
+	std::string result;
+	for(std::size_t i(0), s(ds(m_g)); i < s; ++i) {
+		result += char(dc(m_g));
+	}
+	return result;
+}
+
+std::string
+BloomFilterSignatureTest::edit(std::string str, std::size_t count) {
+	auto dc = std::uniform_int_distribution<int>('a', 'z');
+	auto dop = std::uniform_int_distribution<int>(0, 2);
+	for(std::size_t i(0); i < count; ++i) {
+		std::size_t pos = std::uniform_int_distribution<std::size_t>(0, str.size())(m_g);
+		int op = dop(m_g);
+		if (op == 0 || str.size() < 2) {
+			str.insert(str.begin()+pos, char(dc(m_g)));
+		}
+		else if (pos < str.size()) {
+			if (op == 1) {
+				str.erase(str.begin()+pos);
+			}
+			else {
+				str[pos] = char(dc(m_g));
+			}
+		}
+	}
+	return str;
+}
+
+std::size_t
+BloomFilterSignatureTest::editDistance(std::string const & a, std::string const & b) {
+	std::vector<std::size_t> d(b.size()+1);
+	for(std::size_t j(0); j <= b.size(); ++j) {
+		d[j] = j;
+	}
+	for(std::size_t i(1); i <= a.size(); ++i) {
+		std::size_t prev = d[0];
+		d[0] = i;
+		for(std::size_t j(1); j <= b.size(); ++j) {
+			std::size_t tmp = d[j];
+			d[j] = std::min({d[j]+1, d[j-1]+1, prev + (a[i-1] != b[j-1])});
+			prev = tmp;
+		}
+	}
+	return d[b.size()];
+}
+
+template<std::size_t T_BITS>
+void
+BloomFilterSignatureTest::checkContains() {
+	using Signature = BloomFilterSignature<T_BITS>;
+	using BlockMask = typename Signature::BlockMask;
+	auto dblock = std::uniform_int_distribution<std::size_t>(0, Signature::block_count-1);
+	for(std::size_t i(0); i < test_count; ++i) {
+		Signature sig;
+		for(std::size_t j(0), s(i%20); j < s; ++j) {
+			sig.insert(dblock(m_g), randomMask<BlockMask>(0.1 + 0.04*(i%20)));
+		}
+		std::vector<BlockMask> masks;
+		masks.push_back(BlockMask{});
+		masks.push_back(randomMask<BlockMask>(1));
+		//single bits at the word boundaries
+		for(std::size_t w(0); w < Signature::block_words; ++w) {
+			for(uint32_t bit : {0, 31, 32, 63}) {
+				BlockMask m{};
+				m.w[w] = uint64_t(1) << bit;
+				masks.push_back(m);
+			}
+		}
+		for(std::size_t j(0); j < 20; ++j) {
+			masks.push_back(randomMask<BlockMask>(0.02*(1+j)));
+		}
+		for(std::size_t block(0); block < Signature::block_count; ++block) {
+			for(BlockMask const & m : masks) {
+				bool want = true;
+				for(std::size_t w(0); w < Signature::block_words; ++w) {
+					want = want && (m.w[w] & sig.at(block*Signature::block_words+w)) == m.w[w];
+				}
+				CPPUNIT_ASSERT_EQUAL(want, sig.containsScalar(block, m));
+				CPPUNIT_ASSERT_EQUAL(want, sig.contains(block, m));
+			}
+			//a block contains the bits it consists of
+			BlockMask self{};
+			std::copy(sig.data()+block*Signature::block_words, sig.data()+(block+1)*Signature::block_words, self.w);
+			CPPUNIT_ASSERT(sig.contains(block, self));
+		}
+	}
+}
+
+template<std::size_t T_BITS>
+void
+BloomFilterSignatureTest::checkNoFalseNegatives(std::size_t q, std::size_t hashCount) {
+	using Traits = srtree::detail::BloomFilterSignatureTraits<T_BITS>;
+	using Signature = typename Traits::Signature;
+	Traits t(q, 2, hashCount);
+	std::size_t pruned = 0;
+	for(std::size_t i(0); i < test_count; ++i) {
+		std::vector<std::string> strs;
+		for(std::size_t j(0), s(1+i%string_count); j < s; ++j) {
+			strs.push_back(randomString(1, 20));
+		}
+		std::vector<std::string> others;
+		for(std::size_t j(0); j < string_count; ++j) {
+			others.push_back(randomString(1, 20));
+		}
+		std::vector<Signature> sigs;
+		for(std::string const & str : strs) {
+			sigs.push_back(t.signature(str));
+		}
+		//the signature of the set and the ones of supersets
+		std::vector<Signature> nodes;
+		nodes.push_back(t.combine()(sigs.begin(), sigs.end()));
+		nodes.push_back(nodes.back() + t.signature(others.begin(), others.end()));
+		nodes.push_back(t.combine()(t.signature(strs.begin(), strs.end()), t.signature(others.front())));
+		for(std::string const & str : strs) {
+			for(std::size_t ed(0); ed <= max_edit_distance; ++ed) {
+				std::string ref = edit(str, ed);
+				if (ref.empty()) {
+					continue;
+				}
+				auto mhm = t.mayHaveMatch(ref, ed);
+				//an unrelated string that matches with an edit distance larger than its size
+				auto any = t.mayHaveMatch(others.back(), others.back().size()+1);
+				for(Signature const & ns : nodes) {
+					CPPUNIT_ASSERT(mhm(ns));
+					CPPUNIT_ASSERT((mhm / any)(ns));
+					CPPUNIT_ASSERT((any / mhm)(ns));
+					CPPUNIT_ASSERT((mhm + t.mayHaveMatch(others.front(), 0))(ns));
+				}
+			}
+		}
+		//random strings that happen to be close to one of the strings
+		for(std::size_t j(0); j < 20; ++j) {
+			std::string ref = randomString(1, 12);
+			std::size_t ed = editDistance(ref, strs.front());
+			for(std::string const & str : strs) {
+				ed = std::min(ed, editDistance(ref, str));
+			}
+			for(std::size_t k(0); k <= max_edit_distance; ++k) {
+				bool result = t.mayHaveMatch(ref, k)(nodes.front());
+				if (ed <= k) {
+					CPPUNIT_ASSERT(result);
+				}
+				pruned += !result;
+			}
+		}
+	}
+	//the filters are not trivial
+	CPPUNIT_ASSERT(pruned > 0);
+}
+
+void
+BloomFilterSignatureTest::contains() {
+	checkContains<256>();
+	checkContains<1024>();
+}
+
+void
+BloomFilterSignatureTest::combine() {
+	using Traits = srtree::detail::BloomFilterSignatureTraits<1024>;
+	Traits t(3);
+	for(std::size_t i(0); i < test_count; ++i) {
+		std::vector<std::string> strs;
+		std::vector<Traits::Signature> sigs;
+		Traits::Signature expected;
+		for(std::size_t j(0), s(1+i%string_count); j < s; ++j) {
+			strs.push_back(randomString(1, 20));
+			sigs.push_back(t.signature(strs.back()));
+			expected += sigs.back();
+		}
+		Traits::Signature sig = t.signature(strs.begin(), strs.end());
+		CPPUNIT_ASSERT(expected == sig);
+		CPPUNIT_ASSERT(sig == t.combine()(sigs.begin(), sigs.end()));
+		for(Traits::Signature const & x : sigs) {
+			CPPUNIT_ASSERT_EQUAL(x.popcount(), x / sig);
+			CPPUNIT_ASSERT_EQUAL(0.0, t.enlargement()(sig, x));
+		}
+	}
+}
+
+void
+BloomFilterSignatureTest::noFalseNegatives() {
+	checkNoFalseNegatives<256>(2, 1);
+	checkNoFalseNegatives<256>(3, 8);
+	checkNoFalseNegatives<1024>(3, 4);
+	checkNoFalseNegatives<1024>(2, 4);
+	checkNoFalseNegatives<2048>(4, 2);
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	srand( 0 );
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::BloomFilterSignatureTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
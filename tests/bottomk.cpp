@@ -0,0 +1,394 @@
+#include "TestBase.h"
+#include <srtree/BottomKSignature.h>
+#include <srtree/BottomKSignatureTraits.h>
+#include <srtree/QGram.h>
+
+#include <random>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace srtree::tests {
+
+class BottomKSignatureTest: public TestBase {
+CPPUNIT_TEST_SUITE( BottomKSignatureTest );
+CPPUNIT_TEST( insert );
+CPPUNIT_TEST( merge );
+CPPUNIT_TEST( containment );
+CPPUNIT_TEST( cardinality );
+CPPUNIT_TEST( noFalseNegatives );
+CPPUNIT_TEST( fullSketches );
+CPPUNIT_TEST_SUITE_END();
+public:
+	static constexpr std::size_t test_count = 500;
+	static constexpr std::size_t string_count = 20;
+	using Traits = srtree::detail::BottomKSignatureTraits<64>;
+	using HashSet = std::set<uint64_t>;
+public:
+	BottomKSignatureTest() {}
+public:
+	void setUp() override;
+public:
+	///Sketches keep the smallest distinct values, compared with std::set
+	void insert();
+	///The merge of two sketches is the sketch of the union
+	void merge();
+	///containment() and operator/ compared with the sets the sketches were made of
+	void containment();
+	///Exact cardinality of sets smaller than the sketch and the estimate of larger ones
+	void cardinality();
+	///If neither sketch is full every string within the edit distance or with enough common q-grams
+	///of a string of a set matches the signature of the set, also with repeated q-grams
+	void noFalseNegatives();
+	///A set of strings always matches its strings with edit distance 0, also if the sketches are full
+	void fullSketches();
+private:
+	template<std::size_t T_SIZE>
+	void checkInsert();
+	template<std::size_t T_SIZE>
+	void checkMerge();
+	template<std::size_t T_SIZE>
+	void checkContainment();
+	///Random set of @param size values, small values of @param range give many duplicates between sets
+	HashSet randomSet(std::size_t size, uint64_t range);
+	///@return the sketch of @param values
+	template<typename T_SIGNATURE>
+	static T_SIGNATURE sketch(HashSet const & values);
+	///@return the T_SIGNATURE::size smallest values of @param values
+	template<typename T_SIGNATURE>
+	static std::vector<uint64_t> bottomK(HashSet const & values);
+	///Random string of the characters a to @param last, few characters give many repeated q-grams
+	std::string randomString(std::size_t minSize, std::size_t maxSize, char last = 'h');
+	///Apply @param count random insertions, deletions or substitutions to @param str
+	std::string edit(std::string str, std::size_t count, char last);
+	static std::size_t editDistance(std::string const & a, std::string const & b);
+	///Number of common q-grams of @param a and @param b counted with multiplicity
+	static std::size_t overlap(std::string const & a, std::string const & b, std::size_t q);
+	///Distinct q-grams of all strings in [begin, end)
+	template<typename T_ITERATOR>
+	static std::set<std::string> qgrams(T_ITERATOR begin, T_ITERATOR end, std::size_t q);
+private:
+	std::default_random_engine m_g;
+};
+
+void
+BottomKSignatureTest::setUp() {
+	m_g = std::default_random_engine();
+}
+
+BottomKSignatureTest::HashSet
+BottomKSignatureTest::randomSet(std::size_t size, uint64_t range) {
+	auto d = std::uniform_int_distribution<uint64_t>(0, range-1);
+	HashSet result;
+	for(std::size_t i(0); i < size; ++i) {
+		result.insert(d(m_g));
+	}
+	return result;
+}
+
+template<typename T_SIGNATURE>
+T_SIGNATURE
+BottomKSignatureTest::sketch(HashSet const & values) {
+	T_SIGNATURE result;
+	for(uint64_t v : values) {
+		result.insert(v);
+	}
+	return result;
+}
+
+template<typename T_SIGNATURE>
+std::vector<uint64_t>
+BottomKSignatureTest::bottomK(HashSet const & values) {
+	std::vector<uint64_t> result;
+	for(auto it = values.begin(); it != values.end() && result.size() < T_SIGNATURE::size; ++it) {
+		result.push_back(*it);
+	}
+	return result;
+}
+
+std::string
+BottomKSignatureTest::randomString(std::size_t minSize, std::size_t maxSize, char last) {
+	auto dc = std::uniform_int_distribution<int>('a', last);
+	auto ds = std::uniform_int_distribution<std::size_t>(minSize, maxSize);
+	std::string result;
+	for(std::size_t i(0), s(ds(m_g)); i < s; ++i) {
+		result += char(dc(m_g));
+	}
+	return result;
+}
+
+std::string
+BottomKSignatureTest::edit(std::string str, std::size_t count, char last) {
+	auto dc = std::uniform_int_distribution<int>('a', last);
+	auto dop = std::uniform_int_distribution<int>(0, 2);
+	for(std::size_t i(0); i < count; ++i) {
+		std::size_t pos = std::uniform_int_distribution<std::size_t>(0, str.size())(m_g);
+		int op = dop(m_g);
+		if (op == 0 || str.size() < 2) {
+			str.insert(str.begin()+pos, char(dc(m_g)));
+		}
+		else if (pos < str.size()) {
+			if (op == 1) {
+				str.erase(str.begin()+pos);
+			}
+			else {
+				str[pos] = char(dc(m_g));
+			}
+		}
+	}
+	return str;
+}
+
+std::size_t
+BottomKSignatureTest::editDistance(std::string const & a, std::string const & b) {
+	std::vector<std::size_t> d(b.size()+1);
+	for(std::size_t j(0); j <= b.size(); ++j) {
+		d[j] = j;
+	}
+	for(std::size_t i(1); i <= a.size(); ++i) {
+		std::size_t prev = d[0];
+		d[0] = i;
+		for(std::size_t j(1); j <= b.size(); ++j) {
+			std::size_t tmp = d[j];
+			d[j] = std::min({d[j]+1, d[j-1]+1, prev + (a[i-1] != b[j-1])});
+			prev = tmp;
+		}
+	}
+	return d[b.size()];
+}
+
+std::size_t
+BottomKSignatureTest::overlap(std::string const & a, std::string const & b, std::size_t q) {
+	std::map<std::string, std::size_t> counts;
+	for(std::string const & gram : QGram(a, q)) {
+		++counts[gram];
+	}
+	std::size_t result = 0;
+	for(std::string const & gram : QGram(b, q)) {
+		auto it = counts.find(gram);
+		if (it != counts.end() && it->second) {
+			--it->second;
+			++result;
+		}
+	}
+	return result;
+}
+
+template<typename T_ITERATOR>
+std::set<std::string>
+BottomKSignatureTest::qgrams(T_ITERATOR begin, T_ITERATOR end, std::size_t q) {
+	std::set<std::string> result;
+	for(; begin != end; ++begin) {
+		for(std::string const & gram : QGram(*begin, q)) {
+			result.insert(gram);
+		}
+	}
+	return result;
+}
+
+template<std::size_t T_SIZE>
+void
+BottomKSignatureTest::checkInsert() {
+	using Signature = BottomKSignature<T_SIZE>;
+	for(std::size_t i(0); i < test_count; ++i) {
+		HashSet values = randomSet(i % (3*T_SIZE), 4*T_SIZE);
+		Signature sig;
+		//insert in random order and with duplicates
+		std::vector<uint64_t> order(values.begin(), values.end());
+		order.insert(order.end(), values.begin(), values.end());
+		std::shuffle(order.begin(), order.end(), m_g);
+		for(uint64_t v : order) {
+			sig.insert(v);
+		}
+		sig.insert(Signature::Empty);
+		std::vector<uint64_t> want = bottomK<Signature>(values);
+		CPPUNIT_ASSERT_EQUAL(want.size(), sig.count());
+		CPPUNIT_ASSERT(std::equal(want.begin(), want.end(), sig.begin(), sig.end()));
+		CPPUNIT_ASSERT_EQUAL(values.size() >= T_SIZE, sig.full());
+		CPPUNIT_ASSERT_EQUAL(sig.full() ? want.back() : uint64_t(Signature::Empty), uint64_t(sig.threshold()));
+		CPPUNIT_ASSERT(sig == sketch<Signature>(values));
+	}
+}
+
+template<std::size_t T_SIZE>
+void
+BottomKSignatureTest::checkMerge() {
+	using Signature = BottomKSignature<T_SIZE>;
+	for(std::size_t i(0); i < test_count; ++i) {
+		//overlapping sets of sizes below and above T_SIZE
+		HashSet a = randomSet(i % (3*T_SIZE), 6*T_SIZE);
+		HashSet b = randomSet((i/3) % (3*T_SIZE), 6*T_SIZE);
+		HashSet u = a;
+		u.insert(b.begin(), b.end());
+		Signature want = sketch<Signature>(u);
+		Signature sa = sketch<Signature>(a);
+		Signature sb = sketch<Signature>(b);
+		CPPUNIT_ASSERT(want == sa + sb);
+		CPPUNIT_ASSERT(want == sb + sa);
+		Signature tmp = sa;
+		tmp += sb;
+		CPPUNIT_ASSERT(want == tmp);
+		CPPUNIT_ASSERT(sa == sa + Signature());
+		CPPUNIT_ASSERT(sa == sa + sa);
+		std::vector<Signature> sigs = {sa, Signature(), sb};
+		CPPUNIT_ASSERT(want == Signature::combine(sigs.begin(), sigs.end()));
+	}
+}
+
+template<std::size_t T_SIZE>
+void
+BottomKSignatureTest::checkContainment() {
+	using Signature = BottomKSignature<T_SIZE>;
+	for(std::size_t i(0); i < test_count; ++i) {
+		HashSet a = randomSet(i % (3*T_SIZE), 4*T_SIZE);
+		HashSet b = randomSet((i/3) % (3*T_SIZE), 4*T_SIZE);
+		Signature sa = sketch<Signature>(a);
+		Signature sb = sketch<Signature>(b);
+		//values of sa up to the threshold of sb and the ones of them that are in b
+		std::size_t found = 0;
+		std::size_t considered = 0;
+		for(uint64_t v : sa) {
+			if (v <= sb.threshold()) {
+				++considered;
+				found += b.count(v);
+			}
+		}
+		auto counts = sa.containment(sb);
+		CPPUNIT_ASSERT_EQUAL(found, counts.first);
+		CPPUNIT_ASSERT_EQUAL(considered, counts.second);
+		std::size_t common = 0;
+		for(uint64_t v : sa) {
+			common += std::count(sb.begin(), sb.end(), v);
+		}
+		CPPUNIT_ASSERT_EQUAL(common, sa / sb);
+		CPPUNIT_ASSERT_EQUAL(common, sb / sa);
+		//a set contains itself and its subsets
+		CPPUNIT_ASSERT_EQUAL(sa.count(), sa.containment(sa).first);
+		CPPUNIT_ASSERT_EQUAL(sa.count(), sa.containment(sa).second);
+		counts = sa.containment(sa + sb);
+		CPPUNIT_ASSERT_EQUAL(counts.second, counts.first);
+	}
+}
+
+void
+BottomKSignatureTest::insert() {
+	checkInsert<1>();
+	checkInsert<8>();
+	checkInsert<64>();
+}
+
+void
+BottomKSignatureTest::merge() {
+	checkMerge<1>();
+	checkMerge<8>();
+	checkMerge<64>();
+}
+
+void
+BottomKSignatureTest::containment() {
+	checkContainment<1>();
+	checkContainment<8>();
+	checkContainment<64>();
+}
+
+void
+BottomKSignatureTest::cardinality() {
+	using Signature = BottomKSignature<64>;
+	constexpr double range = 18446744073709551616.0;
+	for(std::size_t size : {std::size_t(1), std::size_t(10), std::size_t(63)}) {
+		HashSet values = randomSet(size, std::numeric_limits<uint64_t>::max());
+		CPPUNIT_ASSERT_EQUAL(double(values.size()), sketch<Signature>(values).cardinality(range));
+	}
+	for(std::size_t size : {std::size_t(100), std::size_t(1000), std::size_t(100000)}) {
+		double meanError = 0;
+		constexpr std::size_t trials = 50;
+		for(std::size_t i(0); i < trials; ++i) {
+			HashSet values = randomSet(size, std::numeric_limits<uint64_t>::max());
+			double estimate = sketch<Signature>(values).cardinality(range);
+			meanError += std::abs(estimate - double(values.size()))/values.size();
+		}
+		meanError /= trials;
+		//the relative standard error is about 1/sqrt(64-2)
+		CPPUNIT_ASSERT(meanError < 0.2);
+	}
+}
+
+void
+BottomKSignatureTest::noFalseNegatives() {
+	constexpr std::size_t q = 3;
+	Traits t(q);
+	//ref "aaa" has 5 q-grams of which 3 are distinct, "aba" shares 2 of them and is within edit distance 1
+	{
+		std::string strs[] = {"aba"};
+		CPPUNIT_ASSERT(t.mayHaveMatch("aaa", 1)(t.signature(strs, strs+1)));
+	}
+	std::size_t pruned = 0;
+	for(std::size_t i(0); i < test_count; ++i) {
+		//few short strings such that the sets have less than 64 distinct q-grams
+		char last = i % 2 ? 'b' : 'e';
+		std::vector<std::string> strs;
+		for(std::size_t j(0), s(1+i%4); j < s; ++j) {
+			strs.push_back(randomString(1, 8, last));
+		}
+		Traits::Signature ns = t.signature(strs.begin(), strs.end());
+		CPPUNIT_ASSERT(!ns.full());
+		CPPUNIT_ASSERT_EQUAL(qgrams(strs.begin(), strs.end(), q).size(), ns.count());
+		for(std::size_t j(0); j < 20; ++j) {
+			std::string ref = j < 10 ? edit(strs[j%strs.size()], j%3, last) : randomString(1, 10, last);
+			if (ref.empty()) {
+				continue;
+			}
+			std::size_t ed = std::numeric_limits<std::size_t>::max();
+			std::size_t common = 0;
+			for(std::string const & str : strs) {
+				ed = std::min(ed, editDistance(ref, str));
+				common = std::max(common, overlap(ref, str, q));
+			}
+			for(std::size_t k : {0, 1, 2}) {
+				bool result = t.mayHaveMatch(ref, k)(ns);
+				int64_t th = int64_t(ref.size() + q - 1) - int64_t(k*q);
+				if (ed <= k || int64_t(common) >= th) {
+					CPPUNIT_ASSERT(result);
+				}
+				pruned += !result;
+			}
+		}
+	}
+	//the test is not trivial
+	CPPUNIT_ASSERT(pruned > 0);
+}
+
+void
+BottomKSignatureTest::fullSketches() {
+	constexpr std::size_t q = 3;
+	Traits t(q);
+	for(std::size_t i(0); i < test_count/5; ++i) {
+		std::vector<std::string> strs;
+		for(std::size_t j(0); j < string_count; ++j) {
+			strs.push_back(randomString(5, 30));
+		}
+		std::vector<Traits::Signature> sigs;
+		for(std::string const & str : strs) {
+			sigs.push_back(t.signature(str));
+		}
+		Traits::Signature ns = t.combine()(sigs.begin(), sigs.end());
+		CPPUNIT_ASSERT(ns == t.signature(strs.begin(), strs.end()));
+		CPPUNIT_ASSERT(ns.full());
+		for(std::string const & str : strs) {
+			CPPUNIT_ASSERT(t.mayHaveMatch(str, 0)(ns));
+		}
+	}
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	srand( 0 );
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::BottomKSignatureTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
@@ -1,14 +1,28 @@
 #include "TestBase.h"
 #include <srtree/MinWiseSignature.h>
+#include <srtree/BBitMinWiseSignature.h>
+#include <srtree/MinWiseSignatureTraits.h>
+#include <srtree/BBitSerializationTraitsAdapter.h>
 #include <srtree/QGram.h>
 
 #include <random>
+#include <set>
+#include <algorithm>
 
 namespace srtree::tests {
 
 class MinWiseSignatureTest: public TestBase {
 CPPUNIT_TEST_SUITE( MinWiseSignatureTest );
 CPPUNIT_TEST( resemblence );
+CPPUNIT_TEST( multiplyShiftResemblence );
+CPPUNIT_TEST( kernels );
+CPPUNIT_TEST( linearCongruentialHash );
+CPPUNIT_TEST( onePermutation );
+CPPUNIT_TEST( bbit );
+CPPUNIT_TEST( bbitCardinality );
+CPPUNIT_TEST( cardinality );
+CPPUNIT_TEST( xxHash64 );
+CPPUNIT_TEST( evaluators );
 CPPUNIT_TEST_SUITE_END();
 public:
 	static constexpr std::size_t string_size = 10;
@@ -19,16 +33,44 @@ public:
 	void setUp() override;
 public:
 	void resemblence();
+	void multiplyShiftResemblence();
+	void kernels();
+	void linearCongruentialHash();
+	void onePermutation();
+	void bbit();
+	///The stored cardinality of b-bit signatures does not reject true matches of items and nodes
+	void bbitCardinality();
+	void cardinality();
+	void xxHash64();
+	void evaluators();
+private:
+	///Compare LinearCongruentialHash and the generator with the plain evaluation using modulo operations
+	template<std::size_t T_ENTRY_BITS>
+	void checkLinearCongruentialHash(std::size_t hashSize);
+	///Compare the HashEvaluator of the generator with the permutations evaluated one by one
+	template<typename T_HASH>
+	void checkEvaluator();
+	///Mean deviation of the estimated from the exact jaccard index of the q-grams of @param first and @param second
+	template<typename T_GENERATOR>
+	double estimationBias(T_GENERATOR const & g, std::size_t q);
+	///Compare the entries and operator/ of BBitMinWiseSignature with the full signatures
+	template<std::size_t T_BITS>
+	void checkBBit();
+	///Compare operator+, operator/ and combine with scalar loops
+	template<std::size_t T_SIZE, std::size_t T_ENTRY_BITS>
+	void checkKernels();
 private:
 	std::vector<std::string> m_strs;
 	MinWiseSignatureGenerator<56, 64> m_g;
+	MinWiseSignatureGenerator<56, 64, detail::MinWisePermutation::MultiplyShiftHash<64>> m_gms;
+	MinWiseSignatureGenerator<56, 64, detail::MinWisePermutation::OnePermutation<detail::MinWisePermutation::MultiplyShiftHash<64>>> m_goph;
 };
 
 void
 MinWiseSignatureTest::setUp() {
 	std::string base = "123456";
 	
-	auto dpos = std::uniform_int_distribution<std::size_t>(0, base.size());
+	auto dpos = std::uniform_int_distribution<std::size_t>(0, base.size()-1);
 	auto dsize = std::uniform_int_distribution<std::size_t>(5, string_size);
 	auto g = std::default_random_engine();
 	for(std::size_t i(0); i < string_count; ++i) {
@@ -61,6 +103,358 @@ MinWiseSignatureTest::resemblence() {
 	}
 }
 
+void
+MinWiseSignatureTest::multiplyShiftResemblence() {
+	for(std::string const & str : m_strs) {
+		QGram qg(str, 2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(56), m_gms(qg.begin(), qg.end())/m_gms(qg.begin(), qg.end()));
+	}
+	for(std::size_t q(1); q < 4; ++q) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, estimationBias(m_gms, q), 0.05);
+	}
+}
+
+template<typename T_GENERATOR>
+double
+MinWiseSignatureTest::estimationBias(T_GENERATOR const & g, std::size_t q) {
+	auto grams = [q](std::string const & str) {
+		QGram qg(str, q);
+		std::set<std::string> result;
+		for(auto it(qg.begin()), end(qg.end()); it != end; ++it) {
+			result.insert(*it);
+		}
+		return result;
+	};
+	double bias = 0;
+	for(std::size_t i(1); i < m_strs.size(); ++i) {
+		std::string const & str1 = m_strs.at(i-1);
+		std::string const & str2 = m_strs.at(i);
+		auto g1 = grams(str1);
+		auto g2 = grams(str2);
+		std::vector<std::string> is;
+		std::set_intersection(g1.begin(), g1.end(), g2.begin(), g2.end(), std::back_inserter(is));
+		double jaccard = double(is.size())/(g1.size()+g2.size()-is.size());
+		auto sig1 = g(g1.begin(), g1.end());
+		auto sig2 = g(g2.begin(), g2.end());
+		bias += double(sig1/sig2)/T_GENERATOR::SignatureSize - jaccard;
+	}
+	return bias/(m_strs.size()-1);
+}
+
+void
+MinWiseSignatureTest::kernels() {
+	checkKernels<56, 8>();
+	checkKernels<13, 8>();
+	checkKernels<56, 16>();
+	checkKernels<56, 32>();
+	checkKernels<56, 64>();
+	checkKernels<7, 64>();
+	checkKernels<7, 128>();
+}
+
+template<std::size_t T_SIZE, std::size_t T_ENTRY_BITS>
+void
+MinWiseSignatureTest::checkKernels() {
+	using Signature = MinWiseSignature<T_SIZE, T_ENTRY_BITS>;
+	using entry_type = typename Signature::entry_type;
+	auto g = std::default_random_engine();
+	//few distinct values to get equal entries
+	auto d = std::uniform_int_distribution<uint64_t>(0, 3);
+	auto random = [&]() {
+		Signature sig;
+		for(entry_type & x : sig) {
+			x = entry_type(d(g)) << (T_ENTRY_BITS-2);
+		}
+		return sig;
+	};
+	for(std::size_t i(0); i < 1000; ++i) {
+		std::vector<Signature> sigs;
+		for(std::size_t j(0), s(1+i%7); j < s; ++j) {
+			sigs.push_back(random());
+		}
+		Signature const & a = sigs.front();
+		Signature const & b = sigs.back();
+		std::size_t eq = 0;
+		for(std::size_t j(0); j < T_SIZE; ++j) {
+			eq += a.at(j) == b.at(j);
+		}
+		CPPUNIT_ASSERT_EQUAL(eq, a/b);
+		Signature ab = a+b;
+		Signature all = Signature::combine(sigs.begin(), sigs.end());
+		for(std::size_t j(0); j < T_SIZE; ++j) {
+			CPPUNIT_ASSERT(ab.at(j) == std::min(a.at(j), b.at(j)));
+			entry_type m = std::numeric_limits<entry_type>::max();
+			for(Signature const & sig : sigs) {
+				m = std::min(m, sig.at(j));
+			}
+			CPPUNIT_ASSERT(all.at(j) == m);
+		}
+	}
+}
+
+void
+MinWiseSignatureTest::linearCongruentialHash() {
+	for(std::size_t hashSize(1); hashSize < 5; ++hashSize) {
+		checkLinearCongruentialHash<32>(hashSize);
+		checkLinearCongruentialHash<64>(hashSize);
+	}
+}
+
+template<std::size_t T_ENTRY_BITS>
+void
+MinWiseSignatureTest::checkLinearCongruentialHash(std::size_t hashSize) {
+	using Hash = detail::MinWisePermutation::LinearCongruentialHash<T_ENTRY_BITS>;
+	using size_type = typename Hash::size_type;
+	using computation_type = __uint128_t;
+	using Generator = MinWiseSignatureGenerator<56, T_ENTRY_BITS, Hash>;
+	auto evaluate = [](Hash const & h, computation_type x) {
+		computation_type p = h.prime();
+		computation_type result = h.coefficients().front();
+		for(std::size_t i(1); i < h.coefficients().size(); ++i) {
+			result = (result*x % p + h.coefficients()[i]) % p;
+		}
+		return size_type(result);
+	};
+	auto convert = [](Hash const & h, std::string const & str) {
+		computation_type result = 0;
+		for(auto it(str.rbegin()), end(str.rend()); it != end; ++it) {
+			result = ((result << 8) + uint8_t(*it)) % h.prime();
+		}
+		return result;
+	};
+	Generator g(hashSize);
+	std::vector<std::string> strs = m_strs;
+	strs.emplace_back();
+	strs.emplace_back("\xff\xfe\xfd\xfc\xfb\xfa\xf9\xf8\xf7\xf6\xf5\xf4\xf3\xf2\xf1\xf0\xef");
+	strs.emplace_back(200, '\xff');
+	for(std::string const & str : strs) {
+		auto sig = g(str);
+		for(std::size_t i(0); i < 56; ++i) {
+			Hash const & h = g.permutations().at(i);
+			size_type expected = evaluate(h, convert(h, str));
+			CPPUNIT_ASSERT(expected == h(str));
+			CPPUNIT_ASSERT(expected == sig.at(i));
+			detail::MinWisePermutation::Converter<T_ENTRY_BITS, std::string> converter(h.prime());
+			CPPUNIT_ASSERT(convert(h, str) == converter(str));
+		}
+	}
+	auto gen = std::default_random_engine();
+	auto d = std::uniform_int_distribution<size_type>();
+	Hash const & h = g.permutations().front();
+	for(std::size_t i(0); i < 1000; ++i) {
+		size_type x = i < 2 ? std::numeric_limits<size_type>::max()-i : d(gen);
+		CPPUNIT_ASSERT(evaluate(h, x) == h(x));
+	}
+}
+
+void
+MinWiseSignatureTest::onePermutation() {
+	for(std::string const & str : m_strs) {
+		QGram qg(str, 2);
+		auto sig = m_goph(qg.begin(), qg.end());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(56), sig/m_goph(qg.begin(), qg.end()));
+		//every q-gram sets the minimum of its bin, all other bins are densified
+		for(auto it(qg.begin()), end(qg.end()); it != end; ++it) {
+			auto h = m_goph.hash()(*it);
+			CPPUNIT_ASSERT(sig.at(m_goph.bin(h)) <= h);
+		}
+		for(auto x : sig) {
+			CPPUNIT_ASSERT(x != std::numeric_limits<decltype(x)>::max());
+		}
+		auto h = m_goph.hash()(str);
+		for(auto x : m_goph(str)) {
+			CPPUNIT_ASSERT(x == h);
+		}
+	}
+	for(std::size_t q(1); q < 4; ++q) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, estimationBias(m_goph, q), 0.05);
+	}
+}
+
+void
+MinWiseSignatureTest::bbit() {
+	checkBBit<1>();
+	checkBBit<2>();
+	checkBBit<4>();
+	checkBBit<8>();
+}
+
+template<std::size_t T_BITS>
+void
+MinWiseSignatureTest::checkBBit() {
+	using BBitSignature = BBitMinWiseSignature<56, T_BITS>;
+	double bias = 0;
+	for(std::size_t i(1); i < m_strs.size(); ++i) {
+		QGram qg1(m_strs.at(i-1), 2);
+		QGram qg2(m_strs.at(i), 2);
+		auto sig1 = m_g(qg1.begin(), qg1.end());
+		auto sig2 = m_g(qg2.begin(), qg2.end());
+		BBitSignature bsig1(sig1, qg1.size());
+		BBitSignature bsig2(sig2, qg2.size());
+		CPPUNIT_ASSERT(sig1 == bsig1);
+		CPPUNIT_ASSERT(sig2 == bsig2);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(qg1.size()), bsig1.cardinality());
+		std::size_t eq = 0;
+		for(std::size_t j(0); j < 56; ++j) {
+			CPPUNIT_ASSERT_EQUAL(uint32_t(sig1.at(j) % (1 << T_BITS)), uint32_t(bsig1.at(j)));
+			eq += bsig1.at(j) == bsig2.at(j);
+		}
+		CPPUNIT_ASSERT_EQUAL(eq, bsig1/bsig2);
+		CPPUNIT_ASSERT(sig1/sig2 <= bsig1/bsig2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(56), bsig1/bsig1);
+		//collision corrected estimate
+		double c = BBitSignature::collisionProbability();
+		bias += (double(bsig1/bsig2)/56 - c)/(1-c) - double(sig1/sig2)/56;
+	}
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, bias/(m_strs.size()-1), 0.1);
+}
+
+void
+MinWiseSignatureTest::bbitCardinality() {
+	using BaseTraits = srtree::detail::MinWiseSignatureTraits<56, detail::MinWisePermutation::LinearCongruentialHash<64>>;
+	using Traits = srtree::detail::BBitSerializationTraitsAdapter<BaseTraits, 4>;
+	using StaticTraits = Traits::StaticTraits;
+	using BBitSignature = StaticTraits::Signature;
+	constexpr std::size_t q = 3;
+	Traits t(q);
+	sserialize::UByteArrayAdapter td(sserialize::MM_PROGRAM_MEMORY);
+	td << t;
+	StaticTraits st(td);
+	auto g = std::default_random_engine();
+	auto dsize = std::uniform_int_distribution<std::size_t>(1, 20);
+	auto dpos = std::uniform_int_distribution<std::size_t>(0, 1000);
+	auto randomString = [&](char last) {
+		auto dc = std::uniform_int_distribution<int>('a', last);
+		std::string result;
+		for(std::size_t i(0), s(dsize(g)); i < s; ++i) {
+			result += char(dc(g));
+		}
+		return result;
+	};
+	for(std::size_t i(0); i < 2000; ++i) {
+		//single items and small nodes, few characters give repeated q-grams
+		char last = i % 2 ? 'b' : 'f';
+		std::vector<std::string> strs;
+		for(std::size_t j(0), s(i % 3 ? 1 : 1+i%7); j < s; ++j) {
+			strs.push_back(randomString(last));
+		}
+		std::set<std::string> grams;
+		for(std::string const & str : strs) {
+			for(std::string const & gram : QGram(str, q)) {
+				grams.insert(gram);
+			}
+		}
+		Traits::Signature sig = t.signature(strs.begin(), strs.end());
+		sserialize::UByteArrayAdapter d(sserialize::MM_PROGRAM_MEMORY);
+		t.serializer()(d, sig);
+		BBitSignature ns(d);
+		CPPUNIT_ASSERT(ns.cardinality() >= grams.size());
+		BBitSignature exact(sig, grams.size());
+		//strings within the edit distance of an item match the stored signature if they match the one with the exact cardinality
+		for(std::size_t j(0); j < 10; ++j) {
+			std::string ref = strs.at(j % strs.size());
+			std::size_t ed = j % 3;
+			for(std::size_t k(0); k < ed && ref.size() > 1; ++k) {
+				std::size_t pos = dpos(g) % ref.size();
+				if (k % 2) {
+					ref.erase(ref.begin()+pos);
+				}
+				else {
+					ref[pos] = char(std::uniform_int_distribution<int>('a', last)(g));
+				}
+			}
+			for(std::size_t editDistance(ed); editDistance <= 2; ++editDistance) {
+				auto mhm = st.mayHaveMatch(ref, editDistance);
+				if (mhm(exact)) {
+					CPPUNIT_ASSERT(mhm(ns));
+				}
+			}
+		}
+	}
+}
+
+void
+MinWiseSignatureTest::cardinality() {
+	auto gen = std::default_random_engine();
+	auto d = std::uniform_int_distribution<uint64_t>();
+	for(std::size_t n : {10, 100, 10000}) {
+		std::vector<std::string> strs;
+		for(std::size_t i(0); i < n; ++i) {
+			strs.push_back(std::to_string(d(gen)));
+		}
+		double lcg = m_g.cardinality(m_g(strs.begin(), strs.end()));
+		double ms = m_gms.cardinality(m_gms(strs.begin(), strs.end()));
+		double oph = m_goph.cardinality(m_goph(strs.begin(), strs.end()));
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, lcg/n, 0.5);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, ms/n, 0.5);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, oph/n, 0.5);
+	}
+}
+
+void
+MinWiseSignatureTest::xxHash64() {
+	using Hash = detail::MinWisePermutation::XXHash64;
+	//reference values of the xxHash library
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0xEF46DB3751D8E999ull), Hash(0)(std::string()));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0xD24EC4F1A98C6E5Bull), Hash(0)(std::string("a")));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x44BC2CF5AD770999ull), Hash(0)(std::string("abc")));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x1561B8F75328FE71ull), Hash(7)(std::string("abcdefgh")));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x04BFE37E79456920ull), Hash(0xFFFFFFFFFFFFFFFFull)(std::string("abcdefghijkl")));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x0050FDEDCF288068ull), Hash(12345)(std::string("0123456789abcdefghijklmnopqrstuvwxyz")));
+	std::string bytes;
+	for(int i(0); i < 100; ++i) {
+		bytes += char(i);
+	}
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x819D2B726001D507ull), Hash(42)(bytes));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x80D18065BE7277A5ull), Hash(99)(uint64_t(0x0123456789ABCDEFull)));
+	
+	MinWiseSignatureGenerator<56, 64, Hash> g(2);
+	for(std::string const & str : m_strs) {
+		QGram qg(str, 2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(56), g(qg.begin(), qg.end())/g(qg.begin(), qg.end()));
+	}
+	for(std::size_t q(1); q < 4; ++q) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, estimationBias(g, q), 0.05);
+	}
+}
+
+void
+MinWiseSignatureTest::evaluators() {
+	using namespace detail::MinWisePermutation;
+	checkEvaluator< LinearCongruentialHash<32> >();
+	checkEvaluator< LinearCongruentialHash<64> >();
+	checkEvaluator< MultiplyShiftHash<32> >();
+	checkEvaluator< MultiplyShiftHash<64> >();
+	checkEvaluator< XXHash64 >();
+}
+
+template<typename T_HASH>
+void
+MinWiseSignatureTest::checkEvaluator() {
+	using Generator = MinWiseSignatureGenerator<56, T_HASH::entry_bits, T_HASH>;
+	Generator g(3);
+	std::vector<std::string> strs = m_strs;
+	strs.emplace_back();
+	strs.emplace_back(200, '\xff');
+	for(std::string const & str : strs) {
+		auto sig = g(str);
+		for(std::size_t i(0); i < 56; ++i) {
+			CPPUNIT_ASSERT(g.permutations().at(i)(str) == sig.at(i));
+		}
+	}
+	auto gen = std::default_random_engine();
+	auto d = std::uniform_int_distribution<uint64_t>();
+	for(std::size_t j(0); j < 1000; ++j) {
+		uint64_t x = j < 2 ? std::numeric_limits<uint64_t>::max()-j : d(gen);
+		auto sig = g(x);
+		auto sig32 = g(uint32_t(x));
+		for(std::size_t i(0); i < 56; ++i) {
+			CPPUNIT_ASSERT(g.permutations().at(i)(x) == sig.at(i));
+			CPPUNIT_ASSERT(g.permutations().at(i)(uint32_t(x)) == sig32.at(i));
+		}
+	}
+}
+
 } // end namespace srtree::tests
 
 int main(int argc, char ** argv) {
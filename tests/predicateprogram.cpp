@@ -0,0 +1,211 @@
+#include "TestBase.h"
+#include <srtree/PredicateProgram.h>
+
+#include <random>
+#include <memory>
+#include <thread>
+#include <array>
+
+namespace srtree::tests {
+
+class PredicateProgramTest: public TestBase {
+CPPUNIT_TEST_SUITE( PredicateProgramTest );
+CPPUNIT_TEST( shapes );
+CPPUNIT_TEST( mixed );
+CPPUNIT_TEST( random );
+CPPUNIT_TEST( shared );
+CPPUNIT_TEST( concurrentCompile );
+CPPUNIT_TEST_SUITE_END();
+public:
+	static constexpr std::size_t test_count = 20000;
+	static constexpr uint32_t leaf_count = 8;
+	static constexpr uint32_t max_depth = 6;
+	using Program = srtree::detail::PredicateProgram<uint32_t>;
+	using Shape = Program::Shape;
+public:
+	PredicateProgramTest() {}
+public:
+	void setUp() override;
+public:
+	void shapes();
+	///(a && b) || (c && d) for all leaf values
+	void mixed();
+	///Random expressions compared with their recursive evaluation
+	void random();
+	///Combining programs does not change the programs they are made of
+	void shared();
+	///The first evaluations of a program run concurrently
+	void concurrentCompile();
+private:
+	///Reference expression, evaluated recursively
+	struct Expression {
+		enum Op {LEAF, AND, OR};
+		Op op;
+		uint32_t leaf;
+		std::shared_ptr<Expression> first;
+		std::shared_ptr<Expression> second;
+	};
+	using ExpressionPtr = std::shared_ptr<Expression>;
+private:
+	std::pair<ExpressionPtr, Program> randomExpression(uint32_t depth);
+	///@return the value of @param e for leaf values given by the bits of @param values, the evaluated leaves are appended to @param order
+	static bool evaluate(Expression const & e, uint32_t values, std::vector<uint32_t> & order);
+	///Compare @param p with @param e for all leaf values
+	static void check(Expression const & e, Program const & p);
+private:
+	std::default_random_engine m_g;
+};
+
+void
+PredicateProgramTest::setUp() {
+	m_g = std::default_random_engine();
+}
+
+std::pair<PredicateProgramTest::ExpressionPtr, PredicateProgramTest::Program>
+PredicateProgramTest::randomExpression(uint32_t depth) {
+	auto d = std::uniform_int_distribution<uint32_t>(0, 2);
+	if (!depth || !d(m_g)) {
+		uint32_t leaf = std::uniform_int_distribution<uint32_t>(0, leaf_count-1)(m_g);
+		return std::make_pair(std::make_shared<Expression>(Expression{Expression::LEAF, leaf, nullptr, nullptr}), Program(leaf));
+	}
+	auto first = randomExpression(depth-1);
+	auto second = randomExpression(depth-1);
+	if (d(m_g) % 2) {
+		return std::make_pair(
+			std::make_shared<Expression>(Expression{Expression::AND, 0, first.first, second.first}),
+			first.second / second.second
+		);
+	}
+	else {
+		return std::make_pair(
+			std::make_shared<Expression>(Expression{Expression::OR, 0, first.first, second.first}),
+			first.second + second.second
+		);
+	}
+}
+
+bool
+PredicateProgramTest::evaluate(Expression const & e, uint32_t values, std::vector<uint32_t> & order) {
+	switch (e.op) {
+	case Expression::AND:
+		return evaluate(*e.first, values, order) && evaluate(*e.second, values, order);
+	case Expression::OR:
+		return evaluate(*e.first, values, order) || evaluate(*e.second, values, order);
+	case Expression::LEAF:
+	default:
+		order.push_back(e.leaf);
+		return (values >> e.leaf) & 1;
+	}
+}
+
+void
+PredicateProgramTest::check(Expression const & e, Program const & p) {
+	for(uint32_t values(0); values < (uint32_t(1) << leaf_count); ++values) {
+		std::vector<uint32_t> want, got;
+		bool result = p([&got, values](uint32_t leaf) {
+			got.push_back(leaf);
+			return bool((values >> leaf) & 1);
+		});
+		CPPUNIT_ASSERT_EQUAL(evaluate(e, values, want), result);
+		CPPUNIT_ASSERT(want == got);
+	}
+}
+
+void
+PredicateProgramTest::shapes() {
+	Program a(0), b(1), c(2), d(3);
+	CPPUNIT_ASSERT(a.shape() == Shape::LEAF);
+	CPPUNIT_ASSERT(((a / b) / (c / d)).shape() == Shape::CONJUNCTION);
+	CPPUNIT_ASSERT(((a + b) + (c + d)).shape() == Shape::DISJUNCTION);
+	CPPUNIT_ASSERT(((a / b) + c).shape() == Shape::GENERIC);
+	CPPUNIT_ASSERT(((a + b) / c).shape() == Shape::GENERIC);
+	CPPUNIT_ASSERT_EQUAL(std::size_t(4), ((a / b) + (c / d)).size());
+}
+
+void
+PredicateProgramTest::mixed() {
+	auto leaf = [](uint32_t l) {
+		return std::make_shared<Expression>(Expression{Expression::LEAF, l, nullptr, nullptr});
+	};
+	auto ab = std::make_shared<Expression>(Expression{Expression::AND, 0, leaf(0), leaf(1)});
+	auto cd = std::make_shared<Expression>(Expression{Expression::AND, 0, leaf(2), leaf(3)});
+	Expression e{Expression::OR, 0, ab, cd};
+	Program p = (Program(0) / Program(1)) + (Program(2) / Program(3));
+	CPPUNIT_ASSERT(p.shape() == Shape::GENERIC);
+	check(e, p);
+	//the same leaf may occur more than once
+	Expression e2{Expression::AND, 0, std::make_shared<Expression>(e), std::make_shared<Expression>(Expression{Expression::OR, 0, leaf(3), leaf(0)})};
+	Program p2 = p / (Program(3) + Program(0));
+	check(e2, p2);
+}
+
+void
+PredicateProgramTest::random() {
+	std::array<std::size_t, 4> shapeCounts{0, 0, 0, 0};
+	for(std::size_t i(0); i < test_count; ++i) {
+		auto x = randomExpression(1+i%max_depth);
+		shapeCounts[int(x.second.shape())] += 1;
+		check(*x.first, x.second);
+	}
+	for(std::size_t count : shapeCounts) {
+		CPPUNIT_ASSERT(count > 0);
+	}
+}
+
+void
+PredicateProgramTest::shared() {
+	for(std::size_t i(0); i < test_count/10; ++i) {
+		auto x = randomExpression(max_depth);
+		auto y = randomExpression(max_depth);
+		//evaluate the parts first such that their compiled programs exist before they are combined
+		check(*x.first, x.second);
+		check(*y.first, y.second);
+		Program conj = x.second / y.second;
+		Program disj = x.second + y.second;
+		check(Expression{Expression::AND, 0, x.first, y.first}, conj);
+		check(Expression{Expression::OR, 0, x.first, y.first}, disj);
+		check(*x.first, x.second);
+		check(*y.first, y.second);
+		//copies share the compiled program
+		Program copy = conj;
+		check(Expression{Expression::AND, 0, x.first, y.first}, copy);
+	}
+}
+
+void
+PredicateProgramTest::concurrentCompile() {
+	constexpr std::size_t threadCount = 4;
+	for(std::size_t i(0); i < 100; ++i) {
+		auto x = randomExpression(max_depth);
+		std::vector<std::vector<bool>> results(threadCount);
+		std::vector<std::thread> threads;
+		for(std::size_t t(0); t < threadCount; ++t) {
+			threads.emplace_back([&x, &results, t]() {
+				for(uint32_t values(0); values < (uint32_t(1) << leaf_count); ++values) {
+					results[t].push_back(x.second([values](uint32_t leaf) { return bool((values >> leaf) & 1); }));
+				}
+			});
+		}
+		for(std::thread & t : threads) {
+			t.join();
+		}
+		for(uint32_t values(0); values < (uint32_t(1) << leaf_count); ++values) {
+			std::vector<uint32_t> order;
+			bool want = evaluate(*x.first, values, order);
+			for(std::size_t t(0); t < threadCount; ++t) {
+				CPPUNIT_ASSERT_EQUAL(want, bool(results[t][values]));
+			}
+		}
+	}
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	srand( 0 );
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::PredicateProgramTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
@@ -3,12 +3,14 @@
 #include <srtree/QGram.h>
 
 #include <random>
+#include <map>
 
 namespace srtree::tests {
 
 class QGramTest: public TestBase {
 CPPUNIT_TEST_SUITE( QGramTest );
 CPPUNIT_TEST( bound );
+CPPUNIT_TEST( fingerprints );
 CPPUNIT_TEST_SUITE_END();
 public:
 	static constexpr std::size_t string_size = 10;
@@ -19,6 +21,7 @@ public:
 	void setUp() override;
 public:
 	void bound();
+	void fingerprints();
 private:
 	std::vector<std::string> m_strs;
 };
@@ -56,6 +59,26 @@ QGramTest::bound() {
 	}
 }
 
+void
+QGramTest::fingerprints() {
+	std::map<QGramFingerprints::value_type, std::string> grams;
+	for(std::string const & str : m_strs) {
+		for(std::size_t q(1); q < 8; ++q) {
+			QGram qg(str, q);
+			QGramFingerprints qf(str, q);
+			CPPUNIT_ASSERT_EQUAL(qg.size(), qf.size());
+			std::size_t i = 0;
+			for(auto it(qf.begin()), end(qf.end()); it != end; ++it, ++i) {
+				CPPUNIT_ASSERT(i < qg.size());
+				CPPUNIT_ASSERT_EQUAL(QGramFingerprints::fingerprint(qg.at(i)), *it);
+				auto x = grams.emplace(*it, qg.at(i));
+				CPPUNIT_ASSERT_EQUAL(x.first->second, qg.at(i));
+			}
+			CPPUNIT_ASSERT_EQUAL(qg.size(), i);
+		}
+	}
+}
+
 } // end namespace srtree::tests
 
 int main(int argc, char ** argv) {
@@ -0,0 +1,285 @@
+#include "TestBase.h"
+#include <srtree/QGramDB.h>
+#include <srtree/QGram.h>
+
+#include <random>
+#include <algorithm>
+
+namespace srtree::tests {
+
+class QGramMapTest: public TestBase {
+CPPUNIT_TEST_SUITE( QGramMapTest );
+CPPUNIT_TEST( packing );
+CPPUNIT_TEST( grow );
+CPPUNIT_TEST( batches );
+CPPUNIT_TEST( pqgramdb );
+CPPUNIT_TEST_SUITE_END();
+public:
+	using QGramMap = srtree::detail::PQGramDB::QGramMap;
+	static constexpr std::size_t string_count = 5000;
+	static constexpr std::size_t grow_count = 200000;
+public:
+	QGramMapTest() {}
+public:
+	void setUp() override;
+public:
+	///Packed and string grams: null bytes, UTF-8, grams of 8 and more bytes
+	void packing();
+	///Packed grams across many resizes of the tables
+	void grow();
+	///insert(std::vector<Batch>) compared with sequential inserts, ids only depend on the batches
+	void batches();
+	///PQGramDB::insert(std::vector<std::string>) compared with repeated insert(std::string)
+	void pqgramdb();
+private:
+	///Random string of ascii characters, multi-byte UTF-8 characters and occasional null bytes
+	std::string randomString(std::size_t minSize, std::size_t maxSize);
+	static std::vector<std::string> grams(std::string const & str, std::size_t q);
+	///Fill @param map with the grams of @param strs in @param batchCount batches
+	static void insert(QGramMap & map, std::vector<std::string> const & strs, std::size_t q, std::size_t batchCount);
+	///The ids of @param map are [0, size()) and at() and count() agree with toVector()
+	static void checkDense(QGramMap const & map);
+	static std::vector<std::string> keys(QGramMap const & map);
+private:
+	std::default_random_engine m_g;
+};
+
+void
+QGramMapTest::setUp() {
+	m_g = std::default_random_engine();
+}
+
+std::string
+QGramMapTest::randomString(std::size_t minSize, std::size_t maxSize) {
+	std::vector<std::string> alphabet = {"a", "b", "c", "d", "e", "\xc3\xa4", "\xe2\x82\xac", "\xff"};
+	auto dc = std::uniform_int_distribution<std::size_t>(0, alphabet.size()-1);
+	auto ds = std::uniform_int_distribution<std::size_t>(minSize, maxSize);
+	auto dnull = std::bernoulli_distribution(0.02);
+	std::string result;
+	for(std::size_t i(0), s(ds(m_g)); i < s; ++i) {
+		if (dnull(m_g)) {
+			result.push_back('\0');
+		}
+		else {
+			result += alphabet[dc(m_g)];
+		}
+	}
+	return result;
+}
+
+std::vector<std::string>
+QGramMapTest::grams(std::string const & str, std::size_t q) {
+	QGram qg(str, q);
+	std::vector<std::string> result;
+	for(std::size_t i(0), s(qg.size()); i < s; ++i) {
+		result.push_back(qg.at(i));
+	}
+	return result;
+}
+
+void
+QGramMapTest::insert(QGramMap & map, std::vector<std::string> const & strs, std::size_t q, std::size_t batchCount) {
+	std::vector<QGramMap::Batch> batches(batchCount, QGramMap::Batch(map));
+	for(std::size_t i(0), s(strs.size()); i < s; ++i) {
+		auto & batch = batches.at(i*batchCount/s);
+		for(std::string const & gram : grams(strs[i], q)) {
+			batch.add(gram.data(), gram.size());
+		}
+	}
+	map.insert(batches);
+}
+
+void
+QGramMapTest::checkDense(QGramMap const & map) {
+	std::vector<QGramMap::value_type> values = map.toVector();
+	CPPUNIT_ASSERT_EQUAL(map.size(), values.size());
+	std::vector<bool> seen(map.size(), false);
+	for(QGramMap::value_type const & x : values) {
+		CPPUNIT_ASSERT(x.second < map.size());
+		CPPUNIT_ASSERT(!seen[x.second]);
+		seen[x.second] = true;
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), map.count(x.first));
+		CPPUNIT_ASSERT_EQUAL(x.second, map.at(x.first));
+	}
+}
+
+std::vector<std::string>
+QGramMapTest::keys(QGramMap const & map) {
+	std::vector<std::string> result;
+	for(QGramMap::value_type const & x : map.toVector()) {
+		result.push_back(x.first);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+void
+QGramMapTest::packing() {
+	using namespace std::string_literals;
+	std::vector<std::string> grams = {
+		"a", "ab", "abcdefgh", "abcdefghi", "abcdefghijklmnopqrst",
+		"\0"s, "a\0"s, "\0a"s, "ab\0cd"s, "abcdefg\0"s, "\0\0\0\0\0\0\0\0\0"s,
+		"\xc3\xa4", "\xc3\xa4\xc3\xa4\xc3\xa4\xc3\xa4", "\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac",
+		"\xff\xff\xff\xff\xff\xff\xff\xff", "\xff\xff\xff\xff\xff\xff\xff\xff\xff",
+		""
+	};
+	QGramMap map;
+	for(std::size_t i(0); i < grams.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), map.count(grams[i]));
+		CPPUNIT_ASSERT_EQUAL(uint32_t(i), map.insert(grams[i].data(), grams[i].size()));
+		CPPUNIT_ASSERT_EQUAL(i+1, map.size());
+	}
+	//the first gram keeps id 0
+	for(std::size_t i(0); i < grams.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL(uint32_t(i), map.insert(grams[i].data(), grams[i].size()));
+		CPPUNIT_ASSERT_EQUAL(uint32_t(i), map.at(grams[i]));
+	}
+	CPPUNIT_ASSERT_EQUAL(grams.size(), map.size());
+	checkDense(map);
+	//the bytes of the grams survive packing
+	std::vector<QGramMap::value_type> values = map.toVector();
+	std::sort(values.begin(), values.end(), [](auto const & a, auto const & b) { return a.second < b.second; });
+	for(std::size_t i(0); i < grams.size(); ++i) {
+		CPPUNIT_ASSERT(grams[i] == values[i].first);
+	}
+	for(std::string gram : {"b"s, "a\0\0"s, "abcdefghij"s, "\xc3"s, "\xe2\x82\xac"s}) {
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), map.count(gram));
+		CPPUNIT_ASSERT_THROW(map.at(gram), std::out_of_range);
+	}
+}
+
+void
+QGramMapTest::grow() {
+	//distinct packed grams of 1 to 3 bytes without null bytes
+	auto gram = [](std::size_t i) {
+		std::string result;
+		for(; i; i /= 255) {
+			result.push_back(char(1 + i%255));
+		}
+		return result;
+	};
+	QGramMap map;
+	for(std::size_t i(1); i <= grow_count; ++i) {
+		std::string g = gram(i);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(i-1), map.insert(g.data(), g.size()));
+		//known grams are found while the tables are resized
+		if ((i & (i-1)) == 0) {
+			std::string first = gram(1);
+			CPPUNIT_ASSERT_EQUAL(uint32_t(0), map.insert(first.data(), first.size()));
+			CPPUNIT_ASSERT_EQUAL(i, map.size());
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(grow_count, map.size());
+	for(std::size_t i(1); i <= grow_count; ++i) {
+		CPPUNIT_ASSERT_EQUAL(uint32_t(i-1), map.at(gram(i)));
+	}
+	checkDense(map);
+}
+
+void
+QGramMapTest::batches() {
+	for(std::size_t q : {1, 3, 8, 10}) {
+		std::vector<std::string> first, second;
+		for(std::size_t i(0); i < string_count; ++i) {
+			first.push_back(randomString(0, 12));
+			second.push_back(randomString(0, 12));
+		}
+		QGramMap ref;
+		for(std::vector<std::string> const * strs : {&first, &second}) {
+			for(std::string const & str : *strs) {
+				for(std::string const & g : grams(str, q)) {
+					ref.insert(g.data(), g.size());
+				}
+			}
+		}
+		checkDense(ref);
+		for(std::size_t batchCount : {1, 3, 7, 64}) {
+			QGramMap map;
+			insert(map, first, q, batchCount);
+			checkDense(map);
+			std::vector<QGramMap::value_type> firstValues = map.toVector();
+			//a second round keeps the existing ids and continues at size()
+			insert(map, second, q, batchCount);
+			checkDense(map);
+			CPPUNIT_ASSERT_EQUAL(ref.size(), map.size());
+			CPPUNIT_ASSERT(keys(ref) == keys(map));
+			for(QGramMap::value_type const & x : firstValues) {
+				CPPUNIT_ASSERT_EQUAL(x.second, map.at(x.first));
+			}
+			std::vector<QGramMap::value_type> values = map.toVector();
+			std::sort(values.begin(), values.end());
+			//reinserting known grams changes nothing
+			insert(map, first, q, batchCount);
+			std::vector<QGramMap::value_type> again = map.toVector();
+			std::sort(again.begin(), again.end());
+			CPPUNIT_ASSERT(values == again);
+			//the ids only depend on the batches, not on the order in which the shards are filled
+			QGramMap other;
+			insert(other, first, q, batchCount);
+			insert(other, second, q, batchCount);
+			std::vector<QGramMap::value_type> otherValues = other.toVector();
+			std::sort(otherValues.begin(), otherValues.end());
+			CPPUNIT_ASSERT(values == otherValues);
+		}
+	}
+}
+
+void
+QGramMapTest::pqgramdb() {
+	for(std::size_t q : {1, 3, 8, 10}) {
+		std::vector<std::string> strs;
+		for(std::size_t i(0); i < string_count; ++i) {
+			strs.push_back(randomString(0, 12));
+		}
+		PQGramDB parallel(q), parallel2(q), sequential(q);
+		parallel.insert(strs);
+		parallel2.insert(strs);
+		for(std::string const & str : strs) {
+			sequential.insert(str);
+		}
+		std::vector<std::string> all;
+		for(std::string const & str : strs) {
+			for(std::string const & g : grams(str, q)) {
+				all.push_back(g);
+			}
+		}
+		std::sort(all.begin(), all.end());
+		all.erase(std::unique(all.begin(), all.end()), all.end());
+		for(PQGramDB const * db : {&parallel, &sequential}) {
+			//every gram has its own id in [0, number of grams)
+			std::vector<uint32_t> ids;
+			for(std::string const & g : all) {
+				ids.push_back(db->strId(g));
+			}
+			std::sort(ids.begin(), ids.end());
+			for(std::size_t i(0); i < ids.size(); ++i) {
+				CPPUNIT_ASSERT_EQUAL(uint32_t(i), ids[i]);
+			}
+			CPPUNIT_ASSERT_EQUAL(PQGramDB::nstr, db->strId(std::string(q+1, 'z')));
+		}
+		for(std::string const & g : all) {
+			CPPUNIT_ASSERT_EQUAL(parallel.strId(g), parallel2.strId(g));
+		}
+	}
+	//A stored id of 0 was taken as missing and the first gram got the id of the last one on reinsertion
+	PQGramDB db(1);
+	db.insert("aba");
+	db.insert("ab");
+	CPPUNIT_ASSERT_EQUAL(uint32_t(0), db.strId("a"));
+	CPPUNIT_ASSERT_EQUAL(uint32_t(1), db.strId("b"));
+	PQGramDB pdb(1);
+	pdb.insert(std::vector<std::string>{"aba", "ab"});
+	CPPUNIT_ASSERT(pdb.strId("a") != pdb.strId("b"));
+	CPPUNIT_ASSERT(pdb.strId("a") < 2 && pdb.strId("b") < 2);
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	srand( 0 );
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::QGramMapTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,318 @@
+#include "TestBase.h"
+#include <srtree/RoaringBitmap.h>
+
+#include <random>
+#include <set>
+#include <algorithm>
+
+namespace srtree::tests {
+
+class RoaringBitmapTest: public TestBase {
+CPPUNIT_TEST_SUITE( RoaringBitmapTest );
+CPPUNIT_TEST( containerTypes );
+CPPUNIT_TEST( typePairs );
+CPPUNIT_TEST( chunkBoundaries );
+CPPUNIT_TEST( randomSets );
+CPPUNIT_TEST_SUITE_END();
+public:
+	static constexpr std::size_t test_count = 5;
+	using Type = RoaringBitmap::ContainerType;
+	using IdSet = std::set<uint32_t>;
+	static constexpr uint32_t chunk_size = uint32_t(1) << 16;
+	///Size of the container count and the header of a single container
+	static constexpr std::size_t single_header_size = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint32_t);
+public:
+	RoaringBitmapTest() {}
+public:
+	void setUp() override;
+public:
+	///Every generator gives the container type it is meant for
+	void containerTypes();
+	///All operations for all pairs of container types with common and without common ids
+	void typePairs();
+	///Ids at the chunk boundaries and runs over whole chunks
+	void chunkBoundaries();
+	///Sets spread over multiple chunks with mixed container types
+	void randomSets();
+private:
+	///Random ids in [begin, end) stored in a container of type @param type, @param parity restricts the ids to even or odd ones
+	IdSet randomContainer(Type type, uint32_t begin, uint32_t end, int parity = -1);
+	///Size of the container of type @param type storing the ids @param ids of a single chunk
+	static std::size_t containerBytes(Type type, IdSet const & ids);
+	///Compare @param rb with @param ids
+	static void check(RoaringBitmap const & rb, IdSet const & ids);
+	///Compare the operations on the bitmaps of @param a and @param b with std::set, the bitmaps themselves are not checked
+	void check(IdSet const & a, IdSet const & b);
+private:
+	std::default_random_engine m_g;
+};
+
+void
+RoaringBitmapTest::setUp() {
+	m_g = std::default_random_engine();
+}
+
+RoaringBitmapTest::IdSet
+RoaringBitmapTest::randomContainer(Type type, uint32_t begin, uint32_t end, int parity) {
+	auto d = std::uniform_int_distribution<uint32_t>(begin, end-1);
+	auto fix = [parity, begin, end](uint32_t id) {
+		if (parity >= 0 && int(id % 2) != parity) {
+			id = id+1 < end ? id+1 : id-1;
+		}
+		return std::max(begin, id);
+	};
+	IdSet result;
+	switch (type) {
+	case Type::ARRAY:
+	{
+		std::size_t count = std::min<std::size_t>(1 + d(m_g) % 2000, (end-begin)/4);
+		while (result.size() < count) {
+			result.insert(fix(d(m_g)));
+		}
+	}
+		break;
+	case Type::BITMAP:
+	{
+		//scattered ids: too many for an array and too many runs
+		std::size_t count = std::min<std::size_t>(6000 + d(m_g) % 6000, (end-begin)/3);
+		while (result.size() < count) {
+			result.insert(fix(d(m_g)));
+		}
+	}
+		break;
+	case Type::RUN:
+	default:
+	{
+		//few long runs
+		auto dlen = std::uniform_int_distribution<uint32_t>(64, 2000);
+		for(uint32_t i(0), s(1 + d(m_g) % 20); i < s; ++i) {
+			uint32_t start = d(m_g);
+			for(uint32_t id(start), runEnd(std::min(end, start+dlen(m_g))); id < runEnd; ++id) {
+				result.insert(id);
+			}
+		}
+	}
+		break;
+	}
+	return result;
+}
+
+std::size_t
+RoaringBitmapTest::containerBytes(Type type, IdSet const & ids) {
+	switch (type) {
+	case Type::ARRAY:
+		return 2*ids.size();
+	case Type::BITMAP:
+		return RoaringBitmap::BitmapWords*sizeof(uint64_t);
+	case Type::RUN:
+	default:
+	{
+		std::size_t runs = 0;
+		for(auto it = ids.begin(); it != ids.end(); ++it) {
+			runs += it == ids.begin() || *std::prev(it)+1 != *it;
+		}
+		return sizeof(uint32_t) + 4*runs;
+	}
+	}
+}
+
+void
+RoaringBitmapTest::check(RoaringBitmap const & rb, IdSet const & ids) {
+	CPPUNIT_ASSERT_EQUAL(ids.size(), rb.size());
+	CPPUNIT_ASSERT_EQUAL(ids.empty(), rb.empty());
+	std::vector<uint32_t> want(ids.begin(), ids.end());
+	CPPUNIT_ASSERT(rb.toVector() == want);
+	//the ids and their neighbours that are not in the set
+	for(std::size_t i(0), s(want.size()); i < s; ++i) {
+		CPPUNIT_ASSERT(rb.contains(want[i]));
+		if (i+1 == s || want[i]+1 != want[i+1]) {
+			//0xFFFFFFFF+1 wraps around to 0
+			uint32_t next = want[i]+1;
+			CPPUNIT_ASSERT_EQUAL(next == 0 && want.front() == 0, rb.contains(next));
+		}
+		if (want[i] && (i == 0 || want[i-1]+1 != want[i])) {
+			CPPUNIT_ASSERT(!rb.contains(want[i]-1));
+		}
+	}
+	//serialization round trip
+	sserialize::UByteArrayAdapter d(sserialize::MM_PROGRAM_MEMORY);
+	d << rb;
+	CPPUNIT_ASSERT_EQUAL(rb.getSizeInBytes(), d.size());
+	RoaringBitmap back(d);
+	CPPUNIT_ASSERT(rb == back);
+	CPPUNIT_ASSERT_EQUAL(rb.getSizeInBytes(), back.getSizeInBytes());
+	CPPUNIT_ASSERT(back.toVector() == want);
+}
+
+void
+RoaringBitmapTest::check(IdSet const & a, IdSet const & b) {
+	IdSet u = a;
+	u.insert(b.begin(), b.end());
+	std::vector<uint32_t> intersection;
+	std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(intersection));
+	bool common = !intersection.empty();
+	RoaringBitmap ra(a.begin(), a.end());
+	RoaringBitmap rb(std::vector<uint32_t>(b.rbegin(), b.rend()));
+	CPPUNIT_ASSERT_EQUAL(common, ra.intersects(rb));
+	CPPUNIT_ASSERT_EQUAL(common, rb.intersects(ra));
+	CPPUNIT_ASSERT_EQUAL(!a.empty(), ra.intersects(ra));
+	RoaringBitmap ru = ra + rb;
+	check(ru, u);
+	CPPUNIT_ASSERT(ru == rb + ra);
+	//equal sets have equal representations
+	CPPUNIT_ASSERT(ru == RoaringBitmap(u.begin(), u.end()));
+	RoaringBitmap tmp = ra;
+	tmp += rb;
+	CPPUNIT_ASSERT(ru == tmp);
+	std::vector<RoaringBitmap> rbs = {ra, RoaringBitmap(), rb, ra};
+	CPPUNIT_ASSERT(ru == RoaringBitmap::unite(rbs.begin(), rbs.end()));
+	//deserialized bitmaps give the same results
+	sserialize::UByteArrayAdapter d(sserialize::MM_PROGRAM_MEMORY);
+	d << rb;
+	CPPUNIT_ASSERT_EQUAL(common, ra.intersects(RoaringBitmap(d)));
+	CPPUNIT_ASSERT(ru == ra + RoaringBitmap(d));
+}
+
+void
+RoaringBitmapTest::containerTypes() {
+	for(Type type : {Type::ARRAY, Type::BITMAP, Type::RUN}) {
+		for(std::size_t i(0); i < test_count; ++i) {
+			uint32_t key = i % 4;
+			IdSet ids = randomContainer(type, key*chunk_size, (key+1)*chunk_size, i%3 == 2 ? -1 : int(i%2));
+			RoaringBitmap rb(ids.begin(), ids.end());
+			check(rb, ids);
+			CPPUNIT_ASSERT_EQUAL(single_header_size + containerBytes(type, ids), std::size_t(rb.getSizeInBytes()));
+			for(Type other : {Type::ARRAY, Type::BITMAP, Type::RUN}) {
+				if (other != type) {
+					CPPUNIT_ASSERT(containerBytes(other, ids) > containerBytes(type, ids));
+				}
+			}
+		}
+	}
+}
+
+void
+RoaringBitmapTest::typePairs() {
+	constexpr uint32_t half = chunk_size/2;
+	for(Type ta : {Type::ARRAY, Type::BITMAP, Type::RUN}) {
+		for(Type tb : {Type::ARRAY, Type::BITMAP, Type::RUN}) {
+			for(std::size_t i(0); i < test_count; ++i) {
+				uint32_t base = (i % 3)*chunk_size;
+				//disjoint halves of a chunk
+				IdSet a = randomContainer(ta, base, base+half);
+				IdSet b = randomContainer(tb, base+half, base+chunk_size);
+				check(RoaringBitmap(a.begin(), a.end()), a);
+				check(RoaringBitmap(b.begin(), b.end()), b);
+				check(a, b);
+				check(b, a);
+				//a single common id: the first, the last or a random one of a or b, i.e. also the first and last of a run
+				auto dpos = std::uniform_int_distribution<std::size_t>(0, std::min(a.size(), b.size())-1);
+				for(IdSet const * x : {&a, &b}) {
+					for(uint32_t common : {*x->begin(), *x->rbegin(), *std::next(x->begin(), dpos(m_g))}) {
+						IdSet a2 = a;
+						IdSet b2 = b;
+						a2.insert(common);
+						b2.insert(common);
+						check(a2, b2);
+					}
+				}
+				//the whole chunk
+				IdSet c = randomContainer(ta, base, base+chunk_size);
+				IdSet d = randomContainer(tb, base, base+chunk_size);
+				check(c, d);
+				//interleaved without common ids
+				if (ta != Type::RUN && tb != Type::RUN) {
+					IdSet even = randomContainer(ta, base, base+chunk_size, 0);
+					IdSet odd = randomContainer(tb, base, base+chunk_size, 1);
+					check(even, odd);
+					check(odd, even);
+				}
+				//different chunks
+				check(a, randomContainer(tb, base+chunk_size, base+2*chunk_size));
+			}
+		}
+	}
+}
+
+void
+RoaringBitmapTest::chunkBoundaries() {
+	std::vector<IdSet> sets;
+	sets.push_back(IdSet{0xFFFF});
+	sets.push_back(IdSet{0x10000});
+	sets.push_back(IdSet{0xFFFF, 0x10000});
+	sets.push_back(IdSet{0, 0xFFFFFFFF});
+	sets.push_back(IdSet{0xFFFFFFFE, 0xFFFFFFFF});
+	sets.push_back(IdSet{0x1FFFF, 0x20000, 0x2FFFF});
+	//a run over a chunk boundary
+	{
+		IdSet ids;
+		for(uint32_t id(0xFF00); id < 0x10100; ++id) {
+			ids.insert(id);
+		}
+		sets.push_back(ids);
+	}
+	//full chunks as a single run of 65536 values, next to one another, at the first and at the last chunk
+	for(uint32_t key : {uint32_t(0), uint32_t(1), uint32_t(3), uint32_t(0xFFFF)}) {
+		IdSet ids;
+		for(uint32_t i(0); i < chunk_size; ++i) {
+			ids.insert(key*chunk_size + i);
+		}
+		RoaringBitmap rb(ids.begin(), ids.end());
+		check(rb, ids);
+		CPPUNIT_ASSERT_EQUAL(single_header_size + containerBytes(Type::RUN, ids), std::size_t(rb.getSizeInBytes()));
+		sets.push_back(ids);
+	}
+	//a full chunk without its first or last id
+	for(uint32_t skip : {uint32_t(0x10000), uint32_t(0x1FFFF)}) {
+		IdSet ids;
+		for(uint32_t id(0x10000); id < 0x20000; ++id) {
+			if (id != skip) {
+				ids.insert(id);
+			}
+		}
+		sets.push_back(ids);
+	}
+	sets.push_back(randomContainer(Type::BITMAP, 0xF000, 0x11000));
+	sets.push_back(randomContainer(Type::ARRAY, 0xFFF0, 0x10010));
+	sets.push_back(IdSet());
+	for(std::size_t i(0), s(sets.size()); i < s; ++i) {
+		check(RoaringBitmap(sets[i].begin(), sets[i].end()), sets[i]);
+		//check(a, b) tests both orders
+		for(std::size_t j(i); j < s; ++j) {
+			check(sets[i], sets[j]);
+		}
+	}
+}
+
+void
+RoaringBitmapTest::randomSets() {
+	auto dkey = std::uniform_int_distribution<uint32_t>(0, 6);
+	auto dtype = std::uniform_int_distribution<int>(0, 3);
+	for(std::size_t i(0); i < 10*test_count; ++i) {
+		IdSet a, b;
+		for(IdSet * x : {&a, &b}) {
+			for(uint32_t j(0), s(dkey(m_g)); j < s; ++j) {
+				uint32_t key = dkey(m_g);
+				int type = dtype(m_g);
+				if (type < 3) {
+					IdSet ids = randomContainer(Type(type), key*chunk_size, (key+1)*chunk_size);
+					x->insert(ids.begin(), ids.end());
+				}
+			}
+		}
+		check(RoaringBitmap(a.begin(), a.end()), a);
+		check(RoaringBitmap(b.begin(), b.end()), b);
+		check(a, b);
+	}
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	srand( 0 );
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::RoaringBitmapTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
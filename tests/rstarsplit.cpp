@@ -0,0 +1,143 @@
+#include "TestBase.h"
+#include <srtree/RStarSplit.h>
+#include <sserialize/spatial/GeoRect.h>
+
+#include <random>
+
+namespace srtree::tests {
+
+class RStarSplitTest: public TestBase {
+CPPUNIT_TEST_SUITE( RStarSplitTest );
+CPPUNIT_TEST( bruteForce );
+CPPUNIT_TEST( minLoad );
+CPPUNIT_TEST( penalty );
+CPPUNIT_TEST_SUITE_END();
+public:
+	static constexpr std::size_t MinLoad = 12;
+	static constexpr std::size_t Count = 33;
+	static constexpr std::size_t test_count = 1000;
+	using Boundary = sserialize::spatial::GeoRect;
+	using Split = srtree::detail::RStarSplit<Boundary, MinLoad, Count>;
+	using Rects = std::array<Boundary, Count>;
+public:
+	RStarSplitTest() {}
+public:
+	void setUp() override;
+public:
+	void bruteForce();
+	void minLoad();
+	void penalty();
+private:
+	///Recomputes the bounds of both groups for every distribution
+	static Split::Result bruteForceSplit(Rects const & rects);
+private:
+	std::vector<Rects> m_rects;
+};
+
+void
+RStarSplitTest::setUp() {
+	auto dlat = std::uniform_real_distribution<double>(-80, 80);
+	auto dlon = std::uniform_real_distribution<double>(-170, 170);
+	auto dsize = std::uniform_real_distribution<double>(0, 5);
+	auto g = std::default_random_engine();
+	m_rects.resize(test_count);
+	for(Rects & rects : m_rects) {
+		for(Boundary & b : rects) {
+			double lat = dlat(g);
+			double lon = dlon(g);
+			b = Boundary(lat, lat+dsize(g), lon, lon+dsize(g));
+		}
+	}
+}
+
+RStarSplitTest::Split::Result
+RStarSplitTest::bruteForceSplit(Rects const & rects) {
+	auto boundary = [&rects](std::size_t i) -> Boundary const & { return rects[i]; };
+	auto minValue = [&rects](Split::Order const & order, auto quantity, auto initial) {
+		std::size_t minValuePosition = MinLoad;
+		for(std::size_t i(MinLoad); Count-i >= MinLoad; ++i) {
+			Boundary fg, sg;
+			for(std::size_t j(0); j < Count; ++j) {
+				(j < i ? fg : sg).enlarge(rects[order[j]]);
+			}
+			auto q = quantity(fg, sg);
+			if (q < initial) {
+				initial = q;
+				minValuePosition = i;
+			}
+		}
+		return std::make_pair(initial, minValuePosition);
+	};
+	auto corners = Split::sortOrders(boundary);
+	std::size_t m = 0;
+	double bestMargin = std::numeric_limits<double>::max();
+	for(std::size_t k(0); k < 4; ++k) {
+		double km = minValue(corners[k], &Split::margin, std::numeric_limits<double>::max()).first;
+		if (km < bestMargin) {
+			bestMargin = km;
+			m = k;
+		}
+	}
+	auto splitIndex = minValue(corners[m], &Split::overlapArea, Split::OverlapArea());
+	return Split::Result{corners[m], splitIndex.second};
+}
+
+void
+RStarSplitTest::bruteForce() {
+	Split split;
+	for(Rects const & rects : m_rects) {
+		Split::Result r = split([&rects](std::size_t i) -> Boundary const & { return rects[i]; });
+		Split::Result bf = bruteForceSplit(rects);
+		CPPUNIT_ASSERT_EQUAL(bf.splitPosition, r.splitPosition);
+		CPPUNIT_ASSERT(bf.order == r.order);
+	}
+}
+
+void
+RStarSplitTest::minLoad() {
+	Split split;
+	for(Rects const & rects : m_rects) {
+		Split::Result r = split([&rects](std::size_t i) -> Boundary const & { return rects[i]; });
+		CPPUNIT_ASSERT_GREATEREQUAL(MinLoad, r.splitPosition);
+		CPPUNIT_ASSERT_GREATEREQUAL(MinLoad, Count-r.splitPosition);
+		std::vector<bool> seen(Count, false);
+		for(std::size_t x : r.order) {
+			CPPUNIT_ASSERT(x < Count);
+			CPPUNIT_ASSERT(!seen[x]);
+			seen[x] = true;
+		}
+	}
+}
+
+void
+RStarSplitTest::penalty() {
+	Split split;
+	std::size_t pos = MinLoad+1;
+	auto penalty = [pos](Split::Order const &) {
+		std::array<double, Count> result;
+		for(std::size_t i(0); i < Count; ++i) {
+			result[i] = i == pos ? 0 : 1;
+		}
+		return result;
+	};
+	for(Rects const & rects : m_rects) {
+		auto boundary = [&rects](std::size_t i) -> Boundary const & { return rects[i]; };
+		Split::Result r = split(boundary);
+		Split::Result r0 = split(boundary, penalty, 0);
+		Split::Result r1 = split(boundary, penalty, 1);
+		CPPUNIT_ASSERT_EQUAL(r.splitPosition, r0.splitPosition);
+		CPPUNIT_ASSERT(r.order == r0.order);
+		CPPUNIT_ASSERT(r.order == r1.order);
+		CPPUNIT_ASSERT_EQUAL(pos, r1.splitPosition);
+	}
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::RStarSplitTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
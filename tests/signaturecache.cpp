@@ -0,0 +1,166 @@
+#include "TestBase.h"
+#include <srtree/SignatureCache.h>
+
+#include <random>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+
+namespace srtree::tests {
+
+class SignatureCacheTest: public TestBase {
+CPPUNIT_TEST_SUITE( SignatureCacheTest );
+CPPUNIT_TEST( underCapacity );
+CPPUNIT_TEST( eviction );
+CPPUNIT_TEST( disabled );
+CPPUNIT_TEST( concurrent );
+CPPUNIT_TEST_SUITE_END();
+public:
+	static constexpr std::size_t call_count = 200000;
+	static constexpr uint32_t key_count = 5000;
+	using Signature = uint64_t;
+	using Cache = srtree::SignatureCache<Signature>;
+public:
+	SignatureCacheTest() {}
+public:
+	void setUp() override;
+public:
+	///Every key is computed once if the cache never evicts
+	void underCapacity();
+	///Entries are evicted once the shards are full
+	void eviction();
+	///A budget of 0 gives a single shard without capacity
+	void disabled();
+	void concurrent();
+private:
+	static Signature signature(Cache::key_type k) { return k*0x9E3779B97F4A7C15ull + 1; }
+	///Memory budget of a cache with @param entries entries
+	static std::size_t budget(std::size_t entries) { return entries*(sizeof(Signature) + Cache::EntryOverhead); }
+	///Run all keys through @param cache, @return the number of computations per key
+	std::map<Cache::key_type, std::size_t> run(Cache & cache);
+private:
+	///skewed stream of keys: few keys occur very often, many rarely like key:value pairs in OSM
+	std::vector<Cache::key_type> m_keys;
+	std::set<Cache::key_type> m_distinct;
+};
+
+void
+SignatureCacheTest::setUp() {
+	auto d = std::uniform_real_distribution<double>(0, 1);
+	auto g = std::default_random_engine();
+	m_keys.clear();
+	m_distinct.clear();
+	for(std::size_t i(0); i < call_count; ++i) {
+		double u = d(g);
+		uint32_t id = uint32_t(key_count*u*u*u);
+		m_keys.push_back(Cache::key(id % 97, id));
+		m_distinct.insert(m_keys.back());
+	}
+}
+
+std::map<SignatureCacheTest::Cache::key_type, std::size_t>
+SignatureCacheTest::run(Cache & cache) {
+	std::map<Cache::key_type, std::size_t> computed;
+	for(Cache::key_type k : m_keys) {
+		Signature sig = cache.get(k, [&computed, k]() {
+			++computed[k];
+			return signature(k);
+		});
+		CPPUNIT_ASSERT_EQUAL(signature(k), sig);
+	}
+	return computed;
+}
+
+void
+SignatureCacheTest::underCapacity() {
+	//every shard has room for all keys
+	Cache cache(budget(Cache::DefaultShardCount*key_count));
+	std::map<Cache::key_type, std::size_t> computed = run(cache);
+	CPPUNIT_ASSERT_EQUAL(m_distinct.size(), computed.size());
+	for(auto const & x : computed) {
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), x.second);
+	}
+	Cache::Stats stats = cache.stats();
+	CPPUNIT_ASSERT_EQUAL(uint64_t(call_count), stats.hits + stats.misses);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(m_distinct.size()), stats.misses);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.evictions);
+	CPPUNIT_ASSERT_EQUAL(m_distinct.size(), stats.size);
+}
+
+void
+SignatureCacheTest::eviction() {
+	for(std::size_t entries : {std::size_t(1), std::size_t(63), std::size_t(64), std::size_t(500), std::size_t(2000)}) {
+		Cache cache(budget(entries));
+		std::map<Cache::key_type, std::size_t> computed = run(cache);
+		Cache::Stats stats = cache.stats();
+		std::size_t computations = 0;
+		for(auto const & x : computed) {
+			computations += x.second;
+		}
+		CPPUNIT_ASSERT(stats.capacity <= entries);
+		CPPUNIT_ASSERT(stats.capacity > 0);
+		CPPUNIT_ASSERT_EQUAL(stats.capacity, stats.size);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(call_count), stats.hits + stats.misses);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(computations), stats.misses);
+		//every miss either fills a free slot or evicts an entry
+		CPPUNIT_ASSERT_EQUAL(stats.misses - stats.size, stats.evictions);
+		CPPUNIT_ASSERT(stats.evictions > 0);
+		CPPUNIT_ASSERT(stats.hits > 0);
+	}
+}
+
+void
+SignatureCacheTest::disabled() {
+	Cache cache(0);
+	std::map<Cache::key_type, std::size_t> computed = run(cache);
+	std::size_t computations = 0;
+	for(auto const & x : computed) {
+		computations += x.second;
+	}
+	Cache::Stats stats = cache.stats();
+	CPPUNIT_ASSERT_EQUAL(call_count, computations);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.hits);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(call_count), stats.misses);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.evictions);
+	CPPUNIT_ASSERT_EQUAL(std::size_t(0), stats.size);
+	CPPUNIT_ASSERT_EQUAL(std::size_t(0), stats.capacity);
+}
+
+void
+SignatureCacheTest::concurrent() {
+	constexpr std::size_t threadCount = 4;
+	for(std::size_t entries : {std::size_t(0), std::size_t(500), Cache::DefaultShardCount*key_count}) {
+		Cache cache(budget(entries));
+		std::atomic<bool> ok(true);
+		std::vector<std::thread> threads;
+		for(std::size_t t(0); t < threadCount; ++t) {
+			threads.emplace_back([this, &cache, &ok, t]() {
+				for(std::size_t i(t); i < m_keys.size(); i += threadCount) {
+					Cache::key_type k = m_keys[i];
+					if (cache.get(k, [k]() { return signature(k); }) != signature(k)) {
+						ok = false;
+					}
+				}
+			});
+		}
+		for(std::thread & t : threads) {
+			t.join();
+		}
+		Cache::Stats stats = cache.stats();
+		CPPUNIT_ASSERT(ok);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(call_count), stats.hits + stats.misses);
+		CPPUNIT_ASSERT(stats.size <= stats.capacity);
+	}
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	srand( 0 );
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::SignatureCacheTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
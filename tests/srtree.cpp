@@ -0,0 +1,310 @@
+#include "TestBase.h"
+#include <srtree/SRTree.h>
+#include <srtree/GeoRectGeometryTraits.h>
+#include <srtree/DedupSerializationTraitsAdapter.h>
+
+#include <random>
+#include <set>
+#include <map>
+
+namespace srtree::tests {
+
+///Signatures are sets of up to 64 tokens stored as bit masks.
+///Combine is exact, hence a node matches iff one of the items in its subtree may match.
+class BitSetSignatureTraits {
+public:
+	using Signature = uint64_t;
+	using StaticTraits = BitSetSignatureTraits;
+	struct Serializer {
+		using Type = Signature;
+		inline sserialize::UByteArrayAdapter & operator()(sserialize::UByteArrayAdapter & dest, Signature v) const {
+			dest.put<uint64_t>(v);
+			return dest;
+		}
+	};
+	struct Combine {
+		inline Signature operator()(Signature first, Signature second) const {
+			return first | second;
+		}
+		template<typename Iterator>
+		Signature operator()(Iterator begin, Iterator end) const {
+			Signature result = 0;
+			for(; begin != end; ++begin) {
+				result |= *begin;
+			}
+			return result;
+		}
+	};
+	struct Enlargement {
+		inline double operator()(Signature base, Signature toAdd) const {
+			auto us = sserialize::popCount(base | toAdd);
+			return us ? double(us - sserialize::popCount(base))/us : 0;
+		}
+	};
+	///Matches signatures containing all tokens of the reference
+	class MayHaveMatch {
+	public:
+		MayHaveMatch(Signature ref) : m_ref(ref) {}
+		inline bool operator()(Signature v) const { return (v & m_ref) == m_ref; }
+	private:
+		Signature m_ref;
+	};
+public:
+	virtual ~BitSetSignatureTraits() {}
+public:
+	inline Combine combine() const { return Combine(); }
+	inline Enlargement enlargement() const { return Enlargement(); }
+	inline MayHaveMatch mayHaveMatch(Signature ref) const { return MayHaveMatch(ref); }
+	inline Serializer serializer() const { return Serializer(); }
+};
+
+inline sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, BitSetSignatureTraits const &) {
+	dest << uint8_t(1);
+	return dest;
+}
+
+class SRTreeTest: public TestBase {
+CPPUNIT_TEST_SUITE( SRTreeTest );
+CPPUNIT_TEST( erase );
+CPPUNIT_TEST( eraseAll );
+CPPUNIT_TEST( update );
+CPPUNIT_TEST( dedupSerialization );
+CPPUNIT_TEST_SUITE_END();
+public:
+	static constexpr std::size_t item_count = 5000;
+	static constexpr std::size_t query_count = 200;
+	using Tree = srtree::SRTree<BitSetSignatureTraits, srtree::detail::GeoRectGeometryTraits, 4, 10>;
+	using DedupTree = srtree::SRTree<srtree::detail::DedupSerializationTraitsAdapter<BitSetSignatureTraits>, srtree::detail::GeoRectGeometryTraits, 4, 10>;
+	using Boundary = Tree::Boundary;
+	using Signature = Tree::Signature;
+	using ItemType = Tree::ItemType;
+	enum class Mode {
+		PLAIN, ///no incremental signatures, they are recalculated before signature queries
+		INCREMENTAL, ///incremental signatures
+		WEIGHTED ///incremental signatures used by the insertion heuristics
+	};
+public:
+	SRTreeTest() {}
+public:
+	void setUp() override;
+public:
+	void erase();
+	void eraseAll();
+	void update();
+	///The serialized tree and signature store have to be independent of the number of threads
+	void dedupSerialization();
+private:
+	struct Entry {
+		Boundary boundary;
+		Signature signature;
+		Tree::ItemNode const * node;
+	};
+	using Entries = std::map<ItemType, Entry>;
+private:
+	void init(Tree & tree, Mode mode, Entries & entries);
+	///Compare the results of queries with the matching @param entries
+	void check(Tree & tree, Mode mode, Entries const & entries);
+	Boundary randomBoundary(double maxSize);
+	Signature randomSignature();
+private:
+	std::default_random_engine m_g;
+	std::vector<Boundary> m_queries;
+};
+
+void
+SRTreeTest::setUp() {
+	m_g = std::default_random_engine();
+	m_queries.clear();
+	for(std::size_t i(0); i < query_count; ++i) {
+		m_queries.push_back(randomBoundary(40));
+	}
+}
+
+SRTreeTest::Boundary
+SRTreeTest::randomBoundary(double maxSize) {
+	auto dlat = std::uniform_real_distribution<double>(-80, 80);
+	auto dlon = std::uniform_real_distribution<double>(-170, 170);
+	auto dsize = std::uniform_real_distribution<double>(0, maxSize);
+	double lat = dlat(m_g);
+	double lon = dlon(m_g);
+	return Boundary(lat, lat+dsize(m_g), lon, lon+dsize(m_g));
+}
+
+SRTreeTest::Signature
+SRTreeTest::randomSignature() {
+	auto dbit = std::uniform_int_distribution<uint32_t>(0, 63);
+	Signature result = 0;
+	for(uint32_t i(0), s(1+dbit(m_g)%4); i < s; ++i) {
+		result |= Signature(1) << dbit(m_g);
+	}
+	return result;
+}
+
+void
+SRTreeTest::init(Tree & tree, Mode mode, Entries & entries) {
+	if (mode == Mode::INCREMENTAL) {
+		tree.setIncrementalSignatures(true);
+	}
+	else if (mode == Mode::WEIGHTED) {
+		tree.setSignatureWeight(0.5);
+		CPPUNIT_ASSERT(tree.incrementalSignatures());
+	}
+	for(ItemType i(0); i < item_count; ++i) {
+		Entry e{randomBoundary(2), randomSignature(), 0};
+		e.node = tree.insert(e.boundary, e.signature, i);
+		entries[i] = e;
+	}
+	CPPUNIT_ASSERT(tree.checkConsistency());
+}
+
+void
+SRTreeTest::check(Tree & tree, Mode mode, Entries const & entries) {
+	CPPUNIT_ASSERT(tree.checkConsistency());
+	if (mode == Mode::PLAIN) {
+		tree.recalculateSignatures(1);
+	}
+	auto dbit = std::uniform_int_distribution<uint32_t>(0, 63);
+	TraversalStatistics stats;
+	for(Boundary const & q : m_queries) {
+		Signature qsig = Signature(1) << dbit(m_g);
+		std::set<ItemType> want, wantSig;
+		for(auto const & x : entries) {
+			if (q.intersects(x.second.boundary)) {
+				want.insert(x.first);
+				if (x.second.signature & qsig) {
+					wantSig.insert(x.first);
+				}
+			}
+		}
+		std::vector<ItemType> got, gotSig, gotAdaptive;
+		tree.find(tree.gtraits().mayHaveMatch(q), std::back_inserter(got));
+		tree.find(tree.gtraits().mayHaveMatch(q), tree.straits().mayHaveMatch(qsig), std::back_inserter(gotSig));
+		tree.find(tree.gtraits().mayHaveMatch(q), tree.straits().mayHaveMatch(qsig), std::back_inserter(gotAdaptive), stats);
+		CPPUNIT_ASSERT_EQUAL(want.size(), got.size());
+		CPPUNIT_ASSERT(want == std::set<ItemType>(got.begin(), got.end()));
+		CPPUNIT_ASSERT_EQUAL(wantSig.size(), gotSig.size());
+		CPPUNIT_ASSERT(wantSig == std::set<ItemType>(gotSig.begin(), gotSig.end()));
+		//signatures are exact, skipping the signature test of internal nodes does not change the result
+		CPPUNIT_ASSERT_EQUAL(wantSig.size(), gotAdaptive.size());
+		CPPUNIT_ASSERT(wantSig == std::set<ItemType>(gotAdaptive.begin(), gotAdaptive.end()));
+	}
+}
+
+void
+SRTreeTest::erase() {
+	for(Mode mode : {Mode::PLAIN, Mode::INCREMENTAL, Mode::WEIGHTED}) {
+		Tree tree;
+		Entries entries;
+		init(tree, mode, entries);
+		auto dcoin = std::uniform_int_distribution<uint32_t>(0, 2);
+		for(ItemType i(0); i < item_count; ++i) {
+			uint32_t coin = dcoin(m_g);
+			if (coin == 0) {
+				CPPUNIT_ASSERT(tree.erase(entries.at(i).node));
+				entries.erase(i);
+			}
+			else if (coin == 1) {
+				Entry const & e = entries.at(i);
+				CPPUNIT_ASSERT(tree.erase(e.boundary, i));
+				CPPUNIT_ASSERT(!tree.erase(e.boundary, i));
+				entries.erase(i);
+			}
+		}
+		//pointers to the remaining item nodes stay valid
+		for(auto const & x : entries) {
+			CPPUNIT_ASSERT_EQUAL(x.first, x.second.node->item());
+		}
+		check(tree, mode, entries);
+	}
+}
+
+void
+SRTreeTest::eraseAll() {
+	for(Mode mode : {Mode::PLAIN, Mode::INCREMENTAL, Mode::WEIGHTED}) {
+		Tree tree;
+		Entries entries;
+		init(tree, mode, entries);
+		std::vector<ItemType> order;
+		for(auto const & x : entries) {
+			order.push_back(x.first);
+		}
+		std::shuffle(order.begin(), order.end(), m_g);
+		for(std::size_t i(0), s(order.size()); i < s; ++i) {
+			CPPUNIT_ASSERT(tree.erase(entries.at(order[i]).node));
+			entries.erase(order[i]);
+			if (i % 500 == 0) {
+				check(tree, mode, entries);
+			}
+		}
+		check(tree, mode, entries);
+		//the empty tree is usable again
+		Entry e{randomBoundary(2), randomSignature(), 0};
+		e.node = tree.insert(e.boundary, e.signature, 0);
+		entries[0] = e;
+		check(tree, mode, entries);
+	}
+}
+
+void
+SRTreeTest::update() {
+	for(Mode mode : {Mode::PLAIN, Mode::INCREMENTAL, Mode::WEIGHTED}) {
+		Tree tree;
+		Entries entries;
+		init(tree, mode, entries);
+		auto dcoin = std::uniform_int_distribution<uint32_t>(0, 2);
+		for(ItemType i(0); i < item_count; ++i) {
+			uint32_t coin = dcoin(m_g);
+			Entry & e = entries.at(i);
+			if (coin == 0) { //signature only
+				e.signature = randomSignature();
+				Tree::ItemNode const * in = tree.update(e.node, e.boundary, e.signature);
+				CPPUNIT_ASSERT_EQUAL((void const*) e.node, (void const*) in);
+			}
+			else if (coin == 1) { //moved
+				e.boundary = randomBoundary(2);
+				e.signature = randomSignature();
+				e.node = tree.update(e.node, e.boundary, e.signature);
+			}
+			CPPUNIT_ASSERT_EQUAL(i, e.node->item());
+		}
+		check(tree, mode, entries);
+	}
+}
+
+void
+SRTreeTest::dedupSerialization() {
+	std::vector<std::pair<Boundary, Signature>> data;
+	for(std::size_t i(0); i < item_count; ++i) {
+		data.emplace_back(randomBoundary(2), randomSignature());
+	}
+	auto serialize = [&data](uint32_t numThreads) {
+		DedupTree tree;
+		for(std::size_t i(0), s(data.size()); i < s; ++i) {
+			tree.insert(data[i].first, data[i].second, ItemType(i));
+		}
+		tree.recalculateSignatures(numThreads);
+		sserialize::UByteArrayAdapter dest(sserialize::MM_PROGRAM_MEMORY);
+		tree.serialize(dest, numThreads);
+		dest << tree.straits();
+		return dest;
+	};
+	sserialize::UByteArrayAdapter ref = serialize(1);
+	for(uint32_t numThreads : {2, 4, 7}) {
+		sserialize::UByteArrayAdapter d = serialize(numThreads);
+		CPPUNIT_ASSERT_EQUAL(ref.size(), d.size());
+		for(sserialize::UByteArrayAdapter::SizeType i(0), s(ref.size()); i < s; ++i) {
+			CPPUNIT_ASSERT_EQUAL(ref.at(i), d.at(i));
+		}
+	}
+}
+
+} // end namespace srtree::tests
+
+int main(int argc, char ** argv) {
+	srtree::tests::TestBase::init(argc, argv);
+	srand( 0 );
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  srtree::tests::SRTreeTest::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}